@@ -0,0 +1,144 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/un.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "binary-protocol.h"
+
+// Binary ingest load generator, counterpart of http-load-bench.
+// Every connection runs in its own thread and sends depth call frames
+// with one write, then reads depth replies. Phone numbers are unique.
+// Usage: binary-load-bench unix:/path|host:port [connections] [depth]
+//        [seconds]
+
+namespace{
+
+std::atomic<bool> stop{false};
+std::atomic<size_t> nReplies{0};
+std::atomic<size_t> nErrors{0};
+
+int connectTo(const std::string & address){
+    static const std::string unixPrefix = "unix:";
+    int fd;
+    if (address.compare(0, unixPrefix.size(), unixPrefix) == 0){
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        address.copy(addr.sun_path, sizeof(addr.sun_path) - 1,
+                     unixPrefix.size());
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd >= 0 &&
+            connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0){
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+    auto colon = address.rfind(':');
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(atoi(address.c_str() + colon + 1));
+    if (colon == std::string::npos ||
+        inet_pton(AF_INET, address.substr(0, colon).c_str(),
+                  &addr.sin_addr) != 1)
+        return -1;
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+    int yes = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+    if (connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0){
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void runConnection(const std::string & address, const size_t id,
+                   const size_t depth){
+    int fd = connectTo(address);
+    if (fd < 0){
+        ++nErrors;
+        return;
+    }
+    std::vector<char> out(depth * binproto::maxCallSize);
+    std::vector<char> in(depth * binproto::replySize);
+    uint64_t requestId = 0;
+    while (!stop){
+        auto end = out.data();
+        const auto firstRequestId = requestId;
+        for (size_t i = 0; i < depth; ++i){
+            auto phoneNumber = std::to_string(id * 1000000000000ull +
+                                              requestId);
+            binproto::Call call;
+            call.requestId = requestId++;
+            call.phoneNumber = phoneNumber;
+            end = binproto::writeCall(end, call);
+        }
+        const size_t size = end - out.data();
+        if (write(fd, out.data(), size) != static_cast<ssize_t>(size)){
+            ++nErrors;
+            break;
+        }
+        size_t received = 0;
+        while (received < in.size()){
+            auto n = read(fd, in.data() + received, in.size() - received);
+            if (n <= 0)
+                break;
+            received += n;
+        }
+        if (received < in.size()){
+            ++nErrors;
+            break;
+        }
+        for (size_t i = 0; i < depth; ++i){
+            binproto::Reply reply;
+            if (binproto::parseReply(in.data() + i * binproto::replySize,
+                                     binproto::replySize, reply) !=
+                    binproto::ParseResult::ok ||
+                reply.requestId != firstRequestId + i)
+                ++nErrors;
+        }
+        nReplies += depth;
+    }
+    close(fd);
+}
+
+};
+
+int main(int argc, char * argv[]){
+    if (argc < 2){
+        fprintf(stderr, "Usage: %s unix:/path|host:port [connections] "
+                        "[depth] [seconds]\n", argv[0]);
+        return 1;
+    }
+    const std::string address = argv[1];
+    const size_t nConnections = argc > 2 ? atol(argv[2]) : 16;
+    const size_t depth = argc > 3 ? atol(argv[3]) : 1;
+    const size_t seconds = argc > 4 ? atol(argv[4]) : 5;
+
+    std::vector<std::thread> threads;
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < nConnections; ++i)
+        threads.emplace_back(runConnection, std::cref(address), i + 1, depth);
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    stop = true;
+    for (auto & th : threads)
+        th.join();
+    auto end = std::chrono::steady_clock::now();
+
+    const double elapsed = std::chrono::duration<double>(end - begin).count();
+    printf("connections: %zu, depth: %zu\n", nConnections, depth);
+    printf("replies: %zu, errors: %zu\n", nReplies.load(), nErrors.load());
+    printf("%.0f calls/s\n", nReplies / elapsed);
+    return 0;
+}
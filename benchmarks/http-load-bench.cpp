@@ -0,0 +1,142 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+// GET /call load generator.
+// Every connection runs in its own thread and sends depth pipelined
+// requests, then reads depth answers. Phone numbers are unique, so
+// answers are ok or overload depending on call center queue size.
+// Non 200 answers are counted as errors.
+// Usage: http-load-bench host port [connections] [depth] [seconds]
+
+namespace{
+
+std::atomic<bool> stop{false};
+std::atomic<size_t> nAnswers{0};
+std::atomic<size_t> nErrors{0};
+std::atomic<size_t> nConnects{0};
+
+int connectTo(const char * host, const int port){
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, host, &addr.sin_addr) != 1)
+        return -1;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+    int yes = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+    if (connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0){
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Reads up to n answers, returns number of answers read.
+// Less than n means connection is closed
+size_t readAnswers(const int fd, const size_t n, std::string & in){
+    in.clear();
+    size_t begin = 0;
+    size_t nRead = 0;
+    char buffer[65536];
+    while (nRead < n){
+        auto headerEnd = in.find("\r\n\r\n", begin);
+        if (headerEnd != std::string::npos){
+            auto length = in.find("Content-Length: ", begin);
+            if (length == std::string::npos || length > headerEnd)
+                break;
+            size_t end = headerEnd + 4 + atol(in.c_str() + length + 16);
+            if (in.size() >= end){
+                if (in.compare(begin, 12, "HTTP/1.1 200") != 0)
+                    ++nErrors;
+                begin = end;
+                ++nRead;
+                continue;
+            }
+        }
+        auto r = read(fd, buffer, sizeof(buffer));
+        if (r <= 0)
+            break;
+        in.append(buffer, r);
+    }
+    return nRead;
+}
+
+// Reconnects when server closes connection (httplib closes
+// keep-alive connection after a few requests)
+void runConnection(const char * host, const int port, const size_t id,
+                   const size_t depth){
+    std::string out, in;
+    size_t nCall = 0;
+    int fd = -1;
+    while (!stop){
+        if (fd < 0){
+            fd = connectTo(host, port);
+            if (fd < 0){
+                ++nErrors;
+                return;
+            }
+            ++nConnects;
+        }
+        out.clear();
+        for (size_t i = 0; i < depth; ++i){
+            out += "GET /call?phone_number=";
+            out += std::to_string(id * 1000000000000ull + nCall++);
+            out += " HTTP/1.1\r\nHost: bench\r\n\r\n";
+        }
+        const bool sent = send(fd, out.data(), out.size(), MSG_NOSIGNAL) ==
+            static_cast<ssize_t>(out.size());
+        const size_t nRead = sent ? readAnswers(fd, depth, in) : 0;
+        nAnswers += nRead;
+        if (nRead < depth){
+            close(fd);
+            fd = -1;
+        }
+    }
+    if (fd >= 0)
+        close(fd);
+}
+
+};
+
+int main(int argc, char * argv[]){
+    if (argc < 3){
+        fprintf(stderr, "Usage: %s host port [connections] [depth] "
+                        "[seconds]\n", argv[0]);
+        return 1;
+    }
+    const char * host = argv[1];
+    const int port = atoi(argv[2]);
+    const size_t nConnections = argc > 3 ? atol(argv[3]) : 16;
+    const size_t depth = argc > 4 ? atol(argv[4]) : 1;
+    const size_t seconds = argc > 5 ? atol(argv[5]) : 5;
+
+    std::vector<std::thread> threads;
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < nConnections; ++i)
+        threads.emplace_back(runConnection, host, port, i + 1, depth);
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    stop = true;
+    for (auto & th : threads)
+        th.join();
+    auto end = std::chrono::steady_clock::now();
+
+    const double elapsed = std::chrono::duration<double>(end - begin).count();
+    printf("connections: %zu, depth: %zu\n", nConnections, depth);
+    printf("answers: %zu, errors: %zu, connects: %zu\n", nAnswers.load(),
+           nErrors.load(), nConnects.load());
+    printf("%.0f requests/s\n", nAnswers / elapsed);
+    return 0;
+}
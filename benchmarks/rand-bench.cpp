@@ -0,0 +1,66 @@
+#include <time.h>
+#include <stdio.h>
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "rand-generator.h"
+
+// Compares call duration generation: generator constructed on every
+// call (as it was), reused std::mt19937, xoshiro256** and batch fill
+template <typename F>
+double measure(const size_t n, F f){
+    auto begin = std::chrono::steady_clock::now();
+    uint64_t sum = f(n);
+    auto end = std::chrono::steady_clock::now();
+    // Keeps result alive
+    if (sum == 0)
+        printf("zero\n");
+    return std::chrono::duration<double, std::nano>(end - begin).count() / n;
+}
+
+int main(){
+    const size_t n = 20000000;
+    const uint32_t min = 60;
+    const uint32_t max = 300;
+    rndgen::setSeed(1);
+
+    auto perCall = measure(n / 100, [&](size_t n){
+        uint64_t sum = 0;
+        for (size_t i = 0; i < n; ++i){
+            std::mt19937 gen(time(NULL));
+            std::uniform_int_distribution<size_t> dis(min, max);
+            sum += dis(gen);
+        }
+        return sum;
+    });
+    auto mt = measure(n, [&](size_t n){
+        std::mt19937 gen(1);
+        std::uniform_int_distribution<size_t> dis(min, max);
+        uint64_t sum = 0;
+        for (size_t i = 0; i < n; ++i)
+            sum += dis(gen);
+        return sum;
+    });
+    auto scalar = measure(n, [&](size_t n){
+        uint64_t sum = 0;
+        for (size_t i = 0; i < n; ++i)
+            sum += rndgen::uniform(min, max);
+        return sum;
+    });
+    auto batch = measure(n, [&](size_t n){
+        std::vector<uint32_t> buffer(1024);
+        uint64_t sum = 0;
+        for (size_t done = 0; done < n; done += buffer.size()){
+            rndgen::fillUniform(min, max, buffer.data(), buffer.size());
+            sum += buffer[done % buffer.size()];
+        }
+        return sum;
+    });
+    printf("mt19937 per call:   %8.2f ns/sample\n", perCall);
+    printf("mt19937 reused:     %8.2f ns/sample\n", mt);
+    printf("xoshiro256** :      %8.2f ns/sample\n", scalar);
+    printf("xoshiro256** batch: %8.2f ns/sample\n", batch);
+    return 0;
+}
@@ -0,0 +1,44 @@
+#include <stdio.h>
+
+#include <chrono>
+#include <string>
+
+#include "json.hpp"
+
+#include "cdr.h"
+#include "response-writer.h"
+
+using namespace cdr;
+
+// Compares /call answer formatting: nlohmann::json vs response writer
+template <typename F>
+double measure(const size_t n, F f){
+    auto begin = std::chrono::steady_clock::now();
+    size_t size = 0;
+    for (size_t i = 0; i < n; ++i)
+        size += f(370405383979663360 + i, static_cast<CallStatus>(i % 3));
+    auto end = std::chrono::steady_clock::now();
+    // Keeps result alive
+    if (size == 0)
+        printf("empty\n");
+    return std::chrono::duration<double, std::nano>(end - begin).count() / n;
+}
+
+int main(){
+    const size_t n = 2000000;
+    auto json = measure(n, [](uint64_t callId, CallStatus callStatus){
+        nlohmann::json ans;
+        ans["call_id"] = callId;
+        ans["call_status"] = toString(callStatus);
+        std::string body;
+        body.append(ans.dump());
+        return body.size();
+    });
+    auto writer = measure(n, [](uint64_t callId, CallStatus callStatus){
+        return response::writeCallAnswer(callId, callStatus).size();
+    });
+    printf("nlohmann::json:  %8.1f ns/answer\n", json);
+    printf("response writer: %8.1f ns/answer\n", writer);
+    printf("speedup:         %8.1fx\n", json / writer);
+    return 0;
+}
@@ -0,0 +1,146 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#include <map>
+#include <array>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+
+// Replays SIP INVITE datagrams to SIP ingress and counts responses.
+// INVITE template is read from file or built in. Placeholders {number}
+// (From user) and {n} (Call-ID, branch) are replaced by INVITE number,
+// so every INVITE is a call from a new phone number.
+// INVITEs are sent with sendmmsg in batches keeping at most window
+// INVITEs without response, responses are received with recvmmsg.
+// Usage: sip-replay-bench host port [invites] [window] [template file]
+
+namespace{
+
+constexpr size_t batchSize = 64;
+constexpr size_t maxDatagramSize = 4096;
+
+const std::string defaultTemplate =
+    "INVITE sip:operator@call-center SIP/2.0\r\n"
+    "Via: SIP/2.0/UDP 127.0.0.1:5070;branch=z9hG4bK{n}\r\n"
+    "Max-Forwards: 70\r\n"
+    "From: <sip:{number}@127.0.0.1>;tag={n}\r\n"
+    "To: <sip:operator@call-center>\r\n"
+    "Call-ID: {n}@127.0.0.1\r\n"
+    "CSeq: 1 INVITE\r\n"
+    "Contact: <sip:{number}@127.0.0.1:5070>\r\n"
+    "Content-Length: 0\r\n"
+    "\r\n";
+
+void replace(std::string & s, const std::string & from, const std::string & to){
+    for (auto pos = s.find(from); pos != std::string::npos;
+         pos = s.find(from, pos + to.size()))
+        s.replace(pos, from.size(), to);
+}
+
+};
+
+int main(int argc, char * argv[]){
+    if (argc < 3){
+        fprintf(stderr, "Usage: %s host port [invites] [window] "
+                        "[template file]\n", argv[0]);
+        return 1;
+    }
+    const size_t nInvites = argc > 3 ? atol(argv[3]) : 100000;
+    const size_t window = argc > 4 ? atol(argv[4]) : 256;
+    std::string invite = defaultTemplate;
+    if (argc > 5){
+        std::ifstream f(argv[5], std::ios::binary);
+        std::stringstream ss;
+        ss << f.rdbuf();
+        invite = ss.str();
+    }
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(atoi(argv[2]));
+    if (inet_pton(AF_INET, argv[1], &addr.sin_addr) != 1){
+        fprintf(stderr, "Invalid host\n");
+        return 1;
+    }
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0 ||
+        connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0){
+        fprintf(stderr, "Can't connect\n");
+        return 1;
+    }
+    int bufferSize = 4 << 20;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+    // Lost responses end the replay after this timeout
+    timeval timeout{1, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    std::vector<std::string> out(batchSize);
+    std::array<iovec, batchSize> outIov;
+    std::array<mmsghdr, batchSize> outMsgs{};
+    std::vector<char> in(batchSize * maxDatagramSize);
+    std::array<iovec, batchSize> inIov;
+    std::array<mmsghdr, batchSize> inMsgs{};
+    for (size_t i = 0; i < batchSize; ++i){
+        inIov[i] = {in.data() + i * maxDatagramSize, maxDatagramSize};
+        inMsgs[i].msg_hdr.msg_iov = &inIov[i];
+        inMsgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    std::map<std::string, size_t> responses;
+    size_t nSent = 0;
+    size_t nReceived = 0;
+    auto begin = std::chrono::steady_clock::now();
+    while (nReceived < nInvites){
+        // Sending up to window INVITEs without response
+        size_t n = 0;
+        while (n < batchSize && nSent + n < nInvites &&
+               nSent + n - nReceived < window){
+            const auto number = std::to_string(79000000000ull + nSent + n);
+            out[n] = invite;
+            replace(out[n], "{number}", number);
+            replace(out[n], "{n}", std::to_string(nSent + n));
+            outIov[n] = {out[n].data(), out[n].size()};
+            outMsgs[n].msg_hdr.msg_iov = &outIov[n];
+            outMsgs[n].msg_hdr.msg_iovlen = 1;
+            ++n;
+        }
+        if (n > 0){
+            int sent = sendmmsg(fd, outMsgs.data(), n, 0);
+            if (sent < 0){
+                perror("sendmmsg");
+                break;
+            }
+            nSent += sent;
+        }
+        int received = recvmmsg(fd, inMsgs.data(), batchSize,
+                                MSG_WAITFORONE, nullptr);
+        if (received <= 0){
+            fprintf(stderr, "Responses timed out\n");
+            break;
+        }
+        for (int i = 0; i < received; ++i){
+            // "SIP/2.0 180 Ringing"
+            std::string status(in.data() + i * maxDatagramSize,
+                               std::min<size_t>(inMsgs[i].msg_len, 64));
+            status = status.substr(0, status.find('\r'));
+            ++responses[status.substr(status.find(' ') + 1)];
+        }
+        nReceived += received;
+    }
+    auto end = std::chrono::steady_clock::now();
+    close(fd);
+
+    const double elapsed = std::chrono::duration<double>(end - begin).count();
+    printf("invites: %zu, responses: %zu\n", nSent, nReceived);
+    for (auto & [status, count] : responses)
+        printf("  %s: %zu\n", status.c_str(), count);
+    printf("%.0f invites/s\n", nReceived / elapsed);
+    return 0;
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <functional>
+
+// Asynchronous logging of hot path messages.
+// A logging thread writes a fixed size record (message id and integer
+// arguments) into its own single producer single consumer ring without
+// locks or formatting. The writer thread drains the rings, formats
+// records and passes the text to the sink (easylogging++, so sinks and
+// levels of logger.conf apply). Records of a full ring are dropped and
+// counted, logging never blocks. Order is kept within a thread only.
+// Records keep the time of logging (coarse clock) and the function of
+// the call site (ASYNC_LOG), the sink prints them.
+class AsyncLog{
+public:
+    enum class Level : uint8_t{
+        debug,
+        info,
+        warning,
+        error
+    };
+
+    // Message texts, "{}" - argument
+    enum class Message : uint16_t{
+        pushed,
+        overloaded,
+        alreadyInQueue,
+        cancelled,
+        operatorAssigned,
+        cdrInitialized,
+        cdrReady,
+        servingStarted,
+        callEnded,
+        operatorReleased,
+        endedByTimeout
+    };
+
+    static constexpr size_t maxArgs = 4;
+
+    struct Record{
+        Message message;
+        Level level;
+        std::array<uint64_t, maxArgs> args;
+        // Unix time, nanoseconds
+        uint64_t time;
+        // Call site function name (string literal)
+        const char * func;
+    };
+
+    // Gets record and its formatted message
+    using Sink = std::function<void(const Record &, const std::string &)>;
+
+    // Records per thread
+    static constexpr size_t ringCapacity = 4096;
+
+    AsyncLog();
+    // Writes remaining records
+    ~AsyncLog();
+    AsyncLog(const AsyncLog &) = delete;
+    AsyncLog & operator=(const AsyncLog &) = delete;
+
+    // Log of the process
+    static AsyncLog & instance();
+
+    // Starts writer thread. levels - bit mask of enabled levels
+    // (see levelBit), records of other levels are not written
+    void start(Sink sink, const uint32_t levels);
+    static constexpr uint32_t levelBit(const Level level);
+
+    template <typename... Args>
+    void log(const Level level, const char * func, const Message message,
+             const Args... args);
+
+    // Waits until records logged before the call are written
+    void flush();
+    // Records dropped because of full rings
+    uint64_t getDropped() const;
+
+    static std::string format(const Record & record);
+    // Local time "YYYY-MM-DD hh:mm:ss.mmm"
+    static std::string formatTime(const uint64_t time);
+
+private:
+    struct Ring{
+        alignas(64) std::atomic<uint64_t> head{0};
+        alignas(64) std::atomic<uint64_t> tail{0};
+        // Producer thread exited, ring is removed when drained
+        std::atomic<bool> closed{false};
+        std::array<Record, ringCapacity> records;
+    };
+
+    const uint64_t id;
+    std::atomic<uint32_t> levels;
+    Sink sink;
+
+    std::mutex ringsMtx;
+    std::vector<std::shared_ptr<Ring>> rings;
+    // Records dropped because of full rings
+    std::atomic<uint64_t> dropped;
+    // Records written by writer thread
+    std::atomic<uint64_t> written;
+    // Records pushed into removed rings. Under ringsMtx
+    uint64_t removedPushed;
+
+    std::atomic<bool> stopped;
+    std::thread writer;
+
+    Ring & localRing();
+    static uint64_t now();
+    void push(const Record & record);
+    void run();
+    // Returns number of written records
+    size_t drain();
+};
+
+inline constexpr uint32_t AsyncLog::levelBit(const Level level){
+    return 1u << static_cast<unsigned>(level);
+}
+
+template <typename... Args>
+inline void AsyncLog::log(const Level level, const char * func,
+                          const Message message, const Args... args){
+    static_assert(sizeof...(Args) <= maxArgs);
+    if (!(levels.load(std::memory_order_relaxed) & levelBit(level)))
+        return;
+    push(Record{message, level, {static_cast<uint64_t>(args)...}, now(),
+                func});
+}
+
+#if defined(__GNUC__)
+#define ASYNC_LOG_FUNC __PRETTY_FUNCTION__
+#else
+#define ASYNC_LOG_FUNC __func__
+#endif
+
+// Logs into process async log with call site function name, like LOG():
+// ASYNC_LOG(info, AsyncLog::Message::pushed, callId)
+#define ASYNC_LOG(LEVEL, ...) \
+    AsyncLog::instance().log(AsyncLog::Level::LEVEL, ASYNC_LOG_FUNC, \
+                             __VA_ARGS__)
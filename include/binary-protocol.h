@@ -0,0 +1,138 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string_view>
+
+#include "cdr.h"
+
+// Binary ingest protocol frames.
+// Integers are little endian. Every frame starts with u16 length of
+// the rest of the frame, so a reader can split a stream into frames
+// without knowing frame types.
+//
+// Call frame (client -> server):
+//   u16 length | u64 request id | i64 receive time (Unix time, seconds,
+//   0 - time of receiving) | u8 priority | u8 phone number length |
+//   phone number
+// Reply frame (server -> client), replies are sent in call frames order:
+//   u16 length | u64 request id | u64 call id | u8 call status
+namespace binproto{
+
+struct Call{
+    uint64_t requestId = 0;
+    int64_t receiveTime = 0;
+    // Reserved, calls are queued in arrival order
+    uint8_t priority = 0;
+    // Points into parsed buffer
+    std::string_view phoneNumber;
+};
+
+struct Reply{
+    uint64_t requestId = 0;
+    // 0 - call shed by load shedding
+    uint64_t callId = 0;
+    cdr::CallStatus callStatus = cdr::CallStatus::ok;
+};
+
+enum class ParseResult{
+    ok,
+    incomplete,
+    invalid
+};
+
+constexpr size_t callHeaderSize = 2 + 8 + 8 + 1 + 1;
+constexpr size_t maxCallSize = callHeaderSize + cdr::PhoneNumber::capacity;
+constexpr size_t replySize = 2 + 8 + 8 + 1;
+
+// consumed - frame size
+ParseResult parseCall(const char * data, const size_t size, Call & call,
+                      size_t & consumed);
+// Buffer should have maxCallSize free chars.
+// Phone number should be not longer than PhoneNumber::capacity
+char * writeCall(char * out, const Call & call);
+
+ParseResult parseReply(const char * data, const size_t size, Reply & reply);
+// Buffer should have replySize free chars
+char * writeReply(char * out, const Reply & reply);
+
+
+namespace detail{
+
+template <typename Int>
+inline char * put(char * out, Int value){
+    for (size_t i = 0; i < sizeof(Int); ++i)
+        *out++ = static_cast<char>(static_cast<uint64_t>(value) >> (8 * i));
+    return out;
+}
+
+template <typename Int>
+inline const char * get(const char * in, Int & value){
+    uint64_t v = 0;
+    for (size_t i = 0; i < sizeof(Int); ++i)
+        v |= static_cast<uint64_t>(static_cast<uint8_t>(in[i])) << (8 * i);
+    value = static_cast<Int>(v);
+    return in + sizeof(Int);
+}
+
+};
+
+inline ParseResult parseCall(const char * data, const size_t size,
+                             Call & call, size_t & consumed){
+    if (size < 2)
+        return ParseResult::incomplete;
+    uint16_t length;
+    auto in = detail::get(data, length);
+    if (length < callHeaderSize - 2 || length > maxCallSize - 2)
+        return ParseResult::invalid;
+    if (size < 2u + length)
+        return ParseResult::incomplete;
+    uint8_t phoneLength;
+    in = detail::get(in, call.requestId);
+    in = detail::get(in, call.receiveTime);
+    in = detail::get(in, call.priority);
+    in = detail::get(in, phoneLength);
+    if (callHeaderSize + phoneLength != 2u + length)
+        return ParseResult::invalid;
+    call.phoneNumber = std::string_view(in, phoneLength);
+    consumed = 2 + length;
+    return ParseResult::ok;
+}
+
+inline char * writeCall(char * out, const Call & call){
+    out = detail::put(out, static_cast<uint16_t>(callHeaderSize - 2 +
+                                                 call.phoneNumber.size()));
+    out = detail::put(out, call.requestId);
+    out = detail::put(out, call.receiveTime);
+    out = detail::put(out, call.priority);
+    out = detail::put(out, static_cast<uint8_t>(call.phoneNumber.size()));
+    for (auto c : call.phoneNumber)
+        *out++ = c;
+    return out;
+}
+
+inline ParseResult parseReply(const char * data, const size_t size,
+                              Reply & reply){
+    if (size < replySize)
+        return ParseResult::incomplete;
+    uint16_t length;
+    auto in = detail::get(data, length);
+    if (length != replySize - 2)
+        return ParseResult::invalid;
+    uint8_t callStatus;
+    in = detail::get(in, reply.requestId);
+    in = detail::get(in, reply.callId);
+    detail::get(in, callStatus);
+    reply.callStatus = static_cast<cdr::CallStatus>(callStatus);
+    return ParseResult::ok;
+}
+
+inline char * writeReply(char * out, const Reply & reply){
+    out = detail::put(out, static_cast<uint16_t>(replySize - 2));
+    out = detail::put(out, reply.requestId);
+    out = detail::put(out, reply.callId);
+    return detail::put(out, static_cast<uint8_t>(reply.callStatus));
+}
+
+};
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <string>
+#include <memory>
+
+class CallCenter;
+
+// Binary ingest protocol listener (see binary-protocol.h) for local
+// front ends. Listens on Unix domain socket ("unix:/path") or TCP
+// ("host:port"). Event loop threads share the listening socket.
+// All call frames received by one read are pushed with one
+// CallCenter::pushCalls() and answered with one sendmsg.
+class BinaryServer{
+public:
+    // Blocking. nThreads == 0 - one event loop
+    bool listen(const std::string & address, const size_t nThreads,
+                std::shared_ptr<CallCenter> callCenter);
+
+private:
+    std::shared_ptr<CallCenter> callCenter;
+
+    void loop(const int listenFd) const;
+};
@@ -4,27 +4,174 @@
 
 #include <map>
 #include <list>
+#include <vector>
 #include <string>
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <chrono>
-#include <shared_mutex>
+#include <optional>
 
 #include "json.hpp"
 
 #include "cdr.h"
+#include "kpi.h"
+#include "call-events.h"
+#include "overload-controller.h"
+#include "call-index.h"
+#include "cdr-exporter.h"
+#include "event-log.h"
+#include "call-trace.h"
+#include "metrics.h"
 #include "unique-queue.h"
+#include "schedule.h"
+#include "distribution.h"
+#include "wakeup.h"
 
 using namespace cdr;
 
 class CallCenter{
 public:
+    // Place of waiting call in line
+    struct QueuePosition{
+        size_t callId;
+        // 1 - next call to be answered
+        size_t position;
+        // Estimated seconds until answer
+        uint32_t estimatedWait;
+    };
+
+    // Validated dispatching parameters. Published as immutable
+    // snapshots, so readers never lock and always see consistent
+    // parameters
+    // Defaults are the not configured call center: no operators
+    struct Config{
+        // Increases with every published snapshot
+        uint64_t version = 0;
+        // Seconds
+        size_t minResponseTime = 1;
+        size_t maxResponseTime = 1;
+        size_t minCallDuration = 0;
+        size_t maxCallDuration = 0;
+        size_t nOperators = 0;
+        size_t maxCallQueueSize = 1;
+        // Behavior when receiving call from phone number that is
+        // already in queue:
+        // 1 - Reject
+        // 0 - Delete old call and place new one in queue
+        bool rejectRepeatedCalls = true;
+        // Call durations within [minCallDuration, maxCallDuration]
+        std::shared_ptr<const Distribution> callDuration =
+            std::make_shared<const Distribution>();
+        // Wait after which callers hang up, limited by maxResponseTime.
+        // Not set - callers wait until maxResponseTime
+        std::shared_ptr<const Distribution> patience;
+        // Time of day windows overriding parameters above
+        Schedule schedule;
+        // Window applied by withWindow
+        size_t activeWindow = Schedule::noWindow;
+
+        // Base parameters and parameters of every window are valid
+        bool isValid() const;
+        // Version and active window are not compared
+        bool hasSameParams(const Config & other) const;
+        // Parameters overridden by schedule window
+        Config withWindow(const size_t window) const;
+
+    private:
+        bool isValidParams() const;
+    };
+    enum class ConfigResult{
+        ok,
+        invalid,
+        // Config was changed after expected version
+        conflict
+    };
+
     CallCenter();
     static std::shared_ptr<CallCenter> getCallCenter(const std::string & confFileName = "");
 
     void run();
+    // Reads configuration files and publishes new snapshot.
+    // Never blocks dispatching
     bool configure();
-    void pushCall(Cdr & cdr);
+    // Snapshot cached by calling thread until a new one is published.
+    // Reference is valid until the next call from the same thread
+    const Config & getConfig() const;
+    // Config with parameters of the schedule window active now.
+    // Cached the same way as getConfig()
+    const Config & getActiveConfig() const;
+    // Publishes config with the next version, if valid.
+    // Config with the same parameters keeps current version
+    bool setConfig(const Config & config);
+    // Optimistic concurrency: publishes config only if current
+    // version is expectedVersion. If published != nullptr, snapshot
+    // current after the call is written to *published: the one
+    // published or kept by this call, the newer one on conflict
+    ConfigResult setConfig(const Config & config,
+                           const uint64_t expectedVersion,
+                           std::shared_ptr<const Config> * published =
+                               nullptr);
+    // Waits until dispatcher uses config of version or newer.
+    // Sleeps until dispatcher applies a config, doesn't spin
+    bool waitConfigApplied(const uint64_t version,
+                           const std::chrono::microseconds timeout) const;
+    // Writes current config parameters into configuration file
+    bool persistConfig() const;
+    // Config parameters with configuration file names.
+    // Without readHistory CDR histories built before are reused
+    // without checking their files (request threads)
+    static bool readConfig(const nlohmann::json & conf, Config & config,
+                           const bool readHistory = true);
+    // Rebuilds CDR history distributions of config if history files
+    // changed and publishes the config. Called by configuration watcher
+    void refreshHistory();
+    static nlohmann::json toJson(const Config & config);
+    // Validates all parameters of configuration file, fills config
+    static bool readConfParams(const nlohmann::json & conf, Config & config);
+    // Free operators ids after nOperators change. Busy operators
+    // above nOperators are not freed after their calls end, busy
+    // operators within nOperators are freed then, not now
+    static void reconcileOperators(
+        std::list<size_t> & freeOperators,
+        const std::multimap<cdr::Seconds, Cdr> & servicedCalls,
+        const size_t oldNOperators, const size_t nOperators);
+    // Load shedding before pushing nCalls: returns true if calls
+    // should be rejected without queue work (HTTP 503).
+    // retryAfter - seconds until queue is expected to accept calls
+    bool shedCalls(const size_t nCalls, uint32_t & retryAfter);
+    // If position != nullptr and call is queued, its place in line
+    // is written to *position
+    void pushCall(Cdr & cdr, QueuePosition * position = nullptr);
+    // Pushes calls under one call queue lock.
+    // Results are the same as pushing calls one by one
+    void pushCalls(std::vector<Cdr> & cdrs);
+    // Removes call waiting in queue (caller hung up). Finished call
+    // gets abandoned status, cancelled - its CDR. Call already taken
+    // by the dispatcher can't be cancelled
+    bool cancelCall(const PhoneNumber & phoneNumber, Cdr & cancelled);
+    bool cancelCall(const size_t callId, Cdr & cancelled);
+    // Place in line of call waiting in queue
+    bool getQueuePosition(const PhoneNumber & phoneNumber,
+                          QueuePosition & position) const;
+    bool getQueuePosition(const size_t callId,
+                          QueuePosition & position) const;
+    // Live or recently finished call
+    bool findCall(const size_t callId, CallIndex::Entry & entry) const;
+    Kpi::Snapshot getKpi(const Kpi::Window window) const;
+    // Call lifecycle events for subscribers
+    const CallEvents & getCallEvents() const;
+    // Sampled call stage timestamps
+    CallTrace & getCallTrace();
+    OverloadController::Snapshot getOverload() const;
+    // Counters and gauges for /metrics
+    Metrics::Snapshot getMetrics() const;
+    // Default configuration merged with configuration file
+    nlohmann::json getConfiguration() const;
+    // Absolute paths of default configuration and configuration files
+    std::vector<std::string> getConfPaths() const;
 
+    // Getters return base parameters, without schedule windows
     bool setMinResponseTime(const size_t minResponseTime);
     bool setMaxResponseTime(const size_t maxResponseTime);
     bool setMinMaxResponseTime(const size_t minResponseTime,
@@ -48,64 +195,137 @@ public:
     bool setNOperators(const size_t nOperators);
     size_t getNOperators() const;
 
+    bool setCallIndexRetention(const size_t retention);
+    size_t getCallIndexRetention() const;
+    bool setCallIndexCapacity(const size_t capacity);
+    size_t getCallIndexCapacity() const;
+
+    bool setServiceLevelTime(const size_t serviceLevelTime);
+    size_t getServiceLevelTime() const;
+
+    // Call id generator node id. Should be unique for
+    // every call center instance
+    bool setNodeId(const uint32_t nodeId);
+
+    void setLoadShedding(const bool enabled);
+
+    // Empty dir disables CDR export. Format: csv or ndjson
+    bool setCdrExport(const std::string & dir, const std::string & format);
+
+    // Binary call event log file. Empty path disables it
+    bool setEventLog(const std::string & path, const bool lossless);
+
+    // Share of traced calls [0, 1], 0 disables tracing
+    bool setTraceSampleRate(const double rate);
+
+    // Seed of call durations, 0 - random. Generator is reseeded
+    // only when the seed changes
+    void setRandomSeed(const uint64_t seed);
+
 private:
-    // Minimum call duration (seconds)
-    size_t minCallDuration;
-    // Maximum call duration (seconds)
-    size_t maxCallDuration;
-    // Minimum call response time (seconds)
-    size_t minResponseTime;
-    // Maximum call response time (seconds)
-    size_t maxResponseTime;
-    // Number of operators
-    size_t nOperators;
+    // Owner of per-thread config caches. Unlike the address it is
+    // never reused by another instance
+    const uint64_t id;
+    // Current snapshot, accessed with std::atomic_load/atomic_store
+    std::shared_ptr<const Config> config;
+    // Version of config, checked by readers before loading it
+    std::atomic<uint64_t> configVersion;
+    // Serializes config writers
+    std::mutex configMtx;
+    // Snapshot of dispatcher with active schedule window parameters,
+    // replaced between iterations
+    std::shared_ptr<const Config> dispatcherConfig;
+    // Version of dispatcherConfig
+    std::atomic<uint64_t> appliedConfigVersion;
+    // Notified by dispatcher when appliedConfigVersion changes
+    mutable Wakeup configApplied;
+    // Config with active schedule window parameters, accessed with
+    // std::atomic_load/atomic_store
+    std::shared_ptr<const Config> activeConfig;
+    // Increases with every activeConfig change
+    std::atomic<uint64_t> activeConfigGeneration;
+    // Dispatcher: next schedule window begin or end
+    cdr::Seconds nextBoundary;
     // Current calls (handled by operators)
     // Ordered by call end DT
-    std::multimap<std::chrono::time_point<std::chrono::steady_clock>, Cdr> servicedCalls;
-    // Free operators ids
+    std::multimap<cdr::Seconds, Cdr> servicedCalls;
+    // Free operators ids. Dispatcher only
     std::list<size_t> freeOperators;
     std::unique_ptr<UniqueQueue<Cdr>> callQueue;
-    // Behavior when receiving call from phone number that is already in queue:
-    // 1 - Reject
-    // 0 - Delete old call and place new one in queue
-    //bool rejectRepeatedCalls; -> placed in callQueue->...
+    // Dispatcher holds call taken from queue until an operator
+    // is free. The call is ahead of all queued calls
+    std::atomic<bool> callHeld;
+    // Queued, serviced and recently finished calls by call id
+    CallIndex callIndex;
+    // Sliding window KPIs fed by call events
+    Kpi kpi;
+    // Final CDRs export to hourly files
+    CdrExporter cdrExporter;
+    CallEvents callEvents;
+    // Call events written to binary log
+    EventLog eventLog;
+    CallTrace trace;
+    Metrics metrics;
+    // Seed set by configuration
+    std::optional<uint64_t> randomSeed;
+    // Shedding calls when queue is full, measures queue drain rate
+    OverloadController overload;
     // Configuration file name
     std::string confFileName;
     // Default configuration file name
     std::string defaultConfFileName;
-    // Blocking mtx while configuring
-    mutable std::shared_mutex mtx;
 
-    bool tryServeCall(Cdr & cdr);
+    // Patience - wait of the caller before hanging up
+    bool tryServeCall(Cdr & cdr, const size_t patience);
     bool serveCall(Cdr & cdr);
     void serveCall();
     bool tryEndCall(decltype(servicedCalls)::iterator callIt);
     void endCallByTimeout(Cdr & cdr);
     void releaseOperator(const size_t operatorId);
     void initializeCdr(Cdr & cdr);
+    void preparePush(Cdr & cdr);
+    void finishPush(Cdr & cdr, const UniqueQueue<Cdr>::EC ec,
+                    Cdr & replaced);
+    void finishCancel(Cdr & cdr);
+    void setQueuePosition(const size_t callId, const size_t queuePosition,
+                          const cdr::Seconds receiveDT,
+                          QueuePosition & position) const;
+
+    // Called under configMtx. Returns current snapshot,
+    // nullptr if config is invalid
+    std::shared_ptr<const Config> publishConfig(const Config & config);
+    // Publishes config with parameters of the schedule window active
+    // at now and applies queue size of the window
+    std::shared_ptr<const Config> publishActiveConfig(const Config & config,
+                                                      const cdr::Seconds now);
+    // Dispatcher: switches to the latest config and the schedule
+    // window active now
+    void applyConfig();
+    template <typename Value, typename Update>
+    bool updateConfig(const char * parName, const Value & value,
+                      Update update);
 
     bool getConf(nlohmann::json & conf) const;
     static std::string getConfPath(const std::string & fN);
     static bool readConf(const std::string & fN,
                                   nlohmann::json & conf);
-    static bool setConfParams(const nlohmann::json & conf,
-                                       CallCenter & callCenter);
+    void setConfParams(const nlohmann::json & conf, const Config & config);
 
 };
 
 
 inline size_t CallCenter::getMinResponseTime() const{
-    return minResponseTime;
+    return getConfig().minResponseTime;
 }
 inline size_t CallCenter::getMaxResponseTime() const{
-    return maxResponseTime;
+    return getConfig().maxResponseTime;
 }
 
 inline size_t CallCenter::getMinCallDuration() const{
-    return minCallDuration;
+    return getConfig().minCallDuration;
 }
 inline size_t CallCenter::getMaxCallDuration() const{
-    return maxCallDuration;
+    return getConfig().maxCallDuration;
 }
 
 inline size_t CallCenter::getMaxCallQueueSize() const{
@@ -113,10 +333,51 @@ inline size_t CallCenter::getMaxCallQueueSize() const{
 }
 
 inline size_t CallCenter::getNOperators() const{
-    return nOperators;
+    return getConfig().nOperators;
+}
+inline size_t CallCenter::getCallIndexRetention() const{
+    return callIndex.getRetention();
+}
+
+inline size_t CallCenter::getCallIndexCapacity() const{
+    return callIndex.getCapacity();
 }
+
+inline size_t CallCenter::getServiceLevelTime() const{
+    return kpi.getServiceLevelTime();
+}
+
+inline Kpi::Snapshot CallCenter::getKpi(const Kpi::Window window) const{
+    return kpi.get(window);
+}
+
+inline const CallEvents & CallCenter::getCallEvents() const{
+    return callEvents;
+}
+
+inline CallTrace & CallCenter::getCallTrace(){
+    return trace;
+}
+
+inline OverloadController::Snapshot CallCenter::getOverload() const{
+    return overload.get();
+}
+
+inline Metrics::Snapshot CallCenter::getMetrics() const{
+    auto snapshot = metrics.collect();
+    snapshot.callQueueSize = callQueue->getSize();
+    snapshot.eventLogWritten = eventLog.getWritten();
+    snapshot.eventLogLost = eventLog.getLost();
+    return snapshot;
+}
+
+inline bool CallCenter::findCall(const size_t callId,
+                                 CallIndex::Entry & entry) const{
+    return callIndex.find(callId, entry);
+}
+
+// Operators removed by nOperators decrease are not released
 inline void CallCenter::releaseOperator(const size_t operatorId){
-    std::shared_lock<std::shared_mutex> lck(mtx);
-    if (operatorId <= nOperators)
+    if (operatorId <= dispatcherConfig->nOperators)
         freeOperators.push_back(operatorId);
 }
\ No newline at end of file
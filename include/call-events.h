@@ -0,0 +1,125 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <atomic>
+#include <memory>
+
+#include "cdr.h"
+#include "wakeup.h"
+
+// Call lifecycle events broadcast.
+// Events are written into a fixed ring without locks: a publisher
+// takes a position with one fetch_add and writes the slot under its
+// sequence number (seqlock). Subscribers only read the ring, so their
+// number does not affect publishers. A subscriber falling behind by
+// more than the ring capacity finds its slot overwritten and is
+// reported lagged instead of blocking publishers.
+// Subscribers out of events wait on getWakeup() instead of polling.
+// One subscriber may reserve its events (reserve()): publishers then
+// wait instead of overwriting events it has not read. Only the opt-in
+// lossless event log does it, trading dispatcher latency for no gaps.
+class CallEvents{
+public:
+    enum class Type : uint8_t{
+        queued,
+        // Call answered by operator
+        answered,
+        timedOut,
+        ended,
+        // Call not placed in queue or removed from queue
+        // by repeated call (see cdr.callStatus)
+        rejected,
+        // Call cancelled while waiting in queue
+        abandoned
+    };
+
+    struct Event{
+        Type type;
+        // Call queue size after the event
+        uint32_t queueSize;
+        // Unix time, nanoseconds
+        uint64_t time;
+        cdr::Cdr cdr;
+    };
+
+    enum class Result{
+        ok,
+        // No new events
+        empty,
+        // Subscriber missed events
+        lagged
+    };
+
+    class Subscriber{
+    public:
+        // Receives events published after subscribing
+        explicit Subscriber(const CallEvents & events);
+        Result next(Event & event);
+        // Position of the next event
+        uint64_t getCursor() const;
+
+    private:
+        const CallEvents & events;
+        // Position of the next event
+        uint64_t cursor;
+    };
+
+    static constexpr size_t capacity = 1 << 16;
+
+    CallEvents();
+
+    void publish(const Type type, const cdr::Cdr & cdr,
+                 const size_t queueSize = 0);
+
+    // Notified after publish
+    Wakeup & getWakeup() const;
+
+    // Events from position are not overwritten. Reserving subscriber
+    // moves reservation to its cursor at least every reserveStep events
+    // and before waiting for events
+    void reserve(const uint64_t position) const;
+    void unreserve() const;
+    static constexpr size_t reserveStep = 1024;
+
+    static const char * toString(const Type type);
+    // Events after which call has no more events
+    static bool isFinal(const Type type);
+
+private:
+    static constexpr size_t nWords = (sizeof(Event) + 7) / 8;
+
+    struct Slot{
+        // 2 * (position + 1) when written,
+        // odd while being written
+        std::atomic<uint64_t> sequence{0};
+        std::array<std::atomic<uint64_t>, nWords> words{};
+    };
+
+    static constexpr uint64_t noReservation = UINT64_MAX;
+
+    alignas(64) std::atomic<uint64_t> head{0};
+    // Written by reserving subscriber only
+    alignas(64) mutable std::atomic<uint64_t> reserved{noReservation};
+    std::unique_ptr<Slot[]> slots;
+    mutable Wakeup wakeup;
+};
+
+
+inline Wakeup & CallEvents::getWakeup() const{
+    return wakeup;
+}
+
+inline void CallEvents::reserve(const uint64_t position) const{
+    reserved.store(position, std::memory_order_release);
+}
+
+inline void CallEvents::unreserve() const{
+    reserved.store(noReservation, std::memory_order_release);
+}
+
+inline uint64_t CallEvents::Subscriber::getCursor() const{
+    return cursor;
+}
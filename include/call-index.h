@@ -0,0 +1,95 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <array>
+#include <deque>
+#include <mutex>
+#include <chrono>
+#include <string>
+#include <atomic>
+#include <utility>
+#include <unordered_map>
+
+#include "cdr.h"
+
+// Index of live and recently finished calls by call id.
+// Calls are spread over independently locked shards, so lookups and
+// updates are O(1), never take the call queue lock and rarely contend
+// with each other.
+// Finished calls are kept for retention seconds, but no more than
+// capacity finished calls in total.
+class CallIndex{
+public:
+    enum class State{
+        queued,
+        serving,
+        ended,
+        timeout,
+        rejected,
+        replaced,
+        abandoned
+    };
+    struct Entry{
+        State state;
+        cdr::Cdr cdr;
+    };
+
+    // At least one finished call per shard
+    static constexpr size_t minCapacity = 16;
+
+    CallIndex();
+
+    // Inserts new call or updates state of existing one
+    void update(const State state, const cdr::Cdr & cdr);
+    bool find(const size_t callId, Entry & entry) const;
+    size_t getSize() const;
+
+    bool setRetention(const size_t retention);
+    size_t getRetention() const;
+    bool setCapacity(const size_t capacity);
+    size_t getCapacity() const;
+
+    static bool isFinished(const State state);
+
+private:
+    // Should match shard selection in getShard()
+    static constexpr size_t nShards = 16;
+    static_assert(minCapacity >= nShards);
+    using TimePoint = std::chrono::time_point<std::chrono::steady_clock>;
+
+    struct Shard{
+        mutable std::mutex mtx;
+        std::unordered_map<size_t, Entry> calls;
+        // Finished calls ordered by finish DT
+        std::deque<std::pair<TimePoint, size_t>> finished;
+    };
+    // Mutable, because lookups evict expired calls too
+    mutable std::array<Shard, nShards> shards;
+    // Seconds
+    std::atomic<size_t> retention;
+    std::atomic<size_t> capacity;
+
+    Shard & getShard(const size_t callId) const;
+    void evict(Shard & shard, const TimePoint now) const;
+};
+
+std::string toString(CallIndex::State state);
+
+
+// Fibonacci hashing, so sequential call ids are spread over all shards
+inline CallIndex::Shard & CallIndex::getShard(const size_t callId) const{
+    return shards[(callId * 0x9E3779B97F4A7C15ull) >> 60];
+}
+
+inline size_t CallIndex::getRetention() const{
+    return retention;
+}
+
+inline size_t CallIndex::getCapacity() const{
+    return capacity;
+}
+
+inline bool CallIndex::isFinished(const State state){
+    return state != State::queued && state != State::serving;
+}
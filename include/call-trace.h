@@ -0,0 +1,110 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Per call stage timestamps for latency breakdown.
+// Calls are sampled by call id hash, so every thread agrees on traced
+// calls without passing flags. A stage of a sampled call is written
+// into the ring of the recording thread (last ringCapacity stages of
+// the thread), readers take consistent slots without stopping writers
+// (seqlock). Disabled tracing costs one branch per stage.
+// Dump is Chrome trace_event JSON: every call is an async track with
+// slices between its stages (viewable in Perfetto or chrome://tracing).
+class CallTrace{
+public:
+    enum class Stage : uint8_t{
+        // Request received by HTTP ingress
+        received,
+        // Before call queue push
+        pushing,
+        queued,
+        // Not queued or removed from queue by repeated call
+        rejected,
+        // Taken from queue by dispatcher
+        popped,
+        answered,
+        ended,
+        timedOut,
+        abandoned
+    };
+
+    static constexpr size_t ringCapacity = 1 << 14;
+
+    CallTrace();
+
+    // 0 - disabled, 1 - every call
+    void setSampleRate(const double rate);
+    double getSampleRate() const;
+
+    void record(const Stage stage, const uint64_t callId);
+    void record(const Stage stage, const uint64_t callId, const uint64_t time);
+    // Thread remembers receive time of the next pushed calls, recorded
+    // as received stage when they get call ids
+    void markReceived();
+    // Records received (if marked) and pushing stages
+    void recordPush(const uint64_t callId);
+
+    // Stages of the last seconds as Chrome trace JSON
+    std::string dump(const uint32_t seconds) const;
+
+    static const char * toString(const Stage stage);
+    // Steady clock, nanoseconds
+    static uint64_t now();
+
+private:
+    struct Slot{
+        // 2 * (position + 1) when written, odd while being written
+        std::atomic<uint64_t> sequence{0};
+        std::atomic<uint64_t> time{0};
+        std::atomic<uint64_t> callId{0};
+        std::atomic<uint8_t> stage{0};
+    };
+
+    struct Ring{
+        // Recording thread number
+        uint32_t thread;
+        std::atomic<uint64_t> head{0};
+        std::array<Slot, ringCapacity> slots;
+    };
+
+    struct Entry{
+        uint64_t time;
+        uint64_t callId;
+        uint32_t thread;
+        Stage stage;
+    };
+
+    const uint64_t id;
+    // Sampled if call id hash < threshold. 0 - disabled
+    std::atomic<uint64_t> threshold;
+    mutable std::mutex ringsMtx;
+    std::vector<std::shared_ptr<Ring>> rings;
+
+    bool isSampled(const uint64_t callId) const;
+    void write(const Stage stage, const uint64_t callId, const uint64_t time);
+    Ring & localRing();
+    std::vector<Entry> collect(const uint64_t since) const;
+};
+
+inline void CallTrace::record(const Stage stage, const uint64_t callId){
+    if (threshold.load(std::memory_order_relaxed) == 0)
+        return;
+    if (isSampled(callId))
+        write(stage, callId, now());
+}
+
+inline void CallTrace::record(const Stage stage, const uint64_t callId,
+                              const uint64_t time){
+    if (threshold.load(std::memory_order_relaxed) == 0)
+        return;
+    if (isSampled(callId))
+        write(stage, callId, time);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <condition_variable>
+
+#include "cdr.h"
+
+// Streams final CDRs to hourly gzip compressed CSV or NDJSON files
+// (<dir>/cdr-YYYYMMDDHH.<csv|ndjson>.gz, UTC hour of call end).
+// Records are collected in a bounded buffer and written by a
+// background thread, so push() never waits for disk or compression.
+// If the buffer is full, records are dropped and counted.
+class CdrExporter{
+public:
+    enum class Format{
+        csv,
+        ndjson
+    };
+
+    CdrExporter();
+    ~CdrExporter();
+
+    // Empty dir disables export. Applied from the next written batch
+    void setDir(const std::string & dir);
+    std::string getDir() const;
+    void setFormat(const Format format);
+    Format getFormat() const;
+
+    // Returns false if record is dropped
+    bool push(const cdr::Cdr & cdr);
+    size_t getDropped() const;
+
+    static bool parseFormat(const std::string & str, Format & format);
+
+private:
+    // Records (4 MB)
+    static constexpr size_t bufferCapacity = 65536;
+
+    std::vector<cdr::Cdr> buffer;
+    std::atomic<bool> enabled;
+    std::atomic<size_t> dropped;
+    std::string dir;
+    Format format;
+    bool stopping;
+    std::thread writer;
+    std::condition_variable hasRecords;
+    mutable std::mutex mtx;
+
+    void write();
+};
+
+
+inline size_t CdrExporter::getDropped() const{
+    return dropped;
+}
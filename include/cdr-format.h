@@ -0,0 +1,125 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cstring>
+#include <charconv>
+#include <string_view>
+#include <type_traits>
+
+#include "cdr.h"
+
+// Hand-rolled CDR formatting into caller provided buffers.
+// Functions return pointer past the last written char and never
+// allocate. Buffer should have at least maxRecordSize free chars.
+namespace cdrformat{
+
+// Phone number fully escaped (6 chars per char) plus numeric fields
+constexpr size_t maxRecordSize = 512;
+
+constexpr std::string_view csvHeader =
+    "call_id,phone_number,receive_time,response_time,end_time,"
+    "call_status,operator_id,call_duration\n";
+
+char * formatCsv(const cdr::Cdr & cdr, char * out);
+char * formatNdjson(const cdr::Cdr & cdr, char * out);
+
+
+inline char * append(char * out, std::string_view s){
+    std::memcpy(out, s.data(), s.size());
+    return out + s.size();
+}
+
+template <typename Int,
+          typename = std::enable_if_t<std::is_integral<Int>::value>>
+inline char * append(char * out, Int value){
+    return std::to_chars(out, out + 20, value).ptr;
+}
+
+// Quoted only if it contains separators
+inline char * appendCsv(char * out, std::string_view s){
+    if (s.find_first_of(",\"\r\n") == std::string_view::npos)
+        return append(out, s);
+    *out++ = '"';
+    for (auto c : s){
+        if (c == '"')
+            *out++ = '"';
+        *out++ = c;
+    }
+    *out++ = '"';
+    return out;
+}
+
+inline char * appendJson(char * out, std::string_view s){
+    static constexpr char hex[] = "0123456789abcdef";
+    *out++ = '"';
+    for (unsigned char c : s){
+        if (c == '"' || c == '\\'){
+            *out++ = '\\';
+            *out++ = c;
+        }
+        else if (c < 0x20){
+            out = append(out, "\\u00");
+            *out++ = hex[c >> 4];
+            *out++ = hex[c & 0xF];
+        }
+        else
+            *out++ = c;
+    }
+    *out++ = '"';
+    return out;
+}
+
+// Response DT and operator id are empty for not answered calls
+inline char * formatCsv(const cdr::Cdr & cdr, char * out){
+    const bool answered = cdr.callStatus == cdr::CallStatus::ok;
+    out = append(out, cdr.callId);
+    *out++ = ',';
+    out = appendCsv(out, cdr.phoneNumber.view());
+    *out++ = ',';
+    out = append(out, cdr::toUnixTime(cdr.receiveDT));
+    *out++ = ',';
+    if (answered)
+        out = append(out, cdr::toUnixTime(cdr.responseDT));
+    *out++ = ',';
+    out = append(out, cdr::toUnixTime(cdr.endDT));
+    *out++ = ',';
+    out = append(out, cdr::statusName(cdr.callStatus));
+    *out++ = ',';
+    if (answered)
+        out = append(out, cdr.operatorId);
+    *out++ = ',';
+    out = append(out, cdr.callDuration);
+    *out++ = '\n';
+    return out;
+}
+
+inline char * formatNdjson(const cdr::Cdr & cdr, char * out){
+    const bool answered = cdr.callStatus == cdr::CallStatus::ok;
+    out = append(out, "{\"call_id\":");
+    out = append(out, cdr.callId);
+    out = append(out, ",\"phone_number\":");
+    out = appendJson(out, cdr.phoneNumber.view());
+    out = append(out, ",\"receive_time\":");
+    out = append(out, cdr::toUnixTime(cdr.receiveDT));
+    if (answered){
+        out = append(out, ",\"response_time\":");
+        out = append(out, cdr::toUnixTime(cdr.responseDT));
+    }
+    out = append(out, ",\"end_time\":");
+    out = append(out, cdr::toUnixTime(cdr.endDT));
+    out = append(out, ",\"call_status\":\"");
+    out = append(out, cdr::statusName(cdr.callStatus));
+    *out++ = '"';
+    if (answered){
+        out = append(out, ",\"operator_id\":");
+        out = append(out, cdr.operatorId);
+    }
+    out = append(out, ",\"call_duration\":");
+    out = append(out, cdr.callDuration);
+    out = append(out, "}\n");
+    return out;
+}
+
+};
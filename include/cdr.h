@@ -1,43 +1,162 @@
 #pragma once
+#include <cassert>
 #include <chrono>
+#include <iterator>
 #include <string>
+#include <ostream>
+#include <cstring>
+#include <functional>
+#include <string_view>
+#include <type_traits>
 #include <unordered_map>
 #include <stddef.h>
+#include <stdint.h>
 
 namespace cdr{
 
-enum class CallStatus{
+enum class CallStatus : uint8_t{
     ok,
     overload,
     alreadyInQueue,
     callDuplication,
-    timeout
+    timeout,
+    // Caller hung up while waiting in queue
+    abandoned
 };
 
 std::string toString(CallStatus cS);
 
+// Status names indexed by CallStatus
+constexpr std::string_view statusNames[] = {
+    "ok",
+    "overload",
+    "alreadyInQueue",
+    "callDuplication",
+    "timeout",
+    "abandoned"
+};
+static_assert(std::size(statusNames) ==
+              static_cast<size_t>(CallStatus::abandoned) + 1,
+              "Every CallStatus should have name");
+
+// Allocation free status name
+constexpr std::string_view statusName(CallStatus cS){
+    return statusNames[static_cast<size_t>(cS)];
+}
+
+// Seconds since epoch base (call center start, steady clock)
+using Seconds = uint32_t;
+Seconds now();
+// Unix time (seconds) of epoch base offset
+int64_t toUnixTime(Seconds t);
+// Epoch base offset of Unix time, clamped to [epoch base, now]
+Seconds fromUnixTime(int64_t t);
+
+// Phone number stored inline, so Cdr stays trivially copyable
+class PhoneNumber{
+public:
+    static constexpr size_t capacity = 31;
+
+    // Returns false (number is not changed) if number is too long
+    bool assign(std::string_view number);
+    // For numbers known to fit: too long number is a bug (assert),
+    // without asserts it is rejected as by assign()
+    PhoneNumber & operator=(std::string_view number);
+
+    std::string_view view() const;
+    size_t size() const;
+    bool empty() const;
+
+    bool operator==(const PhoneNumber & other) const;
+    bool operator!=(const PhoneNumber & other) const;
+
+private:
+    char digits[capacity] = {};
+    uint8_t length = 0;
+};
+
+std::ostream & operator<<(std::ostream & os, const PhoneNumber & number);
+
+// Fields are ordered by size to avoid padding
 struct Cdr{
-    // DT поступления вызова.
-    std::chrono::time_point<std::chrono::steady_clock> receiveDT;
     // Идентификатор входящего вызова (Call ID)
-    size_t callId;
-    // Номер абонента
-    std::string phoneNumber;
-    // DT завершения вызова
-    std::chrono::time_point<std::chrono::steady_clock> endDT;
-    // Статус вызова (OK или причина ошибки, например timeout)
-    CallStatus callStatus;  
+    uint64_t callId = 0;
+    // DT поступления вызова.
+    Seconds receiveDT = 0;
     // DT ответа оператора (если был или пустое значение)
-    std::chrono::time_point<std::chrono::steady_clock> responseDT;
-    // Идентификатор оператора (пустое значение если соединение не состоялось)
-    size_t operatorId;
+    Seconds responseDT = 0;
+    // DT завершения вызова
+    Seconds endDT = 0;
     // Длительность разговора (пустое значение если соединение не состоялось)
-    std::chrono::duration<long long> callDuration; //sec
+    uint32_t callDuration = 0; //sec
+    // Идентификатор оператора (пустое значение если соединение не состоялось)
+    uint32_t operatorId = 0;
+    // Статус вызова (OK или причина ошибки, например timeout)
+    CallStatus callStatus = CallStatus::ok;
+    // Номер абонента
+    PhoneNumber phoneNumber;
 
 
-    std::string getId() const{
+    const PhoneNumber & getId() const{
         return phoneNumber;
     }
 };
 
-};
\ No newline at end of file
+// Cdr is copied through call queue, serviced calls and call index,
+// so it should stay one cache line and be copied by memcpy
+static_assert(sizeof(Cdr) == 64, "Cdr should fit one cache line");
+static_assert(std::is_trivially_copyable<Cdr>::value,
+              "Cdr should be trivially copyable");
+
+
+inline bool PhoneNumber::assign(std::string_view number){
+    if (number.size() > capacity)
+        return false;
+    std::memcpy(digits, number.data(), number.size());
+    std::memset(digits + number.size(), 0, capacity - number.size());
+    length = static_cast<uint8_t>(number.size());
+    return true;
+}
+
+inline PhoneNumber & PhoneNumber::operator=(std::string_view number){
+    [[maybe_unused]] const bool assigned = assign(number);
+    assert(assigned && "phone number is too long");
+    return *this;
+}
+
+inline std::string_view PhoneNumber::view() const{
+    return std::string_view(digits, length);
+}
+
+inline size_t PhoneNumber::size() const{
+    return length;
+}
+
+inline bool PhoneNumber::empty() const{
+    return length == 0;
+}
+
+inline bool PhoneNumber::operator==(const PhoneNumber & other) const{
+    return view() == other.view();
+}
+
+inline bool PhoneNumber::operator!=(const PhoneNumber & other) const{
+    return !(*this == other);
+}
+
+inline std::ostream & operator<<(std::ostream & os, const PhoneNumber & number){
+    return os << number.view();
+}
+
+};
+
+namespace std{
+
+template <>
+struct hash<cdr::PhoneNumber>{
+    size_t operator()(const cdr::PhoneNumber & number) const{
+        return hash<std::string_view>()(number.view());
+    }
+};
+
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <memory>
+
+class CallCenter;
+
+// Call center configuration reload on configuration files change.
+// Directories of the files are watched with inotify, so writes
+// replacing a file by rename (editors) are seen too. Reload waits
+// until files are quiet for debounce, then runs in the watcher thread
+// only if contents hash of the files changed.
+// Without inotify files are polled every pollPeriod.
+// CDR histories of distributions are refreshed by the watcher thread
+// every historyRefreshPeriod (every pollPeriod when polling).
+class ConfigWatcher{
+public:
+    static constexpr std::chrono::milliseconds debounce{20};
+    static constexpr std::chrono::seconds historyRefreshPeriod{60};
+
+    ConfigWatcher(std::shared_ptr<CallCenter> callCenter,
+                  const std::chrono::seconds pollPeriod);
+
+    // Blocking
+    void run();
+
+    // Reconfigures call center if contents of configuration files
+    // changed since the last reload. Returns false if not changed
+    bool reload();
+
+    // FNV-1a over contents of files, missing file is hashed as empty
+    static uint64_t hashFiles(const std::vector<std::string> & paths);
+
+private:
+    std::shared_ptr<CallCenter> callCenter;
+    std::chrono::seconds pollPeriod;
+    std::vector<std::string> paths;
+    uint64_t hash;
+
+    // Returns false if inotify can't be used
+    bool watch();
+    void poll();
+};
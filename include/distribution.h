@@ -0,0 +1,181 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Walker alias table: O(1) sampling of index i with probability
+// weights[i] / sum of weights, one random number per sample
+class AliasTable{
+public:
+    AliasTable() = default;
+    // Weights are non-negative with positive sum
+    explicit AliasTable(const std::vector<double> & weights);
+
+    // High 32 bits choose the column, low 32 bits choose
+    // between the column and its alias
+    size_t sample(const uint64_t random) const;
+    size_t size() const;
+
+private:
+    struct Column{
+        // Column is taken if low bits < threshold (2^32 - always)
+        uint64_t threshold;
+        uint32_t alias;
+    };
+
+    std::vector<Column> columns;
+};
+
+// Distribution of simulated times (seconds): call durations and
+// caller patience. Samples are rounded and clamped to the bounds
+// given by the caller. Empirical distribution is a histogram,
+// given inline or collected from exported CDR files, sampled by
+// alias table. Tables are built when the distribution is created
+// (config reading thread), sampling doesn't allocate.
+class Distribution{
+public:
+    enum class Type{
+        // Bounds only
+        uniform,
+        exponential,
+        // Logarithm is normal with mu and sigma
+        lognormal,
+        empirical
+    };
+
+    // Histogram from exported CDRs
+    enum class HistoryField{
+        // Duration of answered calls
+        callDuration,
+        // Wait of abandoned calls
+        patience
+    };
+
+    // Uniform
+    Distribution();
+    static Distribution exponential(const double mean);
+    static Distribution lognormal(const double mu, const double sigma);
+    // Values with weights. History is the CDR directory values were
+    // collected from, empty for inline histogram
+    static Distribution empirical(std::vector<double> values,
+                                  std::vector<double> weights,
+                                  const std::string & history = "");
+
+    // Parameters are finite, histogram is not empty, weights are
+    // non-negative with positive sum
+    bool isValid() const;
+
+    // Rounded to seconds, [min, max]
+    size_t sample(const size_t min, const size_t max) const;
+
+    Type getType() const;
+    double getMean() const;
+    double getMu() const;
+    double getSigma() const;
+    const std::vector<double> & getValues() const;
+    const std::vector<double> & getWeights() const;
+    const std::string & getHistory() const;
+
+    bool operator==(const Distribution & other) const;
+
+    static const char * toString(const Type type);
+    static bool parseType(const std::string & s, Type & type);
+
+    // Histogram of field in cdr-*.csv.gz and cdr-*.ndjson.gz files
+    // of dir. Returns false if dir can't be read
+    static bool readHistory(const std::string & dir, const HistoryField field,
+                            std::vector<double> & values,
+                            std::vector<double> & weights);
+
+private:
+    Type type;
+    double mean;
+    double mu;
+    double sigma;
+    std::vector<double> values;
+    std::vector<double> weights;
+    std::string history;
+    AliasTable table;
+};
+
+
+// Empirical distributions of CDR history shared by configurations.
+// A file is read again only if its size or modification time changed,
+// a directory with unchanged files gives the same distribution, so
+// configuring again doesn't read the history. Thread safe
+class HistoryCache{
+public:
+    static HistoryCache & instance();
+
+    // Empirical distribution of field in cdr-* files of dir (invalid if
+    // there are no calls). Returns nullptr if dir can't be read
+    std::shared_ptr<const Distribution> get(
+        const std::string & dir, const Distribution::HistoryField field);
+    // Distribution built by get() last, files are not checked.
+    // Returns nullptr if it was not built
+    std::shared_ptr<const Distribution> find(
+        const std::string & dir, const Distribution::HistoryField field) const;
+
+private:
+    struct File{
+        uintmax_t size;
+        int64_t mtime;
+        // By HistoryField
+        std::map<int64_t, double> histograms[2];
+    };
+    struct Built{
+        // Paths with sizes and modification times
+        std::vector<std::tuple<std::string, uintmax_t, int64_t>> files;
+        std::shared_ptr<const Distribution> distribution;
+    };
+
+    mutable std::mutex mtx;
+    std::map<std::string, File> files;
+    std::map<std::pair<std::string, Distribution::HistoryField>, Built> built;
+};
+
+
+inline size_t AliasTable::sample(const uint64_t random) const{
+    const size_t column = ((random >> 32) * columns.size()) >> 32;
+    const auto & c = columns[column];
+    return (random & 0xFFFFFFFF) < c.threshold ? column : c.alias;
+}
+
+inline size_t AliasTable::size() const{
+    return columns.size();
+}
+
+inline Distribution::Type Distribution::getType() const{
+    return type;
+}
+
+inline double Distribution::getMean() const{
+    return mean;
+}
+
+inline double Distribution::getMu() const{
+    return mu;
+}
+
+inline double Distribution::getSigma() const{
+    return sigma;
+}
+
+inline const std::vector<double> & Distribution::getValues() const{
+    return values;
+}
+
+inline const std::vector<double> & Distribution::getWeights() const{
+    return weights;
+}
+
+inline const std::string & Distribution::getHistory() const{
+    return history;
+}
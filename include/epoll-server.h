@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <string>
+
+class HttpRouter;
+
+// HTTP/1.1 ingress built on non-blocking sockets and epoll.
+// Every event loop thread has its own SO_REUSEPORT listening socket,
+// so the kernel spreads connections over loops and loops share no
+// state. Keep-alive and pipelining are supported: pipelined requests
+// are answered in order with one write.
+// Request bodies should have Content-Length (no chunked encoding).
+// Connections not sending a whole request or not reading answers for
+// 5 seconds are closed.
+// Streams (HttpRouter::stream) are polled by event loop, other
+// streaming responses (httplib content providers) are answered 501.
+class EpollServer{
+public:
+    explicit EpollServer(const HttpRouter & router);
+
+    // Blocking. nThreads == 0 - one event loop per core
+    bool listen(const std::string & host, const int port,
+                const size_t nThreads);
+
+private:
+    const HttpRouter & router;
+
+    void loop(const int listenFd) const;
+};
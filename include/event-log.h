@@ -0,0 +1,106 @@
+#pragma once
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "call-events.h"
+
+// Binary log of call state transitions.
+// Writer thread subscribes to call events and appends fixed size
+// records to a file, so recording costs the publishers nothing beyond
+// the event itself. File: header, then records in host byte order.
+// The writer waits on call events wakeup when it has written all events.
+// If the writer falls behind the ring, a lost record with the number
+// of missed events marks the gap.
+// Lossless log (opt-in) is back-pressure instead: it reserves its
+// events in the ring, so publishers (dispatcher and ingress threads)
+// wait for file writes rather than overwrite them.
+// Decoded by event-log-decode (tools).
+class EventLog{
+public:
+    static constexpr char magic[8] = {'C', 'C', 'E', 'V', 'L', 'O', 'G', '1'};
+    static constexpr uint32_t formatVersion = 1;
+    // Record type of events missed by writer
+    static constexpr uint8_t lostType = 0xFF;
+
+    struct Header{
+        char magic[8];
+        uint32_t version;
+        uint32_t recordSize;
+    };
+
+    struct Record{
+        // Unix time, nanoseconds
+        uint64_t time;
+        // Number of missed events for lost record
+        uint64_t callId;
+        uint32_t operatorId;
+        // Call queue size after the transition
+        uint32_t queueSize;
+        // CallEvents::Type or lostType
+        uint8_t type;
+        // cdr::CallStatus
+        uint8_t status;
+        uint8_t reserved[6];
+    };
+
+    // Sequential reading of log file
+    class Reader{
+    public:
+        ~Reader();
+        // Checks header
+        bool open(const std::string & path);
+        bool next(Record & record);
+
+    private:
+        FILE * file = nullptr;
+    };
+
+    explicit EventLog(const CallEvents & events);
+    ~EventLog();
+
+    // Appends records to file, empty path stops writing.
+    // Returns false if file can't be opened
+    bool setFile(const std::string & path, const bool lossless);
+    std::string getFile() const;
+    // Event records written since start
+    uint64_t getWritten() const;
+    // Events missed by writer since start
+    uint64_t getLost() const;
+
+    static Record toRecord(const CallEvents::Event & event);
+    // Event type name, "lost" for lostType
+    static const char * typeName(const uint8_t type);
+    static bool parseType(const std::string & name, uint8_t & type);
+    // One line without newline
+    static std::string toText(const Record & record);
+    static std::string toJson(const Record & record);
+
+private:
+    const CallEvents & events;
+    mutable std::mutex mtx;
+    std::string path;
+    bool lossless;
+    FILE * file;
+    std::atomic<bool> stopping;
+    std::atomic<uint64_t> written;
+    std::atomic<uint64_t> lost;
+    std::thread writer;
+
+    void stop();
+    void write(CallEvents::Subscriber subscriber);
+};
+
+inline uint64_t EventLog::getWritten() const{
+    return written.load(std::memory_order_relaxed);
+}
+
+inline uint64_t EventLog::getLost() const{
+    return lost.load(std::memory_order_relaxed);
+}
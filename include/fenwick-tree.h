@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <vector>
+
+// Fenwick (binary indexed) tree: point add and prefix sum in O(log n)
+template <typename T>
+class FenwickTree{
+public:
+    explicit FenwickTree(const size_t size = 0);
+
+    // Zeroes all size elements
+    void reset(const size_t size);
+    void add(size_t i, const T delta);
+    // Sum of elements [0, i]
+    T prefixSum(size_t i) const;
+    size_t size() const;
+
+private:
+    // 1-based
+    std::vector<T> tree;
+};
+
+template <typename T>
+inline FenwickTree<T>::FenwickTree(const size_t size) :
+    tree(size + 1)
+{}
+
+template <typename T>
+inline void FenwickTree<T>::reset(const size_t size){
+    tree.assign(size + 1, T{});
+}
+
+template <typename T>
+inline void FenwickTree<T>::add(size_t i, const T delta){
+    for (++i; i < tree.size(); i += i & (~i + 1))
+        tree[i] += delta;
+}
+
+template <typename T>
+inline T FenwickTree<T>::prefixSum(size_t i) const{
+    T sum{};
+    for (++i; i > 0; i -= i & (~i + 1))
+        sum += tree[i];
+    return sum;
+}
+
+template <typename T>
+inline size_t FenwickTree<T>::size() const{
+    return tree.size() - 1;
+}
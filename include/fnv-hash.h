@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <string_view>
+
+// 64-bit FNV-1a hash. Data of several calls is hashed as one sequence:
+// fnv::hash(fnv::hash(fnv::offset, a), b) == fnv::hash(fnv::offset, a + b)
+namespace fnv{
+
+constexpr uint64_t offset = 0xcbf29ce484222325ull;
+constexpr uint64_t prime = 0x100000001b3ull;
+
+inline uint64_t hash(uint64_t hash, std::string_view data){
+    for (auto c : data){
+        hash ^= static_cast<unsigned char>(c);
+        hash *= prime;
+    }
+    return hash;
+}
+
+};
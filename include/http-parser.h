@@ -0,0 +1,129 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <cctype>
+#include <charconv>
+#include <string_view>
+
+#include "httplib.h"
+
+// HTTP/1.x request parser of epoll ingress. Fills httplib::Request,
+// so requests are routed by HttpRouter like requests of httplib server.
+// Request bodies should have Content-Length (no chunked encoding).
+namespace http{
+
+constexpr size_t maxHeaderSize = 8192;
+constexpr size_t maxBodySize = 4 << 20;
+
+enum class ParseResult{
+    incomplete,
+    complete,
+    error
+};
+
+// Parses one request from the beginning of data, consumed is its size
+// (requests may be pipelined).
+// On error status is HTTP status to answer with
+ParseResult parseRequest(std::string_view data, httplib::Request & req,
+                         size_t & consumed, int & status);
+// Connection is kept after answer
+bool isKeepAlive(const httplib::Request & req);
+
+
+namespace detail{
+
+inline std::string_view trim(std::string_view s){
+    auto begin = s.find_first_not_of(" \t");
+    if (begin == std::string_view::npos)
+        return {};
+    return s.substr(begin, s.find_last_not_of(" \t") - begin + 1);
+}
+
+inline bool equalsNoCase(std::string_view a, std::string_view b){
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); ++i)
+        if (std::tolower(a[i]) != std::tolower(b[i]))
+            return false;
+    return true;
+}
+
+};
+
+inline ParseResult parseRequest(std::string_view data,
+                                httplib::Request & req,
+                                size_t & consumed, int & status){
+    auto headerEnd = data.find("\r\n\r\n");
+    if (headerEnd == std::string_view::npos){
+        status = 431;
+        return data.size() > maxHeaderSize ? ParseResult::error :
+                                             ParseResult::incomplete;
+    }
+    status = 400;
+    auto lineEnd = data.find("\r\n");
+    auto requestLine = data.substr(0, lineEnd);
+    auto methodEnd = requestLine.find(' ');
+    auto targetEnd = requestLine.rfind(' ');
+    if (methodEnd == std::string_view::npos || targetEnd <= methodEnd)
+        return ParseResult::error;
+    auto version = requestLine.substr(targetEnd + 1);
+    if (version.substr(0, 7) != "HTTP/1.")
+        return ParseResult::error;
+    req.method.assign(requestLine.substr(0, methodEnd));
+    req.target.assign(requestLine.substr(methodEnd + 1,
+                                         targetEnd - methodEnd - 1));
+    req.version.assign(version);
+
+    size_t contentLength = 0;
+    auto headers = data.substr(lineEnd + 2, headerEnd - lineEnd);
+    while (!headers.empty()){
+        auto end = headers.find("\r\n");
+        auto line = headers.substr(0, end);
+        headers.remove_prefix(end + 2);
+        if (line.empty())
+            continue;
+        auto colon = line.find(':');
+        if (colon == std::string_view::npos)
+            return ParseResult::error;
+        auto name = line.substr(0, colon);
+        auto value = detail::trim(line.substr(colon + 1));
+        if (detail::equalsNoCase(name, "Content-Length")){
+            auto [ptr, ec] = std::from_chars(value.data(),
+                                             value.data() + value.size(),
+                                             contentLength);
+            if (ec != std::errc() || ptr != value.data() + value.size())
+                return ParseResult::error;
+        }
+        else if (detail::equalsNoCase(name, "Transfer-Encoding")){
+            status = 501;
+            return ParseResult::error;
+        }
+        req.headers.emplace(std::string(name), std::string(value));
+    }
+    if (contentLength > maxBodySize){
+        status = 413;
+        return ParseResult::error;
+    }
+    const auto bodyBegin = headerEnd + 4;
+    if (data.size() < bodyBegin + contentLength)
+        return ParseResult::incomplete;
+    req.body.assign(data.substr(bodyBegin, contentLength));
+    consumed = bodyBegin + contentLength;
+
+    auto query = req.target.find('?');
+    req.path = httplib::detail::decode_url(req.target.substr(0, query), false);
+    if (query != std::string::npos)
+        httplib::detail::parse_query_text(req.target.substr(query + 1),
+                                          req.params);
+    return ParseResult::complete;
+}
+
+inline bool isKeepAlive(const httplib::Request & req){
+    auto connection = req.get_header_value("Connection");
+    if (req.version == "HTTP/1.0")
+        return detail::equalsNoCase(connection, "keep-alive");
+    return !detail::equalsNoCase(connection, "close");
+}
+
+};
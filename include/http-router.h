@@ -0,0 +1,198 @@
+#pragma once
+
+#include <regex>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <functional>
+
+#include "httplib.h"
+
+#include "wakeup.h"
+#include "request-arena.h"
+
+// HTTP routes shared by ingresses (httplib server and epoll ingress),
+// so every ingress serves the same API with the same handlers.
+// Routes are matched in registration order, like in httplib.
+// Request arena of the thread is reset after every handler.
+class HttpRouter{
+public:
+    using Handler = httplib::Server::Handler;
+    // Long lived response body (Server-Sent Events). Called repeatedly,
+    // appends available data to out without blocking.
+    // Returns false when stream is finished (out is still sent)
+    using StreamPoll = std::function<bool(std::string & out)>;
+    // Returns nullptr to answer with res as usual
+    using StreamHandler = std::function<StreamPoll(const httplib::Request &,
+                                                   httplib::Response &)>;
+
+    // Streams are polled when stream wakeup is notified and at least
+    // with this interval (streams without wakeup only with it)
+    static constexpr std::chrono::milliseconds streamPollInterval{1000};
+
+    HttpRouter & get(const std::string & pattern, Handler handler);
+    HttpRouter & post(const std::string & pattern, Handler handler);
+    HttpRouter & del(const std::string & pattern, Handler handler);
+    HttpRouter & patch(const std::string & pattern, Handler handler);
+    // GET route answering with stream
+    HttpRouter & stream(const std::string & pattern, StreamHandler handler);
+    // Notified when streams may have new data
+    void setStreamWakeup(Wakeup & wakeup);
+    Wakeup * getStreamWakeup() const;
+
+    // Registers routes in httplib server
+    void mount(httplib::Server & svr) const;
+    // Calls matching handler, filling req.matches.
+    // stream is set if handler started a stream.
+    // Returns false if there is no route for request
+    bool route(httplib::Request & req, httplib::Response & res,
+               StreamPoll & stream) const;
+
+private:
+    struct Route{
+        std::string method;
+        std::string pattern;
+        std::regex regex;
+        // Pattern without regex special chars is compared as string
+        bool exact;
+        Handler handler;
+        StreamHandler streamHandler;
+    };
+    std::vector<Route> routes;
+    Wakeup * streamWakeup = nullptr;
+
+    HttpRouter & add(const std::string & method, const std::string & pattern,
+                     Handler handler, StreamHandler streamHandler = nullptr);
+    Handler toHttplibHandler(StreamHandler handler) const;
+    static Handler withArenaReset(Handler handler);
+};
+
+
+inline HttpRouter & HttpRouter::get(const std::string & pattern,
+                                    Handler handler){
+    return add("GET", pattern, std::move(handler));
+}
+
+inline HttpRouter & HttpRouter::post(const std::string & pattern,
+                                     Handler handler){
+    return add("POST", pattern, std::move(handler));
+}
+
+inline HttpRouter & HttpRouter::del(const std::string & pattern,
+                                    Handler handler){
+    return add("DELETE", pattern, std::move(handler));
+}
+
+inline HttpRouter & HttpRouter::patch(const std::string & pattern,
+                                      Handler handler){
+    return add("PATCH", pattern, std::move(handler));
+}
+
+inline HttpRouter & HttpRouter::stream(const std::string & pattern,
+                                       StreamHandler handler){
+    return add("GET", pattern, nullptr, std::move(handler));
+}
+
+inline void HttpRouter::setStreamWakeup(Wakeup & wakeup){
+    streamWakeup = &wakeup;
+}
+
+inline Wakeup * HttpRouter::getStreamWakeup() const{
+    return streamWakeup;
+}
+
+inline HttpRouter & HttpRouter::add(const std::string & method,
+                                    const std::string & pattern,
+                                    Handler handler,
+                                    StreamHandler streamHandler){
+    bool exact = pattern.find_first_of("\\^$.|?*+()[]{}") == std::string::npos;
+    routes.push_back({method, pattern, std::regex(pattern), exact,
+                      std::move(handler), std::move(streamHandler)});
+    return *this;
+}
+
+// httplib calls content provider from connection thread
+// until it is done, so poll waits when stream has no data
+inline HttpRouter::Handler HttpRouter::toHttplibHandler(
+    StreamHandler handler) const{
+    return [handler, wakeup = streamWakeup](const httplib::Request & req,
+                                            httplib::Response & res){
+        auto poll = handler(req, res);
+        RequestArena::local().reset();
+        if (!poll)
+            return;
+        auto contentType = res.get_header_value("Content-Type");
+        res.headers.erase("Content-Type");
+        res.set_chunked_content_provider(contentType,
+            [poll, wakeup, out = std::string()](size_t,
+                                                httplib::DataSink & sink) mutable{
+                out.clear();
+                bool more = poll(out);
+                if (more && out.empty()){
+                    if (wakeup){
+                        // Polled again after prepare(), so data written
+                        // after the first poll is not waited for
+                        const auto ticket = wakeup->prepare();
+                        more = poll(out);
+                        if (more && out.empty())
+                            wakeup->wait(ticket, streamPollInterval);
+                    }
+                    else
+                        std::this_thread::sleep_for(streamPollInterval);
+                }
+                if (!out.empty() && !sink.write(out.data(), out.size()))
+                    return false;
+                if (!more)
+                    sink.done();
+                return true;
+            });
+    };
+}
+
+inline HttpRouter::Handler HttpRouter::withArenaReset(Handler handler){
+    return [handler](const httplib::Request & req, httplib::Response & res){
+        handler(req, res);
+        RequestArena::local().reset();
+    };
+}
+
+inline void HttpRouter::mount(httplib::Server & svr) const{
+    for (auto & route : routes){
+        if (route.streamHandler)
+            svr.Get(route.pattern, toHttplibHandler(route.streamHandler));
+        else if (route.method == "GET")
+            svr.Get(route.pattern, withArenaReset(route.handler));
+        else if (route.method == "POST")
+            svr.Post(route.pattern, withArenaReset(route.handler));
+        else if (route.method == "DELETE")
+            svr.Delete(route.pattern, withArenaReset(route.handler));
+        else if (route.method == "PATCH")
+            svr.Patch(route.pattern, withArenaReset(route.handler));
+    }
+}
+
+inline bool HttpRouter::route(httplib::Request & req,
+                              httplib::Response & res,
+                              StreamPoll & stream) const{
+    // HEAD is served by GET handlers
+    const bool isHead = req.method == "HEAD";
+    for (auto & route : routes){
+        if (route.method != req.method && !(isHead && route.method == "GET"))
+            continue;
+        if (route.exact){
+            if (req.path != route.pattern)
+                continue;
+            req.matches = std::smatch();
+        }
+        else if (!std::regex_match(req.path, req.matches, route.regex))
+            continue;
+        if (route.streamHandler)
+            stream = route.streamHandler(req, res);
+        else
+            route.handler(req, res);
+        RequestArena::local().reset();
+        return true;
+    }
+    return false;
+}
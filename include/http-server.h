@@ -1,10 +1,28 @@
 #pragma once
 #include <string>
 #include <memory>
+#include <stddef.h>
 
 class CallCenter;
 
 class HttpServer{
 public:
+    enum class Ingress{
+        // httplib thread pool server
+        httplib,
+        // Event loop per core (EpollServer)
+        epoll
+    };
+
+    HttpServer();
+
     bool listen(const std::string &host, const int port, std::shared_ptr<CallCenter> callCenter);
+
+    // nThreads is number of epoll event loops, 0 - one per core
+    void setIngress(const Ingress ingress, const size_t nThreads = 0);
+    static bool parseIngress(const std::string & str, Ingress & ingress);
+
+private:
+    Ingress ingress;
+    size_t nThreads;
 };
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Snowflake style call id generator.
+// Id layout (63 bits, so ids stay positive as signed integers):
+//   41 bits - milliseconds since 2024-01-01 UTC
+//    8 bits - node id (call center instance)
+//    6 bits - lane (generating thread)
+//    8 bits - sequence within the millisecond
+// Every thread owns a lane, so ids are generated without shared
+// writes. If a lane runs out of sequence numbers within a millisecond,
+// it borrows the next millisecond instead of waiting.
+// Ids are unique across nodes and across restarts, unless the system
+// clock is moved back.
+namespace idgen{
+
+constexpr unsigned timeBits = 41;
+constexpr unsigned nodeBits = 8;
+constexpr unsigned laneBits = 6;
+constexpr unsigned sequenceBits = 8;
+
+constexpr uint32_t maxNodeId = (1u << nodeBits) - 1;
+
+uint64_t next();
+
+bool setNodeId(const uint32_t nodeId);
+uint32_t getNodeId();
+
+// Id fields
+uint64_t getTime(const uint64_t id);
+uint32_t getNodeId(const uint64_t id);
+uint32_t getLane(const uint64_t id);
+uint32_t getSequence(const uint64_t id);
+
+// Unix time (milliseconds) of id time field
+int64_t toUnixTimeMs(const uint64_t idTime);
+
+};
+
+
+inline uint64_t idgen::getTime(const uint64_t id){
+    return id >> (nodeBits + laneBits + sequenceBits);
+}
+
+inline uint32_t idgen::getNodeId(const uint64_t id){
+    return (id >> (laneBits + sequenceBits)) & maxNodeId;
+}
+
+inline uint32_t idgen::getLane(const uint64_t id){
+    return (id >> sequenceBits) & ((1u << laneBits) - 1);
+}
+
+inline uint32_t idgen::getSequence(const uint64_t id){
+    return id & ((1u << sequenceBits) - 1);
+}
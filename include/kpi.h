@@ -0,0 +1,135 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <atomic>
+
+#include "cdr.h"
+
+// Real-time call center KPIs over sliding windows.
+// Every window is a ring of buckets with atomic counters: an update
+// touches one bucket per window (O(1)) and reads never block updates.
+// Counters of a bucket being reused are reset by the first thread
+// entering the new time slot.
+class Kpi{
+public:
+    enum class Window{
+        m1,
+        m5,
+        m15,
+        h1
+    };
+    static constexpr size_t nWindows = 4;
+
+    struct Snapshot{
+        // Window length (seconds)
+        size_t window;
+        // Calls received (including rejected ones)
+        uint64_t offered;
+        // Calls not placed in queue (overload, alreadyInQueue)
+        uint64_t rejected;
+        uint64_t answered;
+        // Calls answered within service level time
+        uint64_t answeredInTime;
+        uint64_t timedOut;
+        // Calls cancelled while waiting in queue
+        uint64_t abandoned;
+        uint64_t ended;
+        // Sum of answered calls waiting time (seconds)
+        uint64_t waitTime;
+        // Sum of ended calls handle time (seconds)
+        uint64_t handleTime;
+
+        // Average speed of answer (seconds)
+        double getAverageSpeedOfAnswer() const;
+        // Share of answered calls answered within service level time
+        double getServiceLevel() const;
+        // Share of calls left queue by timeout
+        double getTimeoutRate() const;
+        // Average handle time (seconds)
+        double getAverageHandleTime() const;
+    };
+
+    Kpi();
+
+    void onPush(const cdr::CallStatus callStatus,
+                const cdr::Seconds now = cdr::now());
+    void onAnswer(const cdr::Seconds waitTime,
+                  const cdr::Seconds now = cdr::now());
+    void onTimeout(const cdr::Seconds now = cdr::now());
+    void onAbandon(const cdr::Seconds now = cdr::now());
+    void onEnd(const cdr::Seconds handleTime,
+               const cdr::Seconds now = cdr::now());
+
+    Snapshot get(const Window window,
+                 const cdr::Seconds now = cdr::now()) const;
+
+    void setServiceLevelTime(const size_t serviceLevelTime);
+    size_t getServiceLevelTime() const;
+
+    static const char * toString(const Window window);
+
+private:
+    enum Counter{
+        offered,
+        rejected,
+        answered,
+        answeredInTime,
+        timedOut,
+        abandoned,
+        ended,
+        waitTime,
+        handleTime,
+        nCounters
+    };
+    static constexpr size_t nBuckets = 60;
+    // Bucket is being reset
+    static constexpr uint32_t resetting = UINT32_MAX;
+
+    struct alignas(64) Bucket{
+        // Time slot (now / bucket width) the counters belong to
+        std::atomic<uint32_t> slot{0};
+        std::array<std::atomic<uint64_t>, nCounters> counters{};
+    };
+    struct Ring{
+        // Seconds
+        uint32_t bucketWidth;
+        std::array<Bucket, nBuckets> buckets;
+    };
+    std::array<Ring, nWindows> rings;
+    std::atomic<size_t> serviceLevelTime;
+
+    template <size_t N>
+    void add(const std::array<Counter, N> & counters,
+             const std::array<uint64_t, N> & values,
+             const cdr::Seconds now);
+    static Bucket & getBucket(Ring & ring, const uint32_t slot);
+};
+
+
+inline void Kpi::setServiceLevelTime(const size_t serviceLevelTime){
+    this->serviceLevelTime = serviceLevelTime;
+}
+
+inline size_t Kpi::getServiceLevelTime() const{
+    return serviceLevelTime;
+}
+
+inline double Kpi::Snapshot::getAverageSpeedOfAnswer() const{
+    return answered ? static_cast<double>(waitTime) / answered : 0;
+}
+
+inline double Kpi::Snapshot::getServiceLevel() const{
+    return answered ? static_cast<double>(answeredInTime) / answered : 0;
+}
+
+inline double Kpi::Snapshot::getTimeoutRate() const{
+    return answered + timedOut ?
+        static_cast<double>(timedOut) / (answered + timedOut) : 0;
+}
+
+inline double Kpi::Snapshot::getAverageHandleTime() const{
+    return ended ? static_cast<double>(handleTime) / ended : 0;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "cdr.h"
+
+// Service counters in Prometheus text format.
+// Every thread writes its own cache line aligned counters with plain
+// load and store (no locked instructions, no shared lines), a scrape
+// sums counters of all threads. Counters of finished threads are
+// kept, so totals never decrease.
+class Metrics{
+public:
+    static constexpr size_t nStatuses = std::size(cdr::statusNames);
+
+    struct alignas(64) Counters{
+        // pushCall() results by CallStatus
+        std::array<std::atomic<uint64_t>, nStatuses> pushed{};
+        // Rejected by load shedding before pushing
+        std::atomic<uint64_t> shed{0};
+        std::atomic<uint64_t> dispatcherIterations{0};
+        // Gauges written by dispatcher
+        std::atomic<uint64_t> freeOperators{0};
+        std::atomic<uint64_t> servicedCalls{0};
+    };
+
+    struct Snapshot{
+        std::array<uint64_t, nStatuses> pushed;
+        uint64_t shed;
+        uint64_t dispatcherIterations;
+        uint64_t freeOperators;
+        uint64_t servicedCalls;
+        // Filled by call center
+        uint64_t callQueueSize;
+        uint64_t eventLogWritten;
+        uint64_t eventLogLost;
+    };
+
+    Metrics();
+
+    // Counters of the calling thread
+    Counters & local();
+    void onPush(const cdr::CallStatus status);
+    void onShed(const size_t nCalls);
+    // Single writer increment
+    static void add(std::atomic<uint64_t> & counter, const uint64_t n);
+
+    Snapshot collect() const;
+    // Text exposition format 0.0.4
+    static std::string format(const Snapshot & snapshot);
+
+private:
+    const uint64_t id;
+    mutable std::mutex countersMtx;
+    std::vector<std::shared_ptr<Counters>> counters;
+};
+
+
+inline void Metrics::add(std::atomic<uint64_t> & counter, const uint64_t n){
+    counter.store(counter.load(std::memory_order_relaxed) + n,
+                  std::memory_order_relaxed);
+}
+
+inline void Metrics::onPush(const cdr::CallStatus status){
+    add(local().pushed[static_cast<size_t>(status)], 1);
+}
+
+inline void Metrics::onShed(const size_t nCalls){
+    add(local().shed, nCalls);
+}
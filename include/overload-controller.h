@@ -0,0 +1,99 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <atomic>
+
+#include "cdr.h"
+
+// Load shedding for HTTP ingress.
+// Decides on lock-free call queue size and rolling arrival and drain
+// (calls taken from queue by dispatcher) rates, so shed calls cost
+// no call queue work. Retry-After is the expected time until a place
+// in the queue frees up for the caller.
+class OverloadController{
+public:
+    // Rates are averaged over this many last complete seconds
+    static constexpr size_t rateWindow = 10;
+    static constexpr uint32_t maxRetryAfter = 60;
+
+    struct Snapshot{
+        bool enabled;
+        uint64_t shed;
+        // Calls per second
+        double arrivalRate;
+        double drainRate;
+    };
+
+    OverloadController();
+
+    // Calls offered to call center, including shed ones
+    void onArrival(const size_t nCalls = 1,
+                   const cdr::Seconds now = cdr::now());
+    // Call taken from queue by dispatcher
+    void onDeparture(const cdr::Seconds now = cdr::now());
+
+    // Returns true if nCalls should be rejected. retryAfter - seconds
+    bool shed(const size_t nCalls, const size_t queueSize,
+              const size_t maxQueueSize, uint32_t & retryAfter,
+              const cdr::Seconds now = cdr::now());
+
+    double getArrivalRate(const cdr::Seconds now = cdr::now()) const;
+    double getDrainRate(const cdr::Seconds now = cdr::now()) const;
+    Snapshot get(const cdr::Seconds now = cdr::now()) const;
+
+    void setEnabled(const bool enabled);
+    bool isEnabled() const;
+
+private:
+    static constexpr size_t nBuckets = 16;
+    static_assert(nBuckets > rateWindow);
+    // Bucket is being reset
+    static constexpr uint32_t resetting = UINT32_MAX;
+
+    // Counts of one second
+    struct alignas(64) Bucket{
+        // Second + 1, 0 - never used
+        std::atomic<uint32_t> slot{0};
+        std::atomic<uint64_t> count{0};
+    };
+    struct Rate{
+        std::array<Bucket, nBuckets> buckets;
+
+        void add(const uint64_t n, const cdr::Seconds now);
+        double get(const cdr::Seconds now) const;
+    };
+
+    Rate arrivals;
+    Rate departures;
+    std::atomic<uint64_t> nShed;
+    std::atomic<bool> enabled;
+};
+
+
+inline void OverloadController::onArrival(const size_t nCalls,
+                                          const cdr::Seconds now){
+    arrivals.add(nCalls, now);
+}
+
+inline void OverloadController::onDeparture(const cdr::Seconds now){
+    departures.add(1, now);
+}
+
+inline double OverloadController::getArrivalRate(const cdr::Seconds now) const{
+    return arrivals.get(now);
+}
+
+inline double OverloadController::getDrainRate(const cdr::Seconds now) const{
+    return departures.get(now);
+}
+
+inline void OverloadController::setEnabled(const bool enabled){
+    this->enabled = enabled;
+}
+
+inline bool OverloadController::isEnabled() const{
+    return enabled;
+}
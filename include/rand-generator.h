@@ -0,0 +1,101 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+
+// Thread local pseudo random numbers (xoshiro256**, Blackman and Vigna).
+// Every thread gets its own stream: the seed is expanded by splitmix64,
+// the n-th thread using the generator jumps 2^128 outputs n times, so
+// streams never overlap. With a fixed seed the stream of a thread is
+// reproducible if threads start using the generator in the same order
+// (dispatcher is the only one drawing call durations).
+// Batch functions draw from 4 interleaved streams, so the compiler
+// vectorizes them.
+namespace rndgen{
+
+class Xoshiro256{
+public:
+    using result_type = uint64_t;
+
+    // State expanded from seed by splitmix64
+    explicit Xoshiro256(const uint64_t seed = 0);
+    explicit Xoshiro256(const std::array<uint64_t, 4> & state);
+
+    uint64_t operator()();
+    // Advances 2^128 outputs
+    void jump();
+    const std::array<uint64_t, 4> & getState() const;
+
+    static constexpr uint64_t min(){
+        return 0;
+    }
+    static constexpr uint64_t max(){
+        return UINT64_MAX;
+    }
+
+private:
+    std::array<uint64_t, 4> s;
+};
+
+// 4 independent streams stepped together.
+// Output i is output i / 4 of stream i % 4.
+// Stream k is first generator jumped k times
+class Xoshiro256x4{
+public:
+    static constexpr size_t lanes = 4;
+
+    explicit Xoshiro256x4(Xoshiro256 first = Xoshiro256());
+
+    void fill(uint64_t * out, const size_t n);
+
+private:
+    // Word of state by lane, so lanes are stepped by vector operations
+    alignas(32) uint64_t s[4][lanes];
+    // Not returned outputs of the last step
+    alignas(32) uint64_t buffered[lanes];
+    size_t nBuffered;
+
+    void step(uint64_t * out);
+};
+
+// 0 - random seed (std::random_device). Threads reseed on their next draw
+void setSeed(const uint64_t seed);
+// Seed in use, the random one if 0 was set
+uint64_t getSeed();
+
+uint64_t next();
+// Uniform in [min, max], unbiased
+uint64_t uniform(const uint64_t min, const uint64_t max);
+// Uniform in [0, 1), 53 bits
+double uniform01();
+
+void fill(uint64_t * out, const size_t n);
+// Uniform in [min, max]. Bias is below (max - min + 1) / 2^32
+void fillUniform(const uint32_t min, const uint32_t max,
+                 uint32_t * out, const size_t n);
+// Uniform in [0, 1), 53 bits
+void fillUniform01(double * out, const size_t n);
+
+};
+
+
+inline uint64_t rndgen::Xoshiro256::operator()(){
+    auto rotl = [](const uint64_t x, const int k){
+        return (x << k) | (x >> (64 - k));
+    };
+    const uint64_t result = rotl(s[1] * 5, 7) * 9;
+    const uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return result;
+}
+
+inline const std::array<uint64_t, 4> & rndgen::Xoshiro256::getState() const{
+    return s;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <array>
+#include <cstddef>
+#include <memory_resource>
+
+// Per-worker arena for request scoped allocations of HTTP handlers.
+// Handlers take temporaries (flags of batch calls) from the arena of
+// their thread, HttpRouter resets it after every response.
+// Allocations are pointer bumps in a buffer reused by every request,
+// the global heap is used only by requests outgrowing the buffer.
+// Memory from the arena must not outlive the handler.
+class RequestArena{
+public:
+    static constexpr size_t bufferSize = 64 << 10;
+
+    struct Stats{
+        // Allocations from the arena
+        size_t allocations;
+        size_t bytes;
+        // Arena chunks allocated on the global heap
+        size_t heapAllocations;
+    };
+
+    // Arena of the calling thread
+    static RequestArena & local();
+
+    std::pmr::memory_resource * get();
+    // Frees everything allocated since previous reset
+    void reset();
+    // Since previous reset
+    Stats getStats() const;
+    // Stats of the last request before reset (test hook)
+    Stats getLastStats() const;
+
+private:
+    // Counts allocations passed to upstream
+    class Counter : public std::pmr::memory_resource{
+    public:
+        explicit Counter(std::pmr::memory_resource * upstream);
+
+        size_t allocations;
+        size_t bytes;
+
+    private:
+        std::pmr::memory_resource * upstream;
+
+        void * do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void * p, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource & other)
+            const noexcept override;
+    };
+
+    alignas(std::max_align_t) std::array<std::byte, bufferSize> buffer;
+    Counter heap;
+    std::pmr::monotonic_buffer_resource monotonic;
+    Counter arena;
+    Stats lastStats;
+
+    RequestArena();
+};
+
+
+inline std::pmr::memory_resource * RequestArena::get(){
+    return &arena;
+}
+
+inline RequestArena::Stats RequestArena::getStats() const{
+    return {arena.allocations, arena.bytes, heap.allocations};
+}
+
+inline RequestArena::Stats RequestArena::getLastStats() const{
+    return lastStats;
+}
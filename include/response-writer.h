@@ -0,0 +1,96 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <charconv>
+#include <string_view>
+
+#include "cdr.h"
+
+// Allocation free JSON answers.
+// Answers are formatted into a per-thread buffer reused by every
+// request, so returned view is valid until the next call from the
+// same thread. Output is byte identical to nlohmann::json::dump().
+namespace response{
+
+// {"call_id":<callId>,"call_status":"<callStatus>"}
+std::string_view writeCallAnswer(const uint64_t callId,
+                                 const cdr::CallStatus callStatus);
+// {"call_id":<callId>,"call_status":"<callStatus>",
+// "estimated_wait":<estimatedWait>,"position":<position>}
+std::string_view writeCallAnswer(const uint64_t callId,
+                                 const cdr::CallStatus callStatus,
+                                 const uint64_t position,
+                                 const uint32_t estimatedWait);
+// {"call_id":<callId>,"estimated_wait":<estimatedWait>,
+// "position":<position>}
+std::string_view writePositionAnswer(const uint64_t callId,
+                                     const uint64_t position,
+                                     const uint32_t estimatedWait);
+
+
+namespace detail{
+
+constexpr std::string_view callIdKey = "{\"call_id\":";
+constexpr std::string_view callStatusKey = ",\"call_status\":\"";
+constexpr std::string_view callAnswerEnd = "\"}";
+// Longest status name is "callDuplication"
+constexpr size_t maxCallAnswerSize = callIdKey.size() + 20 +
+    callStatusKey.size() + 15 + callAnswerEnd.size();
+constexpr std::string_view statusEstimatedWaitKey = "\",\"estimated_wait\":";
+constexpr std::string_view positionKey = ",\"position\":";
+constexpr std::string_view estimatedWaitKey = ",\"estimated_wait\":";
+constexpr size_t maxPositionAnswerSize = maxCallAnswerSize +
+    statusEstimatedWaitKey.size() + 10 + positionKey.size() + 20;
+
+inline char * append(char * out, std::string_view s){
+    for (auto c : s)
+        *out++ = c;
+    return out;
+}
+
+};
+
+inline std::string_view writeCallAnswer(const uint64_t callId,
+                                        const cdr::CallStatus callStatus){
+    thread_local char buffer[detail::maxCallAnswerSize];
+    char * out = detail::append(buffer, detail::callIdKey);
+    out = std::to_chars(out, out + 20, callId).ptr;
+    out = detail::append(out, detail::callStatusKey);
+    out = detail::append(out, cdr::statusName(callStatus));
+    out = detail::append(out, detail::callAnswerEnd);
+    return std::string_view(buffer, out - buffer);
+}
+
+inline std::string_view writeCallAnswer(const uint64_t callId,
+                                        const cdr::CallStatus callStatus,
+                                        const uint64_t position,
+                                        const uint32_t estimatedWait){
+    thread_local char buffer[detail::maxPositionAnswerSize];
+    char * out = detail::append(buffer, detail::callIdKey);
+    out = std::to_chars(out, out + 20, callId).ptr;
+    out = detail::append(out, detail::callStatusKey);
+    out = detail::append(out, cdr::statusName(callStatus));
+    out = detail::append(out, detail::statusEstimatedWaitKey);
+    out = std::to_chars(out, out + 10, estimatedWait).ptr;
+    out = detail::append(out, detail::positionKey);
+    out = std::to_chars(out, out + 20, position).ptr;
+    *out++ = '}';
+    return std::string_view(buffer, out - buffer);
+}
+
+inline std::string_view writePositionAnswer(const uint64_t callId,
+                                            const uint64_t position,
+                                            const uint32_t estimatedWait){
+    thread_local char buffer[detail::maxPositionAnswerSize];
+    char * out = detail::append(buffer, detail::callIdKey);
+    out = std::to_chars(out, out + 20, callId).ptr;
+    out = detail::append(out, detail::estimatedWaitKey);
+    out = std::to_chars(out, out + 10, estimatedWait).ptr;
+    out = detail::append(out, detail::positionKey);
+    out = std::to_chars(out, out + 20, position).ptr;
+    *out++ = '}';
+    return std::string_view(buffer, out - buffer);
+}
+
+};
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <limits>
+#include <string>
+#include <vector>
+#include <optional>
+
+// Time of day windows overriding dispatching parameters.
+// Window times are seconds since local midnight. Window with
+// begin > end crosses midnight. Overlapping windows are allowed,
+// the first one listed wins. Outside of all windows base parameters
+// are used.
+class Schedule{
+public:
+    static constexpr uint32_t secondsPerDay = 24 * 60 * 60;
+    static constexpr size_t noWindow = std::numeric_limits<size_t>::max();
+
+    struct Window{
+        // [begin, end)
+        uint32_t begin;
+        uint32_t end;
+        // Not set parameters are base ones
+        std::optional<size_t> nOperators;
+        std::optional<size_t> maxCallQueueSize;
+        std::optional<size_t> minResponseTime;
+        std::optional<size_t> maxResponseTime;
+
+        bool contains(const uint32_t secondOfDay) const;
+        bool operator==(const Window & other) const;
+    };
+
+    // Returns false for invalid window times
+    bool add(const Window & window);
+    const std::vector<Window> & getWindows() const;
+    bool isEmpty() const;
+
+    // Index of window active at secondOfDay or noWindow
+    size_t find(const uint32_t secondOfDay) const;
+    // Seconds from secondOfDay until the next window begin or end,
+    // (0, secondsPerDay]
+    uint32_t secondsToBoundary(const uint32_t secondOfDay) const;
+
+    // "HH:MM" or "HH:MM:SS"
+    static bool parseTime(const std::string & s, uint32_t & secondOfDay);
+    static std::string formatTime(const uint32_t secondOfDay);
+    // Local time of day
+    static uint32_t secondOfDay(const int64_t unixTime);
+
+    bool operator==(const Schedule & other) const;
+
+private:
+    std::vector<Window> windows;
+};
+
+inline const std::vector<Schedule::Window> & Schedule::getWindows() const{
+    return windows;
+}
+
+inline bool Schedule::isEmpty() const{
+    return windows.empty();
+}
+
+inline bool Schedule::operator==(const Schedule & other) const{
+    return windows == other.windows;
+}
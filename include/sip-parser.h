@@ -0,0 +1,186 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <charconv>
+#include <string_view>
+
+// Minimal SIP request parser and response writer for INVITE ingest.
+// Parsing doesn't copy: all fields point into the datagram.
+// Only headers needed to answer the request are parsed, compact
+// header names (v, f, t, i) are supported.
+namespace sip{
+
+constexpr size_t maxVias = 8;
+
+struct Request{
+    std::string_view method;
+    // Header values
+    std::array<std::string_view, maxVias> vias;
+    size_t nVias = 0;
+    std::string_view from;
+    std::string_view to;
+    std::string_view callId;
+    std::string_view cseq;
+    // User part of From URI (phone number)
+    std::string_view fromUser;
+};
+
+// Returns false if request line or needed headers are missing
+bool parseRequest(std::string_view data, Request & request);
+// User part of sip:, sips: or tel: URI in From/To header value
+std::string_view parseUser(std::string_view header);
+
+// Response size is at most request size + maxResponseOverhead
+constexpr size_t maxResponseOverhead = 256;
+// To header gets tag if it has none.
+// retryAfter != 0 adds Retry-After header
+char * writeResponse(char * out, const Request & request, const int code,
+                     std::string_view reason, const uint64_t tag,
+                     const uint32_t retryAfter = 0);
+
+
+namespace detail{
+
+inline bool equalsNoCase(std::string_view a, std::string_view b){
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); ++i){
+        char c = a[i];
+        if (c >= 'A' && c <= 'Z')
+            c += 'a' - 'A';
+        if (c != b[i])
+            return false;
+    }
+    return true;
+}
+
+inline std::string_view trim(std::string_view s){
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t'))
+        s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t' ||
+                          s.back() == '\r'))
+        s.remove_suffix(1);
+    return s;
+}
+
+inline char * append(char * out, std::string_view s){
+    for (auto c : s)
+        *out++ = c;
+    return out;
+}
+
+inline char * appendHeader(char * out, std::string_view name,
+                           std::string_view value){
+    out = append(out, name);
+    out = append(out, ": ");
+    out = append(out, value);
+    return append(out, "\r\n");
+}
+
+};
+
+inline std::string_view parseUser(std::string_view header){
+    // Display name may contain "sip:", URI is in <> then
+    auto begin = header.find('<');
+    if (begin != std::string_view::npos){
+        auto end = header.find('>', begin);
+        if (end == std::string_view::npos)
+            return {};
+        header = header.substr(begin + 1, end - begin - 1);
+    }
+    auto colon = header.find(':');
+    if (colon == std::string_view::npos)
+        return {};
+    auto scheme = header.substr(0, colon);
+    if (!detail::equalsNoCase(scheme, "sip") &&
+        !detail::equalsNoCase(scheme, "sips") &&
+        !detail::equalsNoCase(scheme, "tel"))
+        return {};
+    auto user = header.substr(colon + 1);
+    return user.substr(0, user.find_first_of("@;>? "));
+}
+
+inline bool parseRequest(std::string_view data, Request & request){
+    auto lineEnd = data.find('\n');
+    if (lineEnd == std::string_view::npos)
+        return false;
+    auto requestLine = detail::trim(data.substr(0, lineEnd));
+    auto methodEnd = requestLine.find(' ');
+    if (methodEnd == std::string_view::npos ||
+        requestLine.substr(requestLine.rfind(' ') + 1) != "SIP/2.0")
+        return false;
+    request.method = requestLine.substr(0, methodEnd);
+    request.nVias = 0;
+    request.from = request.to = request.callId = request.cseq = {};
+
+    data.remove_prefix(lineEnd + 1);
+    while (!data.empty()){
+        lineEnd = data.find('\n');
+        auto line = detail::trim(data.substr(0, lineEnd));
+        data.remove_prefix(lineEnd == std::string_view::npos ?
+                           data.size() : lineEnd + 1);
+        // Body follows empty line
+        if (line.empty())
+            break;
+        auto colon = line.find(':');
+        if (colon == std::string_view::npos)
+            return false;
+        auto name = detail::trim(line.substr(0, colon));
+        auto value = detail::trim(line.substr(colon + 1));
+        if (detail::equalsNoCase(name, "via") ||
+            detail::equalsNoCase(name, "v")){
+            if (request.nVias == maxVias)
+                return false;
+            request.vias[request.nVias++] = value;
+        }
+        else if (detail::equalsNoCase(name, "from") ||
+                 detail::equalsNoCase(name, "f"))
+            request.from = value;
+        else if (detail::equalsNoCase(name, "to") ||
+                 detail::equalsNoCase(name, "t"))
+            request.to = value;
+        else if (detail::equalsNoCase(name, "call-id") ||
+                 detail::equalsNoCase(name, "i"))
+            request.callId = value;
+        else if (detail::equalsNoCase(name, "cseq"))
+            request.cseq = value;
+    }
+    if (request.nVias == 0 || request.from.empty() || request.to.empty() ||
+        request.callId.empty() || request.cseq.empty())
+        return false;
+    request.fromUser = parseUser(request.from);
+    return true;
+}
+
+inline char * writeResponse(char * out, const Request & request,
+                            const int code, std::string_view reason,
+                            const uint64_t tag, const uint32_t retryAfter){
+    out = detail::append(out, "SIP/2.0 ");
+    out = std::to_chars(out, out + 3, code).ptr;
+    *out++ = ' ';
+    out = detail::append(out, reason);
+    out = detail::append(out, "\r\n");
+    for (size_t i = 0; i < request.nVias; ++i)
+        out = detail::appendHeader(out, "Via", request.vias[i]);
+    out = detail::appendHeader(out, "From", request.from);
+    out = detail::append(out, "To: ");
+    out = detail::append(out, request.to);
+    if (request.to.find(";tag=") == std::string_view::npos){
+        out = detail::append(out, ";tag=");
+        out = std::to_chars(out, out + 20, tag, 16).ptr;
+    }
+    out = detail::append(out, "\r\n");
+    out = detail::appendHeader(out, "Call-ID", request.callId);
+    out = detail::appendHeader(out, "CSeq", request.cseq);
+    if (retryAfter){
+        out = detail::append(out, "Retry-After: ");
+        out = std::to_chars(out, out + 10, retryAfter).ptr;
+        out = detail::append(out, "\r\n");
+    }
+    return detail::append(out, "Content-Length: 0\r\n\r\n");
+}
+
+};
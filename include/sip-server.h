@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <string>
+#include <memory>
+
+class CallCenter;
+
+// UDP SIP INVITE ingest.
+// Every INVITE becomes a call from the From user (phone number) and is
+// answered by call status: ok - 180 Ringing, alreadyInQueue - 486 Busy
+// Here, overload - 503 Service Unavailable. Other requests are ignored.
+// Retransmitted INVITE (same Call-ID and CSeq) gets the answer sent
+// to the original one (see sip::Transactions).
+// Datagrams are received with recvmmsg and answered with sendmmsg, all
+// INVITEs of one batch are pushed with one CallCenter::pushCalls().
+// Every thread has its own SO_REUSEPORT socket.
+class SipServer{
+public:
+    // Blocking. address - "host:port", nThreads == 0 - one thread
+    bool listen(const std::string & address, const size_t nThreads,
+                std::shared_ptr<CallCenter> callCenter);
+
+private:
+    std::shared_ptr<CallCenter> callCenter;
+
+    void loop(const int fd) const;
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <deque>
+#include <utility>
+#include <unordered_map>
+
+#include "cdr.h"
+#include "sip-parser.h"
+
+namespace sip{
+
+// Answer sent to INVITE
+struct Answer{
+    int code;
+    // To tag (call id)
+    uint64_t tag;
+    // Seconds, 0 - no Retry-After
+    uint32_t retryAfter;
+};
+
+// Reason phrase of codes sent by SIP ingress
+std::string_view reason(const int code);
+
+// Answered INVITE transactions by Call-ID and CSeq. A retransmitted
+// INVITE (the answer was lost) gets the original answer again instead
+// of being pushed as a repeated call.
+// Transactions expire after lifetime (Timer B: the caller stops
+// retransmitting), the oldest are dropped above maxSize.
+// Not thread safe: retransmissions come from the same address, so
+// they reach the same SO_REUSEPORT socket and thread.
+class Transactions{
+public:
+    static constexpr cdr::Seconds lifetime = 32;
+
+    explicit Transactions(const size_t maxSize);
+
+    // 64-bit hash of Call-ID and CSeq. Collisions within lifetime
+    // are negligible
+    static uint64_t key(const Request & request);
+
+    // Returns nullptr if transaction is unknown or expired
+    const Answer * find(const uint64_t key, const cdr::Seconds now);
+    void add(const uint64_t key, const Answer & answer,
+             const cdr::Seconds now);
+    size_t size() const;
+
+private:
+    const size_t maxSize;
+    std::unordered_map<uint64_t, Answer> answers;
+    // Keys by time added
+    std::deque<std::pair<cdr::Seconds, uint64_t>> added;
+
+    void expire(const cdr::Seconds now);
+};
+
+
+inline size_t Transactions::size() const{
+    return answers.size();
+}
+
+};
@@ -3,13 +3,23 @@
 #include <mutex>
 #include <condition_variable>
 #include <list>
+#include <vector>
 #include <unordered_map>
 #include <atomic>
+#include <algorithm>
+#include <type_traits>
+
+#include "fenwick-tree.h"
 
 #define Container std::list
 
 // Thread safe queue with unique elements id.
-// Complexity O(1) for all operations.
+// Complexity O(1) for all operations except position lookup.
+// Size is mirrored in atomic, so getSize() and isEmpty() don't lock.
+// Every element gets increasing index on push, Fenwick tree over
+// indexes counts elements in queue, so element position is a prefix
+// sum - O(log n). Indexes of removed elements are reused by
+// renumbering all elements when indexes run out (amortized O(1)).
 // Type T should contain method .getId()
 template <typename T>
 class UniqueQueue{
@@ -20,17 +30,37 @@ public:
         alreadyInQueue,
         reassigned
     };
+    using Id = std::decay_t<decltype(std::declval<T>().getId())>;
+
     UniqueQueue();
 
-    EC push(const T & t);
-    EC push(T && t);
+    // If replaced != nullptr and element with the same id was
+    // reassigned, the old element is moved to *replaced
+    // If position != nullptr, position of pushed element is
+    // written to *position
+    EC push(const T & t, T * replaced = nullptr, size_t * position = nullptr);
+    EC push(T && t, T * replaced = nullptr, size_t * position = nullptr);
+    // Pushes all elements under one lock. ecs[i] is result of ts[i]
+    // push, (*replaced)[i] is element reassigned by ts[i]
+    void push(const std::vector<T> & ts, std::vector<EC> & ecs,
+              std::vector<T> * replaced = nullptr);
 
-    bool erase(const decltype(std::declval<T>().getId()) id);
+    // If erased != nullptr, erased element is moved to *erased
+    bool erase(const Id & id, T * erased = nullptr);
+    // Erases element only if predicate(element) is true
+    template <typename Predicate>
+    bool eraseIf(const Id & id, Predicate predicate, T * erased = nullptr);
     bool tryPop(T & t);
     T pop();
 
     T top() const;
-    bool isInQueue(const decltype(std::declval<T>().getId()) id) const;
+    bool isInQueue(const Id & id) const;
+    // Position of element counting from 1 (next to pop)
+    bool getPosition(const Id & id, size_t & position) const;
+    // Position of element only if predicate(element) is true
+    template <typename Predicate>
+    bool getPositionIf(const Id & id, Predicate predicate,
+                       size_t & position) const;
     bool isEmpty() const;
     
     bool setMaxSize(const size_t size);
@@ -40,22 +70,41 @@ public:
     bool getRejectRepeated() const;
 
 private:
+    // Indexes of empty queue
+    static constexpr size_t minIndexes = 64;
+
+    struct Entry{
+        typename Container<T>::iterator iter;
+        size_t index;
+    };
+
     Container<T> queue;
+    // queue.size(), written under mtx
+    std::atomic<size_t> size;
     std::atomic<size_t> maxSize;
-    bool rejectRepeated;
-    std::unordered_map<decltype(std::declval<T>().getId()), 
-                       typename Container<T>::iterator> inQueue;
+    std::atomic<bool> rejectRepeated;
+    std::unordered_map<Id, Entry> inQueue;
+    // 1 for indexes of elements in queue
+    FenwickTree<int64_t> positions;
+    size_t nextIndex;
     mutable std::condition_variable checkQueue;
     mutable std::mutex mtx;
+
+    EC pushLocked(T && t, T * replaced, size_t * position);
+    void eraseLocked(typename std::unordered_map<Id, Entry>::iterator entry);
+    void reindex();
 };
 
 template <typename T>
 inline UniqueQueue<T>::UniqueQueue() :
-    rejectRepeated{true}
+    size{0},
+    rejectRepeated{true},
+    positions(minIndexes),
+    nextIndex{0}
 {}
 
 template <typename T>
-bool UniqueQueue<T>::isInQueue(const decltype(std::declval<T>().getId()) id) const{
+bool UniqueQueue<T>::isInQueue(const Id & id) const{
     std::unique_lock<std::mutex> lck(mtx);
     return inQueue.find(id) != inQueue.end();
 }
@@ -76,14 +125,12 @@ inline size_t UniqueQueue<T>::getMaxSize() const{
 
 template <typename T>
 inline bool UniqueQueue<T>::isEmpty() const{
-    std::unique_lock<std::mutex> lck(mtx);
-    return queue.empty();
+    return size.load(std::memory_order_relaxed) == 0;
 }
 
 template <typename T>
 inline size_t UniqueQueue<T>::getSize() const{
-    std::unique_lock<std::mutex> lck(mtx);
-    return queue.size();
+    return size.load(std::memory_order_relaxed);
 }
 
 template <typename T>
@@ -97,32 +144,105 @@ inline bool UniqueQueue<T>::getRejectRepeated() const{
 }
 
 template <typename T>
-typename UniqueQueue<T>::EC UniqueQueue<T>::push(T && t){
+bool UniqueQueue<T>::getPosition(const Id & id, size_t & position) const{
+    return getPositionIf(id, [](const T &){ return true; }, position);
+}
+
+template <typename T>
+template <typename Predicate>
+bool UniqueQueue<T>::getPositionIf(const Id & id, Predicate predicate,
+                                   size_t & position) const{
     std::unique_lock<std::mutex> lck(mtx);
+    auto entry = inQueue.find(id);
+    if (entry == inQueue.end() || !predicate(*entry->second.iter))
+        return false;
+    position = positions.prefixSum(entry->second.index);
+    return true;
+}
+
+template <typename T>
+typename UniqueQueue<T>::EC UniqueQueue<T>::push(T && t, T * replaced,
+                                                 size_t * position){
+    std::unique_lock<std::mutex> lck(mtx);
+    auto ec = pushLocked(std::move(t), replaced, position);
+    if (ec == EC::inserted || ec == EC::reassigned)
+        checkQueue.notify_one();
+    return ec;
+}
+
+template <typename T>
+void UniqueQueue<T>::push(const std::vector<T> & ts, std::vector<EC> & ecs,
+                          std::vector<T> * replaced){
+    ecs.resize(ts.size());
+    if (replaced)
+        replaced->resize(ts.size());
+    std::unique_lock<std::mutex> lck(mtx);
+    for (size_t i = 0; i < ts.size(); ++i){
+        auto tCopy = ts[i];
+        ecs[i] = pushLocked(std::move(tCopy),
+                            replaced ? &(*replaced)[i] : nullptr, nullptr);
+    }
+    checkQueue.notify_one();
+}
+
+template <typename T>
+typename UniqueQueue<T>::EC UniqueQueue<T>::pushLocked(T && t, T * replaced,
+                                                       size_t * position){
     if (queue.size() >= maxSize)
         return UniqueQueue<T>::EC::overload;
-    auto id = t.getId();
+    Id id = t.getId();
     auto found = inQueue.find(id);
     bool repeated = false;
     if (found != inQueue.end()){
         if (rejectRepeated)
             return UniqueQueue<T>::EC::alreadyInQueue;
-        queue.erase(found->second);
-        inQueue.erase(found);
+        if (replaced)
+            *replaced = std::move(*found->second.iter);
+        eraseLocked(found);
         repeated = true;
     }
+    if (nextIndex == positions.size())
+        reindex();
     queue.push_back(std::move(t));
+    size.store(queue.size(), std::memory_order_relaxed);
     auto iter = queue.rbegin();
-    inQueue[id] = (++iter).base();
-    checkQueue.notify_one();
+    inQueue[id] = {(++iter).base(), nextIndex};
+    positions.add(nextIndex++, 1);
+    // Pushed element is the last one
+    if (position)
+        *position = queue.size();
     return repeated? UniqueQueue<T>::EC::reassigned :
                      UniqueQueue<T>::EC::inserted;
 }
 
 template <typename T>
-inline typename UniqueQueue<T>::EC UniqueQueue<T>::push(const T &t){
+inline typename UniqueQueue<T>::EC UniqueQueue<T>::push(const T &t,
+                                                       T * replaced,
+                                                       size_t * position){
     auto tCopy = t;
-    return push(std::move(tCopy));
+    return push(std::move(tCopy), replaced, position);
+}
+
+template <typename T>
+void UniqueQueue<T>::eraseLocked(
+    typename std::unordered_map<Id, Entry>::iterator entry){
+    positions.add(entry->second.index, -1);
+    queue.erase(entry->second.iter);
+    size.store(queue.size(), std::memory_order_relaxed);
+    inQueue.erase(entry);
+}
+
+// Numbers elements from 0 in queue order. Twice as many indexes as
+// elements, so the next renumbering is after at least queue.size()
+// pushes
+template <typename T>
+void UniqueQueue<T>::reindex(){
+    positions.reset(std::max(minIndexes, 2 * (queue.size() + 1)));
+    nextIndex = 0;
+    for (auto & t : queue){
+        inQueue[t.getId()].index = nextIndex;
+        positions.add(nextIndex++, 1);
+    }
 }
 
 // Blocking pop
@@ -132,8 +252,7 @@ T UniqueQueue<T>::pop(){
     while (queue.size() <= 0)
         checkQueue.wait(lck);
     auto t = queue.front();
-    queue.pop_front();
-    inQueue.erase(t.getId());
+    eraseLocked(inQueue.find(t.getId()));
     return t;
 }
 
@@ -144,13 +263,20 @@ inline T UniqueQueue<T>::top() const{
 }
 
 template <typename T>
-inline bool UniqueQueue<T>::erase(const decltype(std::declval<T>().getId()) id){
+inline bool UniqueQueue<T>::erase(const Id & id, T * erased){
+    return eraseIf(id, [](const T &){ return true; }, erased);
+}
+
+template <typename T>
+template <typename Predicate>
+bool UniqueQueue<T>::eraseIf(const Id & id, Predicate predicate, T * erased){
     std::unique_lock<std::mutex> lck(mtx);
     auto t = inQueue.find(id);
-    if (t == inQueue.end())
+    if (t == inQueue.end() || !predicate(*t->second.iter))
         return false;
-    queue.erase(t->second);
-    inQueue.erase(t);
+    if (erased)
+        *erased = std::move(*t->second.iter);
+    eraseLocked(t);
     return true;
 }
 
@@ -161,8 +287,7 @@ inline bool UniqueQueue<T>::tryPop(T & t)
     while (queue.size() <= 0)
         return false;
     t = queue.front();
-    queue.pop_front();
-    inQueue.erase(t.getId());
+    eraseLocked(inQueue.find(t.getId()));
     return true;
 }
 
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include <condition_variable>
+
+// Wakes readers waiting for data written without locks (event count).
+// A reader calls prepare(), checks for data once more and waits with
+// the returned ticket only if there is still nothing to read, so data
+// written after the check always wakes it. Writers call notify() after
+// writing; while nobody waits it costs a fence and one load.
+// Threads wait with wait(), event loops watch an eventfd (openFd()).
+class Wakeup{
+public:
+    Wakeup() = default;
+    Wakeup(const Wakeup &) = delete;
+    Wakeup & operator=(const Wakeup &) = delete;
+    ~Wakeup();
+
+    uint64_t prepare();
+    // Returns false on timeout
+    bool wait(const uint64_t ticket,
+              const std::chrono::milliseconds timeout);
+
+    // Non-blocking eventfd becoming readable on notify().
+    // Returns -1 on error
+    int openFd();
+    void closeFd(const int fd);
+    // Makes fd not readable until the next notify()
+    static void consume(const int fd);
+
+    void notify();
+
+private:
+    std::atomic<bool> armed{false};
+    std::atomic<uint64_t> generation{0};
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::vector<int> fds;
+
+    void wakeAll();
+};
+
+
+inline uint64_t Wakeup::prepare(){
+    // Ticket is taken before arming, so notify() clearing this
+    // arming changes generation after the ticket
+    const auto ticket = generation.load(std::memory_order_acquire);
+    armed.store(true, std::memory_order_release);
+    // Pairs with fence in notify(): either reader sees data or
+    // writer sees armed
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return ticket;
+}
+
+inline void Wakeup::notify(){
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!armed.load(std::memory_order_relaxed) ||
+        !armed.exchange(false, std::memory_order_acq_rel))
+        return;
+    wakeAll();
+}
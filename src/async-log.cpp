@@ -0,0 +1,210 @@
+#include <time.h>
+#include <stdio.h>
+
+#include <chrono>
+#include <algorithm>
+#include <type_traits>
+
+#include "async-log.h"
+
+static_assert(std::is_trivially_copyable_v<AsyncLog::Record>);
+
+// Writer sleeps when all rings are empty
+constexpr std::chrono::milliseconds idlePeriod{1};
+
+static const char * text(const AsyncLog::Message message){
+    using M = AsyncLog::Message;
+    switch (message){
+        case M::pushed:
+            return "Pushed call with call id: {}";
+        case M::overloaded:
+            return "Tried push call with call id: {}. Call queue overloaded";
+        case M::alreadyInQueue:
+            return "Call with call id: {} already in queue";
+        case M::cancelled:
+            return "Call with call id: {} cancelled while waiting in queue";
+        case M::operatorAssigned:
+            return "Operator assigned";
+        case M::cdrInitialized:
+            return "Initialized cdr with fields:, call id: {}, "
+                   "call duration:{}, operator id: {}";
+        case M::cdrReady:
+            return "Cdr initialized";
+        case M::servingStarted:
+            return "Call serving started. CallId: {}, operatorId: {}";
+        case M::callEnded:
+            return "Call with callId: {} ended";
+        case M::operatorReleased:
+            return "Releasing operator with operatorId: {}";
+        case M::endedByTimeout:
+            return "Call with callId: {} ending by timeout. Elapsed time: {}, "
+                   "maxResponseTime: {}, receiveTime: {}";
+    }
+    return "";
+}
+
+static std::atomic<uint64_t> nextId{1};
+
+AsyncLog::AsyncLog() :
+    id{nextId.fetch_add(1, std::memory_order_relaxed)},
+    levels{0},
+    dropped{0},
+    written{0},
+    removedPushed{0},
+    stopped{false}
+{}
+
+AsyncLog::~AsyncLog(){
+    if (!writer.joinable())
+        return;
+    stopped = true;
+    writer.join();
+    drain();
+}
+
+// Never destroyed: writer thread may write until process exit
+AsyncLog & AsyncLog::instance(){
+    static AsyncLog * log = new AsyncLog();
+    return *log;
+}
+
+void AsyncLog::start(Sink sink, const uint32_t levels){
+    if (writer.joinable())
+        return;
+    this->sink = std::move(sink);
+    writer = std::thread(&AsyncLog::run, this);
+    this->levels = levels;
+}
+
+void AsyncLog::flush(){
+    if (!writer.joinable())
+        return;
+    uint64_t target = 0;
+    {
+        std::lock_guard<std::mutex> lck(ringsMtx);
+        target = removedPushed;
+        for (auto & ring : rings)
+            target += ring->head.load(std::memory_order_acquire);
+    }
+    while (written.load(std::memory_order_acquire) < target)
+        std::this_thread::sleep_for(idlePeriod);
+}
+
+uint64_t AsyncLog::getDropped() const{
+    return dropped.load(std::memory_order_relaxed);
+}
+
+std::string AsyncLog::format(const Record & record){
+    std::string s;
+    const char * t = text(record.message);
+    size_t arg = 0;
+    for (const char * p = t; *p; ++p){
+        if (p[0] == '{' && p[1] == '}' && arg < maxArgs){
+            s += std::to_string(record.args[arg++]);
+            ++p;
+        }
+        else
+            s += *p;
+    }
+    return s;
+}
+
+std::string AsyncLog::formatTime(const uint64_t time){
+    const time_t seconds = time / 1000000000;
+    tm local;
+    localtime_r(&seconds, &local);
+    char s[32];
+    const auto n = strftime(s, sizeof(s), "%Y-%m-%d %H:%M:%S", &local);
+    snprintf(s + n, sizeof(s) - n, ".%03u",
+             static_cast<unsigned>(time % 1000000000 / 1000000));
+    return s;
+}
+
+// Coarse clock is read without system call, resolution is
+// a few milliseconds
+uint64_t AsyncLog::now(){
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+AsyncLog::Ring & AsyncLog::localRing(){
+    // Closes ring when thread exits
+    struct Local{
+        uint64_t owner = 0;
+        std::shared_ptr<Ring> ring;
+        ~Local(){
+            if (ring)
+                ring->closed = true;
+        }
+    };
+    thread_local Local local;
+    if (local.owner != id){
+        if (local.ring)
+            local.ring->closed = true;
+        local.ring = std::make_shared<Ring>();
+        local.owner = id;
+        std::lock_guard<std::mutex> lck(ringsMtx);
+        rings.push_back(local.ring);
+    }
+    return *local.ring;
+}
+
+void AsyncLog::push(const Record & record){
+    auto & ring = localRing();
+    const auto head = ring.head.load(std::memory_order_relaxed);
+    if (head - ring.tail.load(std::memory_order_acquire) >= ringCapacity){
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        // Slot is not taken
+        return;
+    }
+    ring.records[head % ringCapacity] = record;
+    ring.head.store(head + 1, std::memory_order_release);
+}
+
+void AsyncLog::run(){
+    uint64_t reportedDropped = 0;
+    while (!stopped){
+        const auto n = drain();
+        const auto nDropped = getDropped();
+        if (nDropped != reportedDropped){
+            Record record{};
+            record.level = Level::warning;
+            record.time = now();
+            record.func = __func__;
+            sink(record, "Log records dropped: " +
+                 std::to_string(nDropped - reportedDropped));
+            reportedDropped = nDropped;
+        }
+        if (n == 0)
+            std::this_thread::sleep_for(idlePeriod);
+    }
+}
+
+size_t AsyncLog::drain(){
+    std::vector<std::shared_ptr<Ring>> current;
+    {
+        std::lock_guard<std::mutex> lck(ringsMtx);
+        current = rings;
+    }
+    size_t total = 0;
+    for (auto & ring : current){
+        const auto closed = ring->closed.load(std::memory_order_acquire);
+        const auto begin = ring->tail.load(std::memory_order_relaxed);
+        const auto head = ring->head.load(std::memory_order_acquire);
+        for (auto tail = begin; tail != head; ++tail){
+            auto & record = ring->records[tail % ringCapacity];
+            sink(record, format(record));
+        }
+        ring->tail.store(head, std::memory_order_release);
+        written.fetch_add(head - begin, std::memory_order_release);
+        total += head - begin;
+        // Closed before draining, so no records are left
+        if (closed){
+            std::lock_guard<std::mutex> lck(ringsMtx);
+            removedPushed += head;
+            rings.erase(std::find(rings.begin(), rings.end(), ring));
+        }
+    }
+    return total;
+}
@@ -0,0 +1,296 @@
+#include <netdb.h>
+#include <unistd.h>
+#include <sys/un.h>
+#include <sys/uio.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#include <cerrno>
+#include <thread>
+#include <vector>
+#include <unordered_map>
+
+#include "easylogging++.h"
+
+#include "call-center.h"
+#include "binary-server.h"
+#include "binary-protocol.h"
+
+namespace{
+
+constexpr size_t readChunkSize = 65536;
+// Unparsed input limit, frames are much smaller
+constexpr size_t maxInputSize = 1 << 20;
+constexpr int maxEvents = 256;
+
+struct Connection{
+    int fd;
+    // Received data, starts with incomplete frame
+    std::string in;
+    // Replies not yet written, data before written offset is sent
+    std::string out;
+    size_t written = 0;
+    bool closed = false;
+    bool waitingOut = false;
+};
+
+int openUnixListener(const std::string & path){
+    sockaddr_un addr{};
+    if (path.size() >= sizeof(addr.sun_path))
+        return -1;
+    addr.sun_family = AF_UNIX;
+    path.copy(addr.sun_path, path.size());
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return -1;
+    // Socket file left by previous run
+    unlink(path.c_str());
+    if (bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 ||
+        ::listen(fd, SOMAXCONN) != 0){
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int openTcpListener(const std::string & host, const std::string & port){
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    addrinfo * addrs;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &addrs) != 0)
+        return -1;
+    int fd = -1;
+    for (auto addr = addrs; addr; addr = addr->ai_next){
+        fd = socket(addr->ai_family,
+                    addr->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                    addr->ai_protocol);
+        if (fd < 0)
+            continue;
+        int yes = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+        if (bind(fd, addr->ai_addr, addr->ai_addrlen) == 0 &&
+            ::listen(fd, SOMAXCONN) == 0)
+            break;
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(addrs);
+    return fd;
+}
+
+// "unix:/path" or "host:port"
+int openListener(const std::string & address){
+    static const std::string unixPrefix = "unix:";
+    if (address.compare(0, unixPrefix.size(), unixPrefix) == 0)
+        return openUnixListener(address.substr(unixPrefix.size()));
+    auto colon = address.rfind(':');
+    if (colon == std::string::npos)
+        return -1;
+    return openTcpListener(address.substr(0, colon),
+                           address.substr(colon + 1));
+}
+
+// Returns false if connection failed
+bool readAll(Connection & conn){
+    while (conn.in.size() < maxInputSize){
+        auto size = conn.in.size();
+        conn.in.resize(size + readChunkSize);
+        auto n = read(conn.fd, conn.in.data() + size, readChunkSize);
+        conn.in.resize(size + std::max<ssize_t>(n, 0));
+        if (n > 0)
+            continue;
+        if (n == 0)
+            conn.closed = true;
+        return n == 0 || errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    return true;
+}
+
+// Writes pending replies and new replies with one sendmsg,
+// keeping the rest in conn.out. Returns false if connection failed.
+// Client closing connection fails it instead of raising SIGPIPE
+bool writeAll(Connection & conn, const std::string & replies){
+    iovec iov[2] = {
+        {conn.out.data() + conn.written, conn.out.size() - conn.written},
+        {const_cast<char *>(replies.data()), replies.size()}
+    };
+    const size_t size = iov[0].iov_len + iov[1].iov_len;
+    if (size == 0)
+        return true;
+    msghdr msg{};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 2;
+    auto n = sendmsg(conn.fd, &msg, MSG_NOSIGNAL);
+    if (n < 0){
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
+            return false;
+        n = 0;
+    }
+    size_t sent = n;
+    if (sent >= iov[0].iov_len){
+        sent -= iov[0].iov_len;
+        conn.out.assign(replies, sent);
+        conn.written = 0;
+    }
+    else{
+        conn.written += sent;
+        conn.out += replies;
+    }
+    return true;
+}
+
+};
+
+bool BinaryServer::listen(const std::string & address, size_t nThreads,
+                          std::shared_ptr<CallCenter> callCenter){
+    this->callCenter = callCenter;
+    auto fd = openListener(address);
+    if (fd < 0)
+        return false;
+    if (nThreads == 0)
+        nThreads = 1;
+    LOG(INFO) << "Binary ingress listening on " << address <<
+        ". Event loops: " << nThreads;
+
+    std::vector<std::thread> loops;
+    for (size_t i = 0; i < nThreads; ++i)
+        loops.emplace_back(&BinaryServer::loop, this, fd);
+    for (auto & loop : loops)
+        loop.join();
+    close(fd);
+    return true;
+}
+
+void BinaryServer::loop(const int listenFd) const{
+    int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    epoll_event event{};
+    // Only one loop is woken up by new connection
+    event.events = EPOLLIN | EPOLLEXCLUSIVE;
+    event.data.fd = listenFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event);
+
+    std::unordered_map<int, Connection> connections;
+    std::vector<epoll_event> events(maxEvents);
+    // Reused by all reads of the loop
+    std::vector<Cdr> cdrs;
+    std::vector<uint64_t> requestIds;
+    std::string replies;
+
+    auto closeConnection = [&](int fd){
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+        connections.erase(fd);
+    };
+    // Waits for writability only while replies are pending,
+    // so new calls are not read from clients not reading replies
+    auto watch = [&](Connection & conn, bool out){
+        if (conn.waitingOut == out)
+            return;
+        epoll_event event{};
+        event.events = out ? EPOLLOUT : EPOLLIN;
+        event.data.fd = conn.fd;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, conn.fd, &event);
+        conn.waitingOut = out;
+    };
+    // Pushes all complete call frames with one pushCalls.
+    // Returns false on invalid frame
+    auto process = [&](Connection & conn){
+        cdrs.clear();
+        requestIds.clear();
+        replies.clear();
+        size_t parsed = 0;
+        bool valid = true;
+        const auto now = cdr::now();
+        while (parsed < conn.in.size()){
+            binproto::Call call;
+            size_t consumed;
+            auto result = binproto::parseCall(conn.in.data() + parsed,
+                                              conn.in.size() - parsed,
+                                              call, consumed);
+            if (result == binproto::ParseResult::incomplete)
+                break;
+            if (result == binproto::ParseResult::invalid){
+                valid = false;
+                break;
+            }
+            parsed += consumed;
+            Cdr cdr;
+            cdr.phoneNumber.assign(call.phoneNumber);
+            cdr.receiveDT = call.receiveTime ?
+                cdr::fromUnixTime(call.receiveTime) : now;
+            cdrs.push_back(cdr);
+            requestIds.push_back(call.requestId);
+        }
+        conn.in.erase(0, parsed);
+        if (cdrs.empty())
+            return valid;
+
+        uint32_t retryAfter;
+        const bool shed = callCenter->shedCalls(cdrs.size(), retryAfter);
+        if (!shed)
+            callCenter->pushCalls(cdrs);
+        replies.resize(cdrs.size() * binproto::replySize);
+        auto out = replies.data();
+        for (size_t i = 0; i < cdrs.size(); ++i){
+            binproto::Reply reply;
+            reply.requestId = requestIds[i];
+            if (shed)
+                reply.callStatus = CallStatus::overload;
+            else{
+                reply.callId = cdrs[i].callId;
+                reply.callStatus = cdrs[i].callStatus;
+            }
+            out = binproto::writeReply(out, reply);
+        }
+        return valid;
+    };
+
+    while (true){
+        int n = epoll_wait(epollFd, events.data(), maxEvents, -1);
+        if (n < 0 && errno != EINTR){
+            LOG(ERROR) << "epoll_wait failed, errno: " << errno;
+            break;
+        }
+        for (int i = 0; i < n; ++i){
+            const int fd = events[i].data.fd;
+            if (fd == listenFd){
+                int connFd;
+                while ((connFd = accept4(listenFd, nullptr, nullptr,
+                                         SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0){
+                    // Fails for Unix sockets
+                    int yes = 1;
+                    setsockopt(connFd, IPPROTO_TCP, TCP_NODELAY,
+                               &yes, sizeof(yes));
+                    connections[connFd].fd = connFd;
+                    epoll_event event{};
+                    event.events = EPOLLIN;
+                    event.data.fd = connFd;
+                    epoll_ctl(epollFd, EPOLL_CTL_ADD, connFd, &event);
+                }
+                continue;
+            }
+
+            auto found = connections.find(fd);
+            if (found == connections.end())
+                continue;
+            auto & conn = found->second;
+            if ((events[i].events & EPOLLIN) && !readAll(conn)){
+                closeConnection(fd);
+                continue;
+            }
+            replies.clear();
+            const bool valid = process(conn);
+            if (!writeAll(conn, replies) || !valid ||
+                (conn.closed && conn.out.empty())){
+                closeConnection(fd);
+                continue;
+            }
+            watch(conn, !conn.out.empty());
+        }
+    }
+    close(epollFd);
+}
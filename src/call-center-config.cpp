@@ -0,0 +1,356 @@
+#include <algorithm>
+
+#include "easylogging++.h"
+
+#include "call-center.h"
+#include "id-generator.h"
+
+// [{"begin":"HH:MM","end":"HH:MM", parameters...}]
+static bool readSchedule(const nlohmann::json & conf, Schedule & schedule){
+    static const char * const params[] = {
+        "begin", "end", "nOperators", "maxCallQueueSize",
+        "minResponseTime", "maxResponseTime"};
+    if (!conf.is_array())
+        return false;
+    for (auto & w : conf){
+        if (!w.is_object())
+            return false;
+        for (auto & param : w.items())
+            if (std::find(std::begin(params), std::end(params),
+                          param.key()) == std::end(params))
+                return false;
+        Schedule::Window window{};
+        auto time = [&w](const char * name, uint32_t & value){
+            auto & param = w.at(name);
+            return param.is_string() &&
+                Schedule::parseTime(param.get<std::string>(), value);
+        };
+        auto optionalParam = [&w](const char * name,
+                                  std::optional<size_t> & value){
+            auto param = w.find(name);
+            if (param == w.end())
+                return true;
+            if (!param->is_number_unsigned())
+                return false;
+            value = param->get<size_t>();
+            return true;
+        };
+        if (!time("begin", window.begin) || !time("end", window.end) ||
+            !optionalParam("nOperators", window.nOperators) ||
+            !optionalParam("maxCallQueueSize", window.maxCallQueueSize) ||
+            !optionalParam("minResponseTime", window.minResponseTime) ||
+            !optionalParam("maxResponseTime", window.maxResponseTime) ||
+            !schedule.add(window))
+            return false;
+    }
+    return true;
+}
+
+static nlohmann::json scheduleToJson(const Schedule & schedule){
+    auto conf = nlohmann::json::array();
+    for (auto & window : schedule.getWindows()){
+        nlohmann::json w;
+        w["begin"] = Schedule::formatTime(window.begin);
+        w["end"] = Schedule::formatTime(window.end);
+        if (window.nOperators)
+            w["nOperators"] = *window.nOperators;
+        if (window.maxCallQueueSize)
+            w["maxCallQueueSize"] = *window.maxCallQueueSize;
+        if (window.minResponseTime)
+            w["minResponseTime"] = *window.minResponseTime;
+        if (window.maxResponseTime)
+            w["maxResponseTime"] = *window.maxResponseTime;
+        conf.push_back(std::move(w));
+    }
+    return conf;
+}
+
+// {"type":"uniform"}, {"type":"exponential","mean":N},
+// {"type":"lognormal","mu":N,"sigma":N},
+// {"type":"empirical","values":[...],"weights":[...]} or
+// {"type":"empirical","cdrHistory":"dir"}.
+// Without readHistory history built before is reused as is
+static bool readDistribution(const nlohmann::json & conf,
+                             const Distribution::HistoryField field,
+                             const bool readHistory,
+                             std::shared_ptr<const Distribution> & distribution){
+    static const char * const params[] = {
+        "type", "mean", "mu", "sigma", "values", "weights", "cdrHistory"};
+    if (!conf.is_object())
+        return false;
+    for (auto & param : conf.items())
+        if (std::find(std::begin(params), std::end(params),
+                      param.key()) == std::end(params))
+            return false;
+    auto & typeName = conf.at("type");
+    Distribution::Type type;
+    if (!typeName.is_string() ||
+        !Distribution::parseType(typeName.get<std::string>(), type))
+        return false;
+    auto number = [&conf](const char * name, double & value){
+        auto & param = conf.at(name);
+        if (!param.is_number())
+            return false;
+        value = param;
+        return true;
+    };
+    auto numbers = [&conf](const char * name, std::vector<double> & value){
+        auto & param = conf.at(name);
+        if (!param.is_array())
+            return false;
+        for (auto & v : param)
+            if (!v.is_number())
+                return false;
+        value = param.get<std::vector<double>>();
+        return true;
+    };
+    Distribution d;
+    double mean, mu, sigma;
+    std::vector<double> values, weights;
+    switch (type){
+        case Distribution::Type::uniform:
+            if (conf.size() != 1)
+                return false;
+            break;
+        case Distribution::Type::exponential:
+            if (conf.size() != 2 || !number("mean", mean))
+                return false;
+            d = Distribution::exponential(mean);
+            break;
+        case Distribution::Type::lognormal:
+            if (conf.size() != 3 || !number("mu", mu) ||
+                !number("sigma", sigma))
+                return false;
+            d = Distribution::lognormal(mu, sigma);
+            break;
+        case Distribution::Type::empirical:
+            if (conf.contains("cdrHistory")){
+                if (conf.size() != 2 || !conf.at("cdrHistory").is_string())
+                    return false;
+                const std::string dir = conf.at("cdrHistory");
+                auto & cache = HistoryCache::instance();
+                std::shared_ptr<const Distribution> history;
+                if (!readHistory)
+                    history = cache.find(dir, field);
+                if (!history)
+                    history = cache.get(dir, field);
+                if (!history){
+                    LOG(ERROR) << "Can't read CDR history: " << dir;
+                    return false;
+                }
+                LOG_IF(!history->isValid(), ERROR) <<
+                    "No calls in CDR history: " << dir;
+                if (!history->isValid())
+                    return false;
+                distribution = history;
+                return true;
+            }
+            else{
+                if (conf.size() != 3 || !numbers("values", values) ||
+                    !numbers("weights", weights))
+                    return false;
+                d = Distribution::empirical(std::move(values),
+                                            std::move(weights));
+            }
+            break;
+    }
+    if (!d.isValid())
+        return false;
+    distribution = std::make_shared<const Distribution>(std::move(d));
+    return true;
+}
+
+static nlohmann::json distributionToJson(
+    const std::shared_ptr<const Distribution> & distribution){
+    if (!distribution)
+        return nullptr;
+    auto & d = *distribution;
+    nlohmann::json conf;
+    conf["type"] = Distribution::toString(d.getType());
+    switch (d.getType()){
+        case Distribution::Type::uniform:
+            break;
+        case Distribution::Type::exponential:
+            conf["mean"] = d.getMean();
+            break;
+        case Distribution::Type::lognormal:
+            conf["mu"] = d.getMu();
+            conf["sigma"] = d.getSigma();
+            break;
+        case Distribution::Type::empirical:
+            if (!d.getHistory().empty())
+                conf["cdrHistory"] = d.getHistory();
+            else{
+                conf["values"] = d.getValues();
+                conf["weights"] = d.getWeights();
+            }
+            break;
+    }
+    return conf;
+}
+
+bool CallCenter::readConfig(const nlohmann::json & conf, Config & config,
+                            const bool readHistory){
+    auto unsignedParam = [&conf](const char * name, size_t & value){
+        auto & param = conf.at(name);
+        if (!param.is_number_unsigned())
+            return false;
+        value = param;
+        return true;
+    };
+    try{
+        auto & rejectRepeatedCalls = conf.at("rejectRepeatedCalls");
+        if (!rejectRepeatedCalls.is_boolean())
+            return false;
+        config.rejectRepeatedCalls = rejectRepeatedCalls;
+        config.schedule = Schedule();
+        if (conf.contains("schedule") &&
+            !readSchedule(conf["schedule"], config.schedule))
+            return false;
+        // Histograms are collected here, not by dispatcher
+        config.callDuration = std::make_shared<const Distribution>();
+        if (conf.contains("callDuration") &&
+            !readDistribution(conf["callDuration"],
+                              Distribution::HistoryField::callDuration,
+                              readHistory, config.callDuration))
+            return false;
+        config.patience = nullptr;
+        if (conf.contains("patience") && !conf["patience"].is_null() &&
+            !readDistribution(conf["patience"],
+                              Distribution::HistoryField::patience,
+                              readHistory, config.patience))
+            return false;
+        return unsignedParam("minResponseTime", config.minResponseTime) &&
+            unsignedParam("maxResponseTime", config.maxResponseTime) &&
+            unsignedParam("minCallDuration", config.minCallDuration) &&
+            unsignedParam("maxCallDuration", config.maxCallDuration) &&
+            unsignedParam("nOperators", config.nOperators) &&
+            unsignedParam("maxCallQueueSize", config.maxCallQueueSize) &&
+            config.isValid();
+    }
+    catch(const nlohmann::json::exception &){
+        return false;
+    }
+}
+
+nlohmann::json CallCenter::toJson(const Config & config){
+    nlohmann::json conf;
+    conf["minResponseTime"] = config.minResponseTime;
+    conf["maxResponseTime"] = config.maxResponseTime;
+    conf["minCallDuration"] = config.minCallDuration;
+    conf["maxCallDuration"] = config.maxCallDuration;
+    conf["nOperators"] = config.nOperators;
+    conf["maxCallQueueSize"] = config.maxCallQueueSize;
+    conf["rejectRepeatedCalls"] = config.rejectRepeatedCalls;
+    conf["callDuration"] = distributionToJson(config.callDuration);
+    conf["patience"] = distributionToJson(config.patience);
+    conf["schedule"] = scheduleToJson(config.schedule);
+    return conf;
+}
+
+bool CallCenter::readConfParams(const nlohmann::json & conf,
+                                Config & config){
+    if (!readConfig(conf, config))
+        return false;
+    try{
+        // Parameters outside of Config are checked here,
+        // so applying them can't fail
+        CdrExporter::Format format;
+        return conf.at("callIndexCapacity").get<size_t>() >=
+                CallIndex::minCapacity &&
+            conf.at("nodeId").get<uint32_t>() <= idgen::maxNodeId &&
+            CdrExporter::parseFormat(conf.at("cdrExportFormat"), format) &&
+            conf.at("callIndexRetention").is_number_unsigned() &&
+            conf.at("serviceLevelTime").is_number_unsigned() &&
+            conf.at("cdrExportDir").is_string() &&
+            conf.at("eventLogFile").is_string() &&
+            conf.at("eventLogLossless").is_boolean() &&
+            conf.at("textLog").is_boolean() &&
+            conf.at("traceSampleRate").is_number() &&
+            conf.at("traceSampleRate").get<double>() >= 0 &&
+            conf.at("traceSampleRate").get<double>() <= 1 &&
+            conf.at("randomSeed").is_number_unsigned() &&
+            conf.at("loadShedding").is_boolean() &&
+            // Ingress parameters are read by main() once
+            conf.at("httpIngress").is_string() &&
+            conf.at("httpIngressThreads").is_number_unsigned() &&
+            conf.at("binaryIngress").is_string() &&
+            conf.at("binaryIngressThreads").is_number_unsigned() &&
+            conf.at("sipIngress").is_string() &&
+            conf.at("sipIngressThreads").is_number_unsigned();
+    }
+    catch(const nlohmann::json::exception &){
+        return false;
+    }
+}
+
+bool CallCenter::Config::isValidParams() const{
+    return minResponseTime <= maxResponseTime &&
+        minCallDuration >= 1 && minCallDuration <= maxCallDuration &&
+        nOperators >= 1 && maxCallQueueSize >= 1 &&
+        callDuration && callDuration->isValid() &&
+        (!patience || patience->isValid());
+}
+
+bool CallCenter::Config::isValid() const{
+    if (!isValidParams())
+        return false;
+    for (size_t i = 0; i < schedule.getWindows().size(); ++i)
+        if (!withWindow(i).isValidParams())
+            return false;
+    return true;
+}
+
+CallCenter::Config CallCenter::Config::withWindow(const size_t window) const{
+    Config config = *this;
+    config.activeWindow = window;
+    if (window == Schedule::noWindow)
+        return config;
+    auto & w = schedule.getWindows().at(window);
+    config.nOperators = w.nOperators.value_or(nOperators);
+    config.maxCallQueueSize = w.maxCallQueueSize.value_or(maxCallQueueSize);
+    config.minResponseTime = w.minResponseTime.value_or(minResponseTime);
+    config.maxResponseTime = w.maxResponseTime.value_or(maxResponseTime);
+    return config;
+}
+
+bool CallCenter::Config::hasSameParams(const Config & other) const{
+    return minResponseTime == other.minResponseTime &&
+        maxResponseTime == other.maxResponseTime &&
+        minCallDuration == other.minCallDuration &&
+        maxCallDuration == other.maxCallDuration &&
+        nOperators == other.nOperators &&
+        maxCallQueueSize == other.maxCallQueueSize &&
+        rejectRepeatedCalls == other.rejectRepeatedCalls &&
+        *callDuration == *other.callDuration &&
+        (patience == other.patience ||
+         (patience && other.patience && *patience == *other.patience)) &&
+        schedule == other.schedule;
+}
+
+void CallCenter::reconcileOperators(
+    std::list<size_t> & freeOperators,
+    const std::multimap<cdr::Seconds, Cdr> & servicedCalls,
+    const size_t oldNOperators, const size_t nOperators){
+    const int64_t difference = oldNOperators - nOperators;
+    LOG(DEBUG) << "Old and new nOperators difference: " << difference;
+    // Add new free operators if new nOperators > old newOperators.
+    // Operators still busy after an earlier decrease are released
+    // when their calls end
+    if (difference < 0){
+        std::vector<bool> busy(nOperators + 1);
+        for (auto & call : servicedCalls)
+            if (call.second.operatorId <= nOperators)
+                busy[call.second.operatorId] = true;
+        for (auto i = difference * (-1); i > 0; --i)
+            if (!busy[oldNOperators + i])
+                freeOperators.push_back(oldNOperators + i);
+    }
+    // Delete free operators if new nOperators < old newOperators.
+    // Busy ones are not released after their calls end
+    if (difference > 0){
+        freeOperators.remove_if([&nOperators](auto operatorId){
+            return operatorId > nOperators;
+        });
+    }
+}
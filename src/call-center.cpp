@@ -1,8 +1,10 @@
+#include <math.h>
 #include <unistd.h>
 
 #include <string>
 #include <random>
 #include <limits>
+#include <algorithm>
 #include <thread>
 #include <fstream>
 #include <filesystem>
@@ -10,17 +12,31 @@
 #include "easylogging++.h"
 
 #include "call-center.h"
-#include "rand-generator.hpp"
+#include "id-generator.h"
+#include "rand-generator.h"
+#include "async-log.h"
+
+// Hot path messages are written by async log writer thread
+using LogMessage = AsyncLog::Message;
+
+static std::atomic<uint64_t> nextId{1};
 
 CallCenter::CallCenter() :
-    minCallDuration{0},
-    maxCallDuration{0},
-    minResponseTime{1},
-    maxResponseTime{1},
-    nOperators{0},
+    id{nextId.fetch_add(1, std::memory_order_relaxed)},
+    // Not configured yet
+    config{std::make_shared<const Config>()},
+    configVersion{0},
+    dispatcherConfig{config},
+    appliedConfigVersion{0},
+    activeConfig{config},
+    activeConfigGeneration{0},
+    nextBoundary{std::numeric_limits<cdr::Seconds>::max()},
+    callHeld{false},
+    eventLog{callEvents},
     defaultConfFileName{"default-call-center.json"}
 {
     callQueue = std::make_unique<UniqueQueue<Cdr>>();
+    callQueue->setMaxSize(config->maxCallQueueSize);
 }
 
 std::shared_ptr<CallCenter> CallCenter::getCallCenter(
@@ -35,18 +51,18 @@ std::shared_ptr<CallCenter> CallCenter::getCallCenter(
 bool CallCenter::configure(){
     nlohmann::json conf;
     getConf(conf);
-    
-    CallCenter newCallCenter;
-    if (!setConfParams(conf, newCallCenter)){
+
+    Config config;
+    if (!readConfParams(conf, config)){
         LOG(ERROR) << "Invalid params";
         LOG(ERROR) << "Configuring not done";
         return false;
     }
 
-    LOG(INFO) << "Configuring. Blocking call center to set new params";
-    setConfParams(conf, *(this));
-    LOG(INFO) << "Configuring done. Unblocking call center";
-    
+    LOG(INFO) << "Configuring. Publishing new params";
+    setConfParams(conf, config);
+    LOG(INFO) << "Configuring done. Config version: " << getConfig().version;
+
     return true;
 }
 
@@ -68,6 +84,19 @@ bool CallCenter::getConf(nlohmann::json & conf) const{
     return true;
 }
 
+nlohmann::json CallCenter::getConfiguration() const{
+    nlohmann::json conf;
+    getConf(conf);
+    return conf;
+}
+
+std::vector<std::string> CallCenter::getConfPaths() const{
+    std::vector<std::string> paths{getConfPath(defaultConfFileName)};
+    if (confFileName != "")
+        paths.push_back(getConfPath(confFileName));
+    return paths;
+}
+
 bool CallCenter::readConf(const std::string & fN,
                                    nlohmann::json & conf){
     auto absolutePath = getConfPath(fN);
@@ -91,25 +120,30 @@ std::string CallCenter::getConfPath(const std::string &fN){
     return std::filesystem::current_path().string() + "/../" + fN;
 }
 
-bool CallCenter::setConfParams(const nlohmann::json &conf,
-                                        CallCenter &callCenter){
-    if (!callCenter.setMinMaxResponseTime(conf["minResponseTime"],
-                                          conf["maxResponseTime"]))
-        return false;
-    if (!callCenter.setMinMaxCallDuration(conf["minCallDuration"],
-                                          conf["maxCallDuration"]))
-        return false;
-    if (!callCenter.setNOperators(conf["nOperators"]))
-        return false;
-    callCenter.callQueue->setRejectRepeated(conf["rejectRepeatedCalls"]);
-    if (!callCenter.setMaxCallQueueSize(conf["maxCallQueueSize"]))
-        return false;
-    return true;
+void CallCenter::setConfParams(const nlohmann::json & conf,
+                               const Config & config){
+    setConfig(config);
+    setCallIndexRetention(conf["callIndexRetention"]);
+    setCallIndexCapacity(conf["callIndexCapacity"]);
+    setServiceLevelTime(conf["serviceLevelTime"]);
+    setNodeId(conf["nodeId"]);
+    setCdrExport(conf["cdrExportDir"], conf["cdrExportFormat"]);
+    setEventLog(conf["eventLogFile"], conf["eventLogLossless"]);
+    setTraceSampleRate(conf["traceSampleRate"]);
+    setRandomSeed(conf["randomSeed"]);
+    setLoadShedding(conf["loadShedding"]);
 }
 
 void CallCenter::run(){
     LOG(INFO) << "Call center running";
+    auto & counters = metrics.local();
     while (true){
+        // One consistent snapshot per iteration. Between schedule
+        // window boundaries only the precomputed one is compared
+        if (configVersion.load(std::memory_order_acquire) !=
+                dispatcherConfig->version ||
+            cdr::now() >= nextBoundary)
+            applyConfig();
         // Ending serving calls
         if (servicedCalls.size() > 0){
             auto earliestEndCall = servicedCalls.begin();
@@ -118,19 +152,52 @@ void CallCenter::run(){
         }
         // Starting serving calls
         serveCall();
+        Metrics::add(counters.dispatcherIterations, 1);
+        counters.freeOperators.store(freeOperators.size(),
+                                     std::memory_order_relaxed);
+        counters.servicedCalls.store(servicedCalls.size(),
+                                     std::memory_order_relaxed);
     }
 
 }
 
+void CallCenter::applyConfig(){
+    const auto now = cdr::now();
+    auto newConfig = publishActiveConfig(*std::atomic_load(&config), now);
+    if (newConfig->activeWindow != dispatcherConfig->activeWindow)
+        LOG(INFO) << "Schedule window changed. Window: " <<
+            (newConfig->activeWindow == Schedule::noWindow ? std::string("none") :
+             std::to_string(newConfig->activeWindow)) <<
+            ", nOperators: " << newConfig->nOperators <<
+            ", maxCallQueueSize: " << newConfig->maxCallQueueSize;
+    // Shrinking is smooth: busy operators are not released
+    reconcileOperators(freeOperators, servicedCalls,
+                       dispatcherConfig->nOperators, newConfig->nOperators);
+    dispatcherConfig = std::move(newConfig);
+    const auto & schedule = dispatcherConfig->schedule;
+    nextBoundary = schedule.isEmpty() ?
+        std::numeric_limits<cdr::Seconds>::max() :
+        now + schedule.secondsToBoundary(
+            Schedule::secondOfDay(cdr::toUnixTime(now)));
+    appliedConfigVersion.store(dispatcherConfig->version,
+                               std::memory_order_release);
+    configApplied.notify();
+}
+
 bool CallCenter::tryEndCall(decltype(servicedCalls)::iterator callIt){
     // Call ended?
-    if (callIt->first <= std::chrono::steady_clock::now()){
-        LOG(INFO) << "Call with callId: " <<
-            callIt->second.callId << " ended";
-        LOG(INFO) << "Releasing operator with operatorId: " <<
-            callIt->second.operatorId;
+    if (callIt->first <= cdr::now()){
+        ASYNC_LOG(info, LogMessage::callEnded, callIt->second.callId);
+        ASYNC_LOG(info, LogMessage::operatorReleased,
+                  callIt->second.operatorId);
 
+        trace.record(CallTrace::Stage::ended, callIt->second.callId);
         releaseOperator(callIt->second.operatorId);
+        callIndex.update(CallIndex::State::ended, callIt->second);
+        kpi.onEnd(callIt->second.callDuration);
+        callEvents.publish(CallEvents::Type::ended, callIt->second,
+                           callQueue->getSize());
+        cdrExporter.push(callIt->second);
         servicedCalls.erase(callIt);
         return true;
     }
@@ -140,27 +207,46 @@ bool CallCenter::tryEndCall(decltype(servicedCalls)::iterator callIt){
 void CallCenter::serveCall(){
     static bool cdrEmpty = true;
     static Cdr cdr;
+    // Wait limit of the held call
+    static size_t patience;
     // Getting call from call queue and
     // serving it if minResponseTime elapsed
     if (!callQueue->isEmpty() && cdrEmpty){
+        // Set before pop, so the call is not missed by positions
+        callHeld = true;
         cdr = callQueue->pop();
+        trace.record(CallTrace::Stage::popped, cdr.callId);
+        overload.onDeparture();
+        auto & config = *dispatcherConfig;
+        patience = config.patience ?
+            config.patience->sample(0, config.maxResponseTime) :
+            config.maxResponseTime;
         cdrEmpty = false;
     }
-    if (!cdrEmpty)
-        cdrEmpty = tryServeCall(cdr);
+    if (!cdrEmpty){
+        cdrEmpty = tryServeCall(cdr, patience);
+        if (cdrEmpty)
+            callHeld = false;
+    }
 }
 
-bool CallCenter::tryServeCall(Cdr & cdr){
-    auto elapsedTime = std::chrono::duration_cast<std::chrono::seconds>(
-        std::chrono::steady_clock::now() - cdr.receiveDT);
+bool CallCenter::tryServeCall(Cdr & cdr, const size_t patience){
+    const size_t elapsedTime = cdr::now() - cdr.receiveDT;
+    auto & config = *dispatcherConfig;
+    // Caller out of patience hangs up: abandoned like cancelled
+    // calls, so CDR history of patience learns from these calls too
+    if (patience < config.maxResponseTime && elapsedTime > patience){
+        finishCancel(cdr);
+        return true;
+    }
     // If elapsed time > maxResponseTime -> call ending by timeout
-    if (elapsedTime > std::chrono::duration<int64_t>(maxResponseTime)){
+    if (elapsedTime > config.maxResponseTime){
         endCallByTimeout(cdr);
         return true;
     }
     // If elapsed time > minResponseTime -> serving call
     // and > 1 free operator
-    if (std::chrono::duration<int64_t>(minResponseTime) < elapsedTime){
+    if (config.minResponseTime < elapsedTime){
         if (serveCall(cdr))
             return true;
         LOG_EVERY_N(100000000, DEBUG) << "All operators are busy";
@@ -171,48 +257,53 @@ bool CallCenter::tryServeCall(Cdr & cdr){
 void CallCenter::endCallByTimeout(Cdr &cdr){
     cdr.callStatus = CallStatus::timeout;
     initializeCdr(cdr);
-    LOG(INFO) << "Call with callId: " << cdr.callId <<
-        " ending by timeout. Elapsed time: " <<
-        std::chrono::duration_cast<std::chrono::seconds>(
-            std::chrono::steady_clock::now() - cdr.receiveDT).count() <<
-        ", maxResponseTime: " << maxResponseTime <<
-        ", receiveTime: " << cdr.receiveDT.time_since_epoch().count();
+    trace.record(CallTrace::Stage::timedOut, cdr.callId);
+    callIndex.update(CallIndex::State::timeout, cdr);
+    kpi.onTimeout(cdr.endDT);
+    callEvents.publish(CallEvents::Type::timedOut, cdr,
+                       callQueue->getSize());
+    cdrExporter.push(cdr);
+    ASYNC_LOG(info, LogMessage::endedByTimeout, cdr.callId,
+              cdr.endDT - cdr.receiveDT, dispatcherConfig->maxResponseTime,
+              cdr.receiveDT);
 }
 
 bool CallCenter::serveCall(Cdr &cdr){
-    std::shared_lock<std::shared_mutex> lck(mtx);
     if (freeOperators.size() < 1)
         return false;
     cdr.operatorId = freeOperators.front();
     freeOperators.pop_front();
-    lck.unlock();
-    LOG(DEBUG) << "Operator assigned";
+    ASYNC_LOG(debug, LogMessage::operatorAssigned);
 
     cdr.callStatus = CallStatus::ok;
     initializeCdr(cdr);
-    LOG(DEBUG) << "Cdr initialized";
+    ASYNC_LOG(debug, LogMessage::cdrReady);
+    trace.record(CallTrace::Stage::answered, cdr.callId);
     servicedCalls.emplace(cdr.endDT, cdr);
-    LOG(INFO) << "Call serving started. CallId: " << cdr.callId <<
-        ", operatorId: " << cdr.operatorId;
+    callIndex.update(CallIndex::State::serving, cdr);
+    kpi.onAnswer(cdr.responseDT - cdr.receiveDT, cdr.responseDT);
+    callEvents.publish(CallEvents::Type::answered, cdr,
+                       callQueue->getSize());
+    ASYNC_LOG(info, LogMessage::servingStarted, cdr.callId, cdr.operatorId);
     return true;
 }
 
 void CallCenter::initializeCdr(Cdr & cdr){
     switch (cdr.callStatus){
     case CallStatus::ok:
-        cdr.callDuration = std::chrono::duration<long long>(
-            rndgen::genRandUniform(minCallDuration, maxCallDuration));
+        cdr.callDuration = static_cast<decltype(cdr.callDuration)>(
+            dispatcherConfig->callDuration->sample(
+                dispatcherConfig->minCallDuration,
+                dispatcherConfig->maxCallDuration));
         cdr.endDT = cdr.receiveDT + cdr.callDuration;
         cdr.callStatus = CallStatus::ok;
-        cdr.responseDT = std::chrono::steady_clock::now();
-        LOG(DEBUG) << "Initialized cdr with fields:" <<
-            ", call id: " << cdr.callId <<
-            ", call duration:" << cdr.callDuration.count() <<
-            ", operator id: " << cdr.operatorId;
+        cdr.responseDT = cdr::now();
+        ASYNC_LOG(debug, LogMessage::cdrInitialized, cdr.callId,
+                  cdr.callDuration, cdr.operatorId);
         break;
 
     case CallStatus::timeout:
-        cdr.endDT = std::chrono::steady_clock::now();
+        cdr.endDT = cdr::now();
         break;
 
     default:
@@ -220,35 +311,190 @@ void CallCenter::initializeCdr(Cdr & cdr){
     }
 }
 
-void CallCenter::pushCall(Cdr & cdr){
+bool CallCenter::shedCalls(const size_t nCalls, uint32_t & retryAfter){
+    overload.onArrival(nCalls);
+    if (!overload.shed(nCalls, callQueue->getSize(),
+                       callQueue->getMaxSize(), retryAfter))
+        return false;
+    // Queued calls leave queue by timeout within maxResponseTime
+    retryAfter = std::min<uint32_t>(
+        retryAfter, std::max<size_t>(getActiveConfig().maxResponseTime, 1));
+    metrics.onShed(nCalls);
+    return true;
+}
+
+void CallCenter::pushCall(Cdr & cdr, QueuePosition * position){
+    preparePush(cdr);
+    Cdr replaced;
+    size_t queuePosition = 0;
+    auto ec = callQueue->push(cdr, &replaced,
+                              position ? &queuePosition : nullptr);
+    finishPush(cdr, ec, replaced);
+    if (position && cdr.callStatus == CallStatus::ok)
+        setQueuePosition(cdr.callId, queuePosition, cdr.receiveDT, *position);
+}
+
+void CallCenter::pushCalls(std::vector<Cdr> & cdrs){
+    for (auto & cdr : cdrs)
+        preparePush(cdr);
+    std::vector<UniqueQueue<Cdr>::EC> ecs;
+    std::vector<Cdr> replaced;
+    callQueue->push(cdrs, ecs, &replaced);
+    for (size_t i = 0; i < cdrs.size(); ++i)
+        finishPush(cdrs[i], ecs[i], replaced[i]);
+}
+
+void CallCenter::preparePush(Cdr & cdr){
     // Phone number format checks can be here
-    cdr.callId = rndgen::genRandUniform(
-         static_cast<decltype(cdr.callId)>(1),
-         std::numeric_limits<decltype(cdr.callId)>::max());
+    cdr.callId = idgen::next();
+    trace.recordPush(cdr.callId);
 
-    auto ec = callQueue->push(cdr);
+    // Indexed before pushing, so dispatcher can't update
+    // the call state before it becomes queued
+    cdr.callStatus = CallStatus::ok;
+    callIndex.update(CallIndex::State::queued, cdr);
+}
 
+void CallCenter::finishPush(Cdr & cdr, const UniqueQueue<Cdr>::EC ec,
+                            Cdr & replaced){
     using EC = UniqueQueue<Cdr>::EC;
     using CS = CallStatus;
     switch (ec){
-        case EC::inserted:
         case EC::reassigned:
+            replaced.callStatus = CS::callDuplication;
+            trace.record(CallTrace::Stage::rejected, replaced.callId);
+            replaced.endDT = cdr.receiveDT;
+            callIndex.update(CallIndex::State::replaced, replaced);
+            cdrExporter.push(replaced);
+            callEvents.publish(CallEvents::Type::rejected, replaced,
+                               callQueue->getSize());
+            [[fallthrough]];
+        case EC::inserted:
             cdr.callStatus = CS::ok;
-            LOG(INFO) << "Pushed call with call id: " << cdr.callId;
+            trace.record(CallTrace::Stage::queued, cdr.callId);
+            callEvents.publish(CallEvents::Type::queued, cdr,
+                               callQueue->getSize());
+            ASYNC_LOG(info, LogMessage::pushed, cdr.callId);
             break;
             
         case EC::overload:
             cdr.callStatus = CS::overload;
-            LOG(INFO) << "Tried push call with call id: " << cdr.callId <<
-                ". Call queue overloaded";
+            trace.record(CallTrace::Stage::rejected, cdr.callId);
+            cdr.endDT = cdr.receiveDT;
+            callIndex.update(CallIndex::State::rejected, cdr);
+            cdrExporter.push(cdr);
+            callEvents.publish(CallEvents::Type::rejected, cdr,
+                               callQueue->getSize());
+            ASYNC_LOG(info, LogMessage::overloaded, cdr.callId);
             break;
 
         case EC::alreadyInQueue:
             cdr.callStatus = CS::alreadyInQueue;
-            LOG(INFO) << "Call with call id: " << cdr.callId <<
-                " already in queue";
+            trace.record(CallTrace::Stage::rejected, cdr.callId);
+            cdr.endDT = cdr.receiveDT;
+            callIndex.update(CallIndex::State::rejected, cdr);
+            cdrExporter.push(cdr);
+            callEvents.publish(CallEvents::Type::rejected, cdr,
+                               callQueue->getSize());
+            ASYNC_LOG(info, LogMessage::alreadyInQueue, cdr.callId);
             break;
     }
+    kpi.onPush(cdr.callStatus, cdr.receiveDT);
+    metrics.onPush(cdr.callStatus);
+}
+
+bool CallCenter::cancelCall(const PhoneNumber & phoneNumber,
+                            Cdr & cancelled){
+    if (!callQueue->erase(phoneNumber, &cancelled))
+        return false;
+    finishCancel(cancelled);
+    return true;
+}
+
+bool CallCenter::cancelCall(const size_t callId, Cdr & cancelled){
+    CallIndex::Entry entry;
+    if (!callIndex.find(callId, entry) ||
+        entry.state != CallIndex::State::queued)
+        return false;
+    // Phone number can be already queued again by a new call
+    if (!callQueue->eraseIf(entry.cdr.phoneNumber,
+                            [callId](const Cdr & cdr){
+                                return cdr.callId == callId;
+                            },
+                            &cancelled))
+        return false;
+    finishCancel(cancelled);
+    return true;
+}
+
+bool CallCenter::getQueuePosition(const PhoneNumber & phoneNumber,
+                                  QueuePosition & position) const{
+    size_t callId;
+    Seconds receiveDT;
+    size_t queuePosition;
+    if (!callQueue->getPositionIf(phoneNumber,
+                                  [&](const Cdr & cdr){
+                                      callId = cdr.callId;
+                                      receiveDT = cdr.receiveDT;
+                                      return true;
+                                  },
+                                  queuePosition))
+        return false;
+    setQueuePosition(callId, queuePosition, receiveDT, position);
+    return true;
+}
+
+bool CallCenter::getQueuePosition(const size_t callId,
+                                  QueuePosition & position) const{
+    CallIndex::Entry entry;
+    if (!callIndex.find(callId, entry) ||
+        entry.state != CallIndex::State::queued)
+        return false;
+    size_t queuePosition;
+    if (!callQueue->getPositionIf(entry.cdr.phoneNumber,
+                                  [callId](const Cdr & cdr){
+                                      return cdr.callId == callId;
+                                  },
+                                  queuePosition))
+        return false;
+    setQueuePosition(callId, queuePosition, entry.cdr.receiveDT, position);
+    return true;
+}
+
+// Calls ahead leave the line at queue drain rate, but the call is
+// not answered before minResponseTime and leaves the queue by timeout
+// after maxResponseTime. Without measured drain rate the wait is
+// bounded by timeout only
+void CallCenter::setQueuePosition(const size_t callId,
+                                  const size_t queuePosition,
+                                  const Seconds receiveDT,
+                                  QueuePosition & position) const{
+    position.callId = callId;
+    position.position = queuePosition + (callHeld ? 1 : 0);
+    const auto now = cdr::now();
+    const size_t elapsed = now > receiveDT ? now - receiveDT : 0;
+    auto & config = getActiveConfig();
+    const double untilTimeout = config.maxResponseTime > elapsed ?
+        config.maxResponseTime - elapsed : 0;
+    const double untilMin = config.minResponseTime > elapsed ?
+        config.minResponseTime - elapsed : 0;
+    const auto drainRate = overload.getDrainRate(now);
+    double wait = drainRate > 0 ? ceil(position.position / drainRate) :
+                                  untilTimeout;
+    wait = std::min(std::max(wait, untilMin), untilTimeout);
+    position.estimatedWait = static_cast<uint32_t>(wait);
+}
+
+void CallCenter::finishCancel(Cdr & cdr){
+    cdr.callStatus = CallStatus::abandoned;
+    cdr.endDT = cdr::now();
+    trace.record(CallTrace::Stage::abandoned, cdr.callId);
+    callIndex.update(CallIndex::State::abandoned, cdr);
+    kpi.onAbandon(cdr.endDT);
+    cdrExporter.push(cdr);
+    callEvents.publish(CallEvents::Type::abandoned, cdr,
+                       callQueue->getSize());
+    ASYNC_LOG(info, LogMessage::cancelled, cdr.callId);
 }
 
 
@@ -257,134 +503,322 @@ const static std::string successfulSetPar =
 const static std::string unsuccessfulSetPar =
     "Unsuccessful attempt setting parameter. Invalid ";
 
-bool CallCenter::setMinResponseTime(const size_t minResponseTime){
-    static auto parName = "minResponseTime: ";
-    std::unique_lock<std::shared_mutex> lck(mtx);     
-    if (minResponseTime > maxResponseTime){
-        LOG(DEBUG) << unsuccessfulSetPar << parName << minResponseTime;
+const CallCenter::Config & CallCenter::getConfig() const{
+    thread_local std::shared_ptr<const Config> cached;
+    thread_local uint64_t owner = 0;
+    if (owner != id ||
+        cached->version != configVersion.load(std::memory_order_acquire)){
+        cached = std::atomic_load(&config);
+        owner = id;
+    }
+    return *cached;
+}
+
+const CallCenter::Config & CallCenter::getActiveConfig() const{
+    thread_local std::shared_ptr<const Config> cached;
+    thread_local uint64_t generation = 0;
+    thread_local uint64_t owner = 0;
+    const auto current =
+        activeConfigGeneration.load(std::memory_order_acquire);
+    if (owner != id || generation != current){
+        cached = std::atomic_load(&activeConfig);
+        generation = current;
+        owner = id;
+    }
+    return *cached;
+}
+
+bool CallCenter::setConfig(const Config & newConfig){
+    std::lock_guard<std::mutex> lck(configMtx);
+    return publishConfig(newConfig) != nullptr;
+}
+
+CallCenter::ConfigResult CallCenter::setConfig(
+    const Config & newConfig, const uint64_t expectedVersion,
+    std::shared_ptr<const Config> * published){
+    std::lock_guard<std::mutex> lck(configMtx);
+    auto current = std::atomic_load(&config);
+    auto result = ConfigResult::conflict;
+    if (current->version == expectedVersion){
+        auto next = publishConfig(newConfig);
+        result = next ? ConfigResult::ok : ConfigResult::invalid;
+        if (next)
+            current = std::move(next);
+    }
+    if (published != nullptr)
+        *published = std::move(current);
+    return result;
+}
+
+bool CallCenter::waitConfigApplied(const uint64_t version,
+                                   const std::chrono::microseconds timeout) const{
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (true){
+        const auto ticket = configApplied.prepare();
+        if (appliedConfigVersion.load(std::memory_order_acquire) >= version)
+            return true;
+        const auto left = std::chrono::ceil<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now());
+        if (left.count() <= 0)
+            return false;
+        configApplied.wait(ticket, left);
+    }
+}
+
+void CallCenter::refreshHistory(){
+    Config config = getConfig();
+    bool changed = false;
+    auto refresh = [&changed](std::shared_ptr<const Distribution> & d,
+                              const Distribution::HistoryField field){
+        if (!d || d->getHistory().empty())
+            return;
+        auto history = HistoryCache::instance().get(d->getHistory(), field);
+        if (history && history != d && history->isValid()){
+            d = history;
+            changed = true;
+        }
+    };
+    refresh(config.callDuration, Distribution::HistoryField::callDuration);
+    refresh(config.patience, Distribution::HistoryField::patience);
+    if (!changed)
+        return;
+    // Config changed meanwhile is refreshed next time
+    std::shared_ptr<const Config> published;
+    if (setConfig(config, config.version, &published) == ConfigResult::ok)
+        LOG(INFO) << "CDR history changed. Config version: " <<
+            published->version;
+}
+
+bool CallCenter::persistConfig() const{
+    if (confFileName == "")
+        return false;
+    nlohmann::json conf;
+    readConf(confFileName, conf);
+    // All parameters are written, so reloading the file doesn't
+    // revert earlier changes. Parameters are replaced as a whole, not
+    // merged, so distributions don't keep parameters of another type
+    for (auto & param : toJson(getConfig()).items())
+        conf[param.key()] = param.value();
+    const auto path = getConfPath(confFileName);
+    const auto tmpPath = path + ".tmp";
+    {
+        std::ofstream f(tmpPath);
+        f << conf.dump(2) << "\n";
+        if (!f){
+            LOG(ERROR) << "Can't write file: " << tmpPath;
+            return false;
+        }
+    }
+    // Readers never see partially written file
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec){
+        LOG(ERROR) << "Can't replace file: " << path;
         return false;
     }
-    this->minResponseTime = minResponseTime;
-    LOG(DEBUG) << successfulSetPar << parName << minResponseTime;
     return true;
 }
 
-bool CallCenter::setMaxResponseTime(const size_t maxResponseTime){
-    static auto parName = "maxResponseTime: ";
-    std::unique_lock<std::shared_mutex> lck(mtx);     
-    if (maxResponseTime < minResponseTime){
-        LOG(DEBUG) << unsuccessfulSetPar << parName << maxResponseTime;
+std::shared_ptr<const CallCenter::Config> CallCenter::publishConfig(
+    const Config & newConfig){
+    if (!newConfig.isValid())
+        return nullptr;
+    auto current = std::atomic_load(&config);
+    // Same parameters keep the version, so reloading unchanged
+    // parameters doesn't conflict with admin changes
+    if (newConfig.hasSameParams(*current))
+        return current;
+    auto published = std::make_shared<Config>(newConfig);
+    published->version = current->version + 1;
+    // Queue parameters are atomics of the queue itself.
+    // Active config is published first, so the dispatcher applying
+    // the new version publishes it last
+    callQueue->setRejectRepeated(published->rejectRepeatedCalls);
+    publishActiveConfig(*published, cdr::now());
+    std::atomic_store(&config, std::shared_ptr<const Config>(published));
+    configVersion.store(published->version, std::memory_order_release);
+    return published;
+}
+
+std::shared_ptr<const CallCenter::Config> CallCenter::publishActiveConfig(
+    const Config & newConfig, const cdr::Seconds now){
+    const auto window = newConfig.schedule.isEmpty() ? Schedule::noWindow :
+        newConfig.schedule.find(Schedule::secondOfDay(cdr::toUnixTime(now)));
+    auto active = std::make_shared<const Config>(newConfig.withWindow(window));
+    callQueue->setMaxSize(active->maxCallQueueSize);
+    std::atomic_store(&activeConfig, active);
+    activeConfigGeneration.fetch_add(1, std::memory_order_release);
+    return active;
+}
+
+// Parameter setters publish a new snapshot with the parameter changed
+template <typename Value, typename Update>
+bool CallCenter::updateConfig(const char * parName, const Value & value,
+                              Update update){
+    std::unique_lock<std::mutex> lck(configMtx);
+    Config newConfig = *std::atomic_load(&config);
+    update(newConfig);
+    if (!publishConfig(newConfig)){
+        LOG(DEBUG) << unsuccessfulSetPar << parName << value;
         return false;
     }
-    this->maxResponseTime = maxResponseTime;
-    LOG(DEBUG) << successfulSetPar << parName << minResponseTime;
+    LOG(DEBUG) << successfulSetPar << parName << value;
     return true;
 }
 
+static std::string minMax(const size_t min, const size_t max){
+    return "min: " + std::to_string(min) + " max: " + std::to_string(max);
+}
+
+bool CallCenter::setMinResponseTime(const size_t minResponseTime){
+    return updateConfig("minResponseTime: ", minResponseTime,
+                        [&](Config & c){ c.minResponseTime = minResponseTime; });
+}
+
+bool CallCenter::setMaxResponseTime(const size_t maxResponseTime){
+    return updateConfig("maxResponseTime: ", maxResponseTime,
+                        [&](Config & c){ c.maxResponseTime = maxResponseTime; });
+}
+
 bool CallCenter::setMinMaxResponseTime(const size_t minResponseTime,
                                        const size_t maxResponseTime){
-    static auto parName = "minMaxResponseTime: ";        
-    std::unique_lock<std::shared_mutex> lck(mtx);                  
-    if (minResponseTime > maxResponseTime){
-        LOG(DEBUG) << unsuccessfulSetPar << parName <<
-            "min: " << minResponseTime << " max: " << maxResponseTime;
-        return false;
-    }
-    this->minResponseTime = minResponseTime;
-    this->maxResponseTime = maxResponseTime;
-    LOG(DEBUG) << successfulSetPar << parName <<
-        "new min: " << minResponseTime << " new max: " << maxResponseTime;
-    return true;
+    return updateConfig("minMaxResponseTime: ",
+                        minMax(minResponseTime, maxResponseTime),
+                        [&](Config & c){
+                            c.minResponseTime = minResponseTime;
+                            c.maxResponseTime = maxResponseTime;
+                        });
 }
 
 bool CallCenter::setMinCallDuration(const size_t minCallDuration){
-    static auto parName = "minCallDuration: ";
-    std::unique_lock<std::shared_mutex> lck(mtx);     
-    if (minCallDuration > maxCallDuration ||
-        minCallDuration < 1){
-        LOG(DEBUG) << unsuccessfulSetPar << parName << minCallDuration;
-        return false;
-    }
-    LOG(DEBUG) << successfulSetPar << parName << minCallDuration;
-    this->minCallDuration = minCallDuration;
-    return true;
+    return updateConfig("minCallDuration: ", minCallDuration,
+                        [&](Config & c){ c.minCallDuration = minCallDuration; });
 }
 
 bool CallCenter::setMaxCallDuration(const size_t maxCallDuration){
-    static auto parName = "maxCallDuration ";
-    std::unique_lock<std::shared_mutex> lck(mtx);     
-    if (maxCallDuration < minCallDuration ||
-        maxCallDuration < 1){
-        LOG(DEBUG) << successfulSetPar << parName << maxCallDuration;
-        return false;
-    }
-    this->maxCallDuration = maxCallDuration;
-    LOG(DEBUG) << successfulSetPar << parName << minResponseTime;
-    return true;
+    return updateConfig("maxCallDuration: ", maxCallDuration,
+                        [&](Config & c){ c.maxCallDuration = maxCallDuration; });
 }
 
 bool CallCenter::setMinMaxCallDuration(const size_t minCallDuration,
                                        const size_t maxCallDuration){
-    static auto parName = "minMaxCallDuration: ";
-    std::unique_lock<std::shared_mutex> lck(mtx);  
-    if (minCallDuration > maxCallDuration || minCallDuration < 1){
-        LOG(DEBUG) << unsuccessfulSetPar << parName <<
-            "min: " << minCallDuration << " max: " << maxCallDuration;
-        return false;
-    }
-    this->minCallDuration = minCallDuration;
-    this->maxCallDuration = maxCallDuration;
-    LOG(DEBUG) << successfulSetPar << parName <<
-        "new min: " << minCallDuration << " new max: " << maxCallDuration;
-    return true;
+    return updateConfig("minMaxCallDuration: ",
+                        minMax(minCallDuration, maxCallDuration),
+                        [&](Config & c){
+                            c.minCallDuration = minCallDuration;
+                            c.maxCallDuration = maxCallDuration;
+                        });
 }
 
 bool CallCenter::setMaxCallQueueSize(const size_t maxCallQueueSize){
-    auto parName = "maxCallQueueSize: ";
-    std::unique_lock<std::shared_mutex> lck(mtx);     
-    auto res = callQueue->setMaxSize(maxCallQueueSize);
-    lck.unlock();
-    if (res)
-        LOG(DEBUG) << successfulSetPar << parName << maxCallQueueSize;
-    else 
-        LOG(DEBUG) << unsuccessfulSetPar << parName << maxCallQueueSize;
-    return res;
+    return updateConfig("maxCallQueueSize: ", maxCallQueueSize,
+                        [&](Config & c){ c.maxCallQueueSize = maxCallQueueSize; });
 }
 
+// Free operators are updated by dispatcher (see reconcileOperators)
 bool CallCenter::setNOperators(const size_t nOperators){
-    static auto parName = "nOperators: ";
-    std::unique_lock<std::shared_mutex> lck(mtx);     
-    if (nOperators < 1){
-        LOG(DEBUG) << unsuccessfulSetPar << parName << nOperators;
+    return updateConfig("nOperators: ", nOperators,
+                        [&](Config & c){ c.nOperators = nOperators; });
+}
+
+bool CallCenter::setRejectRepeatedCalls(bool rejectRepeatedCalls){
+    return updateConfig("rejectRepeatedCalls: ", rejectRepeatedCalls,
+                        [&](Config & c){
+                            c.rejectRepeatedCalls = rejectRepeatedCalls;
+                        });
+}
+
+bool CallCenter::getRejectRepeatedCalls(){
+    return getConfig().rejectRepeatedCalls;
+}
+
+bool CallCenter::setServiceLevelTime(const size_t serviceLevelTime){
+    auto parName = "serviceLevelTime: ";
+    kpi.setServiceLevelTime(serviceLevelTime);
+    LOG(DEBUG) << successfulSetPar << parName << serviceLevelTime;
+    return true;
+}
+
+void CallCenter::setLoadShedding(const bool enabled){
+    auto parName = "loadShedding: ";
+    overload.setEnabled(enabled);
+    LOG(DEBUG) << successfulSetPar << parName << enabled;
+}
+
+bool CallCenter::setNodeId(const uint32_t nodeId){
+    static auto parName = "nodeId: ";
+    if (!idgen::setNodeId(nodeId)){
+        LOG(DEBUG) << unsuccessfulSetPar << parName << nodeId;
         return false;
     }
+    LOG(DEBUG) << successfulSetPar << parName << nodeId;
+    return true;
+}
 
-    const int64_t difference = this->nOperators - nOperators;
-    LOG(DEBUG) << "Old and new nOperators difference: " << difference;
-    // Add new free operators if new nOperators > old newOperators
-    if (difference < 0){
-        for (auto i = difference * (-1); i > 0; --i)
-            freeOperators.push_back(this->nOperators + i);
-    }
-    // Delete free operators if new nOperators < old newOperators
-    if (difference > 0){
-        freeOperators.remove_if([&nOperators](auto operatorId){
-            return operatorId > nOperators;
-        });
+bool CallCenter::setCdrExport(const std::string & dir,
+                              const std::string & format){
+    static auto parName = "cdrExport: ";
+    CdrExporter::Format f;
+    if (!CdrExporter::parseFormat(format, f)){
+        LOG(DEBUG) << unsuccessfulSetPar << parName << "format: " << format;
+        return false;
     }
+    cdrExporter.setFormat(f);
+    cdrExporter.setDir(dir);
+    LOG(DEBUG) << successfulSetPar << parName <<
+        "dir: " << dir << " format: " << format;
+    return true;
+}
 
-    this->nOperators = nOperators;
-    LOG(DEBUG) << successfulSetPar << parName << nOperators;
+bool CallCenter::setEventLog(const std::string & path, const bool lossless){
+    static auto parName = "eventLogFile: ";
+    if (!eventLog.setFile(path, lossless)){
+        LOG(ERROR) << "Can't open event log file: " << path;
+        LOG(DEBUG) << unsuccessfulSetPar << parName << path;
+        return false;
+    }
+    LOG(DEBUG) << successfulSetPar << parName << path;
     return true;
 }
 
-bool CallCenter::setRejectRepeatedCalls(bool rejectRepeatedCalls){
-    LOG(DEBUG) << "Old rejectRepeatedCalls: " << callQueue->getRejectRepeated();
-    LOG(DEBUG) << "New rejectRepeatedCalls: " << rejectRepeatedCalls;
-    callQueue->setRejectRepeated(rejectRepeatedCalls);
+bool CallCenter::setTraceSampleRate(const double rate){
+    static auto parName = "traceSampleRate: ";
+    if (!(rate >= 0 && rate <= 1)){
+        LOG(DEBUG) << unsuccessfulSetPar << parName << rate;
+        return false;
+    }
+    trace.setSampleRate(rate);
+    LOG(DEBUG) << successfulSetPar << parName << rate;
     return true;
 }
 
-bool CallCenter::getRejectRepeatedCalls(){
-    return callQueue->getRejectRepeated();
+void CallCenter::setRandomSeed(const uint64_t seed){
+    static auto parName = "randomSeed: ";
+    if (randomSeed == seed)
+        return;
+    rndgen::setSeed(seed);
+    randomSeed = seed;
+    // Random seed is logged, so the run can be reproduced
+    LOG(DEBUG) << successfulSetPar << parName << seed <<
+        " (in use: " << rndgen::getSeed() << ")";
+}
+
+bool CallCenter::setCallIndexRetention(const size_t retention){
+    auto parName = "callIndexRetention: ";
+    auto res = callIndex.setRetention(retention);
+    if (res)
+        LOG(DEBUG) << successfulSetPar << parName << retention;
+    else
+        LOG(DEBUG) << unsuccessfulSetPar << parName << retention;
+    return res;
+}
+
+bool CallCenter::setCallIndexCapacity(const size_t capacity){
+    auto parName = "callIndexCapacity: ";
+    auto res = callIndex.setCapacity(capacity);
+    if (res)
+        LOG(DEBUG) << successfulSetPar << parName << capacity;
+    else
+        LOG(DEBUG) << unsuccessfulSetPar << parName << capacity;
+    return res;
 }
@@ -0,0 +1,88 @@
+#include <string.h>
+
+#include <chrono>
+#include <thread>
+#include <type_traits>
+
+#include "call-events.h"
+
+static_assert(std::is_trivially_copyable_v<CallEvents::Event>);
+
+CallEvents::CallEvents() :
+    slots{new Slot[capacity]}
+{}
+
+void CallEvents::publish(const Type type, const cdr::Cdr & cdr,
+                         const size_t queueSize){
+    uint64_t words[nWords] = {};
+    const auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    Event event{type, static_cast<uint32_t>(queueSize),
+                static_cast<uint64_t>(time), cdr};
+    memcpy(words, &event, sizeof(event));
+
+    const auto position = head.fetch_add(1, std::memory_order_relaxed);
+    // Slot of position is free when reserving subscriber read
+    // position - capacity
+    for (auto r = reserved.load(std::memory_order_acquire);
+         r != noReservation && position >= r + capacity;
+         r = reserved.load(std::memory_order_acquire))
+        std::this_thread::yield();
+    auto & slot = slots[position % capacity];
+    slot.sequence.store(2 * position + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < nWords; ++i)
+        slot.words[i].store(words[i], std::memory_order_relaxed);
+    slot.sequence.store(2 * (position + 1), std::memory_order_release);
+    wakeup.notify();
+}
+
+CallEvents::Subscriber::Subscriber(const CallEvents & events) :
+    events{events},
+    cursor{events.head.load(std::memory_order_relaxed)}
+{}
+
+CallEvents::Result CallEvents::Subscriber::next(Event & event){
+    auto & slot = events.slots[cursor % capacity];
+    const auto expected = 2 * (cursor + 1);
+    const auto sequence = slot.sequence.load(std::memory_order_acquire);
+    // Not yet written or being written
+    if (sequence < expected)
+        return Result::empty;
+    if (sequence > expected)
+        return Result::lagged;
+
+    uint64_t words[nWords];
+    for (size_t i = 0; i < nWords; ++i)
+        words[i] = slot.words[i].load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    // Slot overwritten while reading
+    if (slot.sequence.load(std::memory_order_relaxed) != expected)
+        return Result::lagged;
+    memcpy(&event, words, sizeof(event));
+    ++cursor;
+    return Result::ok;
+}
+
+const char * CallEvents::toString(const Type type){
+    switch (type){
+        case Type::queued:
+            return "queued";
+        case Type::answered:
+            return "answered";
+        case Type::timedOut:
+            return "timedOut";
+        case Type::ended:
+            return "ended";
+        case Type::rejected:
+            return "rejected";
+        case Type::abandoned:
+            return "abandoned";
+    }
+    return "";
+}
+
+bool CallEvents::isFinal(const Type type){
+    return type == Type::timedOut || type == Type::ended ||
+           type == Type::rejected || type == Type::abandoned;
+}
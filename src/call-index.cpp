@@ -0,0 +1,86 @@
+#include "call-index.h"
+
+using namespace cdr;
+
+CallIndex::CallIndex() :
+    retention{600},
+    capacity{100000}
+{}
+
+void CallIndex::update(const State state, const Cdr & cdr){
+    auto & shard = getShard(cdr.callId);
+    auto now = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lck(shard.mtx);
+    auto & entry = shard.calls[cdr.callId];
+    entry.state = state;
+    entry.cdr = cdr;
+    if (isFinished(state))
+        shard.finished.emplace_back(now, cdr.callId);
+    evict(shard, now);
+}
+
+bool CallIndex::find(const size_t callId, Entry & entry) const{
+    auto & shard = getShard(callId);
+    std::unique_lock<std::mutex> lck(shard.mtx);
+    evict(shard, std::chrono::steady_clock::now());
+    auto found = shard.calls.find(callId);
+    if (found == shard.calls.end())
+        return false;
+    entry = found->second;
+    return true;
+}
+
+size_t CallIndex::getSize() const{
+    size_t size = 0;
+    for (auto & shard : shards){
+        std::unique_lock<std::mutex> lck(shard.mtx);
+        size += shard.calls.size();
+    }
+    return size;
+}
+
+bool CallIndex::setRetention(const size_t retention){
+    this->retention = retention;
+    return true;
+}
+
+bool CallIndex::setCapacity(const size_t capacity){
+    if (capacity < minCapacity)
+        return false;
+    this->capacity = capacity;
+    return true;
+}
+
+// Live calls are bounded by call queue size and number of operators,
+// so only finished ones are evicted
+void CallIndex::evict(Shard & shard, const TimePoint now) const{
+    const auto shardCapacity = capacity / nShards;
+    const auto expired = now - std::chrono::duration<int64_t>(retention);
+    while (!shard.finished.empty() &&
+           (shard.finished.size() > shardCapacity ||
+            shard.finished.front().first <= expired)){
+        shard.calls.erase(shard.finished.front().second);
+        shard.finished.pop_front();
+    }
+}
+
+std::string toString(CallIndex::State state){
+    using S = CallIndex::State;
+    switch (state){
+    case S::queued:
+        return "queued";
+    case S::serving:
+        return "serving";
+    case S::ended:
+        return "ended";
+    case S::timeout:
+        return "timeout";
+    case S::rejected:
+        return "rejected";
+    case S::replaced:
+        return "replaced";
+    case S::abandoned:
+        return "abandoned";
+    }
+    return "";
+}
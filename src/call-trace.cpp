@@ -0,0 +1,200 @@
+#include <stdio.h>
+
+#include <chrono>
+#include <algorithm>
+
+#include "call-trace.h"
+
+// Receive time of the request being handled by the thread
+static thread_local uint64_t receivedTime = 0;
+
+static std::atomic<uint64_t> nextId{1};
+
+CallTrace::CallTrace() :
+    id{nextId.fetch_add(1, std::memory_order_relaxed)},
+    threshold{0}
+{}
+
+void CallTrace::setSampleRate(const double rate){
+    const double clamped = std::min(std::max(rate, 0.0), 1.0);
+    threshold.store(static_cast<uint64_t>(clamped * (1ull << 32)),
+                    std::memory_order_relaxed);
+}
+
+double CallTrace::getSampleRate() const{
+    return static_cast<double>(threshold.load(std::memory_order_relaxed)) /
+        (1ull << 32);
+}
+
+void CallTrace::markReceived(){
+    if (threshold.load(std::memory_order_relaxed) == 0)
+        return;
+    receivedTime = now();
+}
+
+void CallTrace::recordPush(const uint64_t callId){
+    if (threshold.load(std::memory_order_relaxed) == 0 || !isSampled(callId))
+        return;
+    if (receivedTime != 0)
+        write(Stage::received, callId, receivedTime);
+    write(Stage::pushing, callId, now());
+}
+
+uint64_t CallTrace::now(){
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+const char * CallTrace::toString(const Stage stage){
+    switch (stage){
+        case Stage::received:
+            return "received";
+        case Stage::pushing:
+            return "pushing";
+        case Stage::queued:
+            return "queued";
+        case Stage::rejected:
+            return "rejected";
+        case Stage::popped:
+            return "popped";
+        case Stage::answered:
+            return "answered";
+        case Stage::ended:
+            return "ended";
+        case Stage::timedOut:
+            return "timedOut";
+        case Stage::abandoned:
+            return "abandoned";
+    }
+    return "";
+}
+
+// Name of slice ending with stage
+static const char * phase(const CallTrace::Stage stage){
+    using S = CallTrace::Stage;
+    switch (stage){
+        case S::pushing:
+            return "receive";
+        case S::queued:
+        case S::rejected:
+            return "enqueue";
+        case S::popped:
+        case S::timedOut:
+        case S::abandoned:
+            return "wait";
+        case S::answered:
+            return "assign";
+        case S::ended:
+            return "talk";
+        default:
+            return "";
+    }
+}
+
+bool CallTrace::isSampled(const uint64_t callId) const{
+    // Fibonacci hashing spreads sequential ids
+    const uint64_t hash = (callId * 0x9E3779B97F4A7C15ull) >> 32;
+    return hash < threshold.load(std::memory_order_relaxed);
+}
+
+CallTrace::Ring & CallTrace::localRing(){
+    struct Local{
+        uint64_t owner = 0;
+        std::shared_ptr<Ring> ring;
+    };
+    thread_local Local local;
+    if (local.owner != id){
+        local.ring = std::make_shared<Ring>();
+        local.owner = id;
+        std::lock_guard<std::mutex> lck(ringsMtx);
+        local.ring->thread = static_cast<uint32_t>(rings.size() + 1);
+        rings.push_back(local.ring);
+    }
+    return *local.ring;
+}
+
+void CallTrace::write(const Stage stage, const uint64_t callId,
+                      const uint64_t time){
+    auto & ring = localRing();
+    const auto position = ring.head.load(std::memory_order_relaxed);
+    auto & slot = ring.slots[position % ringCapacity];
+    slot.sequence.store(2 * position + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.time.store(time, std::memory_order_relaxed);
+    slot.callId.store(callId, std::memory_order_relaxed);
+    slot.stage.store(static_cast<uint8_t>(stage), std::memory_order_relaxed);
+    slot.sequence.store(2 * (position + 1), std::memory_order_release);
+    ring.head.store(position + 1, std::memory_order_release);
+}
+
+std::vector<CallTrace::Entry> CallTrace::collect(const uint64_t since) const{
+    std::vector<std::shared_ptr<Ring>> current;
+    {
+        std::lock_guard<std::mutex> lck(ringsMtx);
+        current = rings;
+    }
+    std::vector<Entry> entries;
+    for (auto & ring : current){
+        const auto head = ring->head.load(std::memory_order_acquire);
+        const auto begin = head > ringCapacity ? head - ringCapacity : 0;
+        for (auto position = begin; position < head; ++position){
+            auto & slot = ring->slots[position % ringCapacity];
+            const auto expected = 2 * (position + 1);
+            if (slot.sequence.load(std::memory_order_acquire) != expected)
+                continue;
+            Entry entry;
+            entry.time = slot.time.load(std::memory_order_relaxed);
+            entry.callId = slot.callId.load(std::memory_order_relaxed);
+            entry.stage = static_cast<Stage>(
+                slot.stage.load(std::memory_order_relaxed));
+            entry.thread = ring->thread;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            // Overwritten while reading
+            if (slot.sequence.load(std::memory_order_relaxed) != expected)
+                continue;
+            if (entry.time >= since)
+                entries.push_back(entry);
+        }
+    }
+    return entries;
+}
+
+std::string CallTrace::dump(const uint32_t seconds) const{
+    const uint64_t window = static_cast<uint64_t>(seconds) * 1000000000;
+    const auto current = now();
+    auto entries = collect(current > window ? current - window : 0);
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry & a, const Entry & b){
+                  return a.callId != b.callId ? a.callId < b.callId :
+                                                a.time < b.time;
+              });
+
+    std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    char event[256];
+    // Call ids exceed exact JSON numbers, so they are strings
+    auto append = [&](const char * ph, const Entry & from, const Entry & at,
+                      const Entry & to){
+        const int n = snprintf(
+            event, sizeof(event),
+            "%s{\"name\":\"%s\",\"cat\":\"call\",\"ph\":\"%s\","
+            "\"id\":\"0x%llx\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,"
+            "\"args\":{\"call_id\":\"%llu\",\"from\":\"%s\",\"to\":\"%s\"}}",
+            first ? "" : ",", phase(to.stage), ph,
+            static_cast<unsigned long long>(at.callId), at.thread,
+            at.time / 1000.0, static_cast<unsigned long long>(at.callId),
+            toString(from.stage), toString(to.stage));
+        out.append(event, n);
+        first = false;
+    };
+    for (size_t i = 1; i < entries.size(); ++i){
+        auto & from = entries[i - 1];
+        auto & to = entries[i];
+        if (from.callId != to.callId)
+            continue;
+        append("b", from, from, to);
+        append("e", from, to, to);
+    }
+    out += "]}";
+    return out;
+}
@@ -0,0 +1,219 @@
+#include <time.h>
+#include <zlib.h>
+
+#include <chrono>
+#include <filesystem>
+
+#include "easylogging++.h"
+
+#include "cdr-format.h"
+#include "cdr-exporter.h"
+
+using namespace cdr;
+
+// Formatted records are compressed by chunks of this size
+constexpr size_t chunkSize = 1 << 20;
+
+CdrExporter::CdrExporter() :
+    enabled{false},
+    dropped{0},
+    format{Format::csv},
+    stopping{false}
+{
+    buffer.reserve(bufferCapacity);
+}
+
+CdrExporter::~CdrExporter(){
+    std::unique_lock<std::mutex> lck(mtx);
+    stopping = true;
+    lck.unlock();
+    hasRecords.notify_one();
+    if (writer.joinable())
+        writer.join();
+}
+
+void CdrExporter::setDir(const std::string & dir){
+    std::unique_lock<std::mutex> lck(mtx);
+    this->dir = dir;
+    enabled = !dir.empty();
+}
+
+std::string CdrExporter::getDir() const{
+    std::unique_lock<std::mutex> lck(mtx);
+    return dir;
+}
+
+void CdrExporter::setFormat(const Format format){
+    std::unique_lock<std::mutex> lck(mtx);
+    this->format = format;
+}
+
+CdrExporter::Format CdrExporter::getFormat() const{
+    std::unique_lock<std::mutex> lck(mtx);
+    return format;
+}
+
+bool CdrExporter::parseFormat(const std::string & str, Format & format){
+    if (str == "csv")
+        format = Format::csv;
+    else if (str == "ndjson")
+        format = Format::ndjson;
+    else
+        return false;
+    return true;
+}
+
+bool CdrExporter::push(const Cdr & cdr){
+    if (!enabled)
+        return true;
+    std::unique_lock<std::mutex> lck(mtx);
+    if (buffer.size() >= bufferCapacity){
+        ++dropped;
+        return false;
+    }
+    // Writer is started by the first record, so configuration
+    // only instances never start it
+    if (!writer.joinable())
+        writer = std::thread(&CdrExporter::write, this);
+    buffer.push_back(cdr);
+    if (buffer.size() == 1)
+        hasRecords.notify_one();
+    return true;
+}
+
+namespace{
+
+// Hourly output file
+class HourFile{
+public:
+    ~HourFile(){
+        close();
+    }
+
+    bool isOpen(const int64_t hour, const std::string & dir,
+                const CdrExporter::Format format) const{
+        return file && this->hour == hour && this->dir == dir &&
+            this->format == format;
+    }
+
+    bool open(const int64_t hour, const std::string & dir,
+              const CdrExporter::Format format){
+        close();
+        this->hour = hour;
+        this->dir = dir;
+        this->format = format;
+
+        time_t t = hour * 3600;
+        tm utc;
+        gmtime_r(&t, &utc);
+        char name[32];
+        strftime(name, sizeof(name), "cdr-%Y%m%d%H", &utc);
+        auto path = dir + "/" + name +
+            (format == CdrExporter::Format::csv ? ".csv.gz" : ".ndjson.gz");
+
+        std::error_code ec;
+        bool newFile = !std::filesystem::exists(path, ec);
+        // Fastest compression level, appending a gzip member
+        // if the file already exists
+        file = gzopen(path.c_str(), "ab1");
+        if (!file){
+            LOG(ERROR) << "Can't open CDR export file: " << path;
+            return false;
+        }
+        gzbuffer(file, chunkSize);
+        LOG(INFO) << "CDR export file opened: " << path;
+        if (newFile && format == CdrExporter::Format::csv)
+            gzwrite(file, cdrformat::csvHeader.data(),
+                    cdrformat::csvHeader.size());
+        return true;
+    }
+
+    void write(const char * data, const size_t size){
+        if (!file || size == 0)
+            return;
+        if (gzwrite(file, data, static_cast<unsigned>(size)) == 0)
+            LOG(ERROR) << "Can't write CDR export file";
+        dirty = true;
+    }
+
+    // Makes written records readable by gunzip
+    void flush(){
+        if (file && dirty)
+            gzflush(file, Z_SYNC_FLUSH);
+        dirty = false;
+    }
+
+    void close(){
+        if (file)
+            gzclose(file);
+        file = nullptr;
+        dirty = false;
+    }
+
+    // Files of ended hours are closed even if no records come
+    void closeIfExpired(const int64_t currentHour){
+        if (file && hour < currentHour)
+            close();
+    }
+
+private:
+    gzFile file = nullptr;
+    bool dirty = false;
+    int64_t hour = 0;
+    std::string dir;
+    CdrExporter::Format format = CdrExporter::Format::csv;
+};
+
+};
+
+void CdrExporter::write(){
+    std::vector<Cdr> records;
+    records.reserve(bufferCapacity);
+    std::vector<char> chunk(chunkSize + cdrformat::maxRecordSize);
+    HourFile file;
+
+    std::unique_lock<std::mutex> lck(mtx);
+    while (true){
+        hasRecords.wait_for(lck, std::chrono::seconds(1), [this]{
+            return !buffer.empty() || stopping;
+        });
+        if (buffer.empty()){
+            if (stopping)
+                return;
+            // Idle: making file up to date
+            file.flush();
+            file.closeIfExpired(toUnixTime(cdr::now()) / 3600);
+            continue;
+        }
+        records.swap(buffer);
+        auto dir = this->dir;
+        auto format = this->format;
+        lck.unlock();
+
+        char * begin = chunk.data();
+        char * out = begin;
+        for (size_t i = 0; i < records.size(); ++i){
+            auto & record = records[i];
+            auto hour = toUnixTime(record.endDT) / 3600;
+            if (!file.isOpen(hour, dir, format)){
+                file.write(begin, out - begin);
+                out = begin;
+                if (dir.empty() || !file.open(hour, dir, format)){
+                    dropped += records.size() - i;
+                    break;
+                }
+            }
+            out = format == Format::csv ?
+                cdrformat::formatCsv(record, out) :
+                cdrformat::formatNdjson(record, out);
+            if (static_cast<size_t>(out - begin) >= chunkSize){
+                file.write(begin, out - begin);
+                out = begin;
+            }
+        }
+        file.write(begin, out - begin);
+        records.clear();
+
+        lck.lock();
+    }
+}
@@ -1,15 +1,30 @@
+#include <algorithm>
+
 #include "cdr.h"
 
 using namespace cdr;
 
-const static std::unordered_map<CallStatus, std::string> strs{
-    {CallStatus::ok, "ok"},
-    {CallStatus::overload, "overload"},
-    {CallStatus::alreadyInQueue, "alreadyInQueue"},
-    {CallStatus::callDuplication, "callDuplication"},
-    {CallStatus::timeout, "timeout"}
-};
-
 std::string cdr::toString(CallStatus cS){
-    return strs.find(cS)->second;
-}
\ No newline at end of file
+    return std::string(statusName(cS));
+}
+
+// Both clocks are sampled once, so conversion is stable
+static const auto steadyBase = std::chrono::steady_clock::now();
+static const auto systemBase = std::chrono::duration_cast<std::chrono::seconds>(
+    std::chrono::system_clock::now().time_since_epoch()).count();
+
+Seconds cdr::now(){
+    return static_cast<Seconds>(
+        std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::steady_clock::now() - steadyBase).count());
+}
+
+int64_t cdr::toUnixTime(Seconds t){
+    return systemBase + t;
+}
+
+Seconds cdr::fromUnixTime(int64_t t){
+    if (t <= systemBase)
+        return 0;
+    return std::min<int64_t>(t - systemBase, now());
+}
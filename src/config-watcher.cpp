@@ -0,0 +1,137 @@
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+#include <array>
+#include <cerrno>
+#include <thread>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <filesystem>
+
+#include "easylogging++.h"
+
+#include "fnv-hash.h"
+#include "call-center.h"
+#include "config-watcher.h"
+
+ConfigWatcher::ConfigWatcher(std::shared_ptr<CallCenter> callCenter,
+                             const std::chrono::seconds pollPeriod) :
+    callCenter{callCenter},
+    pollPeriod{pollPeriod},
+    paths{callCenter->getConfPaths()},
+    // Call center is configured from these files already
+    hash{hashFiles(paths)}
+{}
+
+void ConfigWatcher::run(){
+    if (!watch()){
+        LOG(WARNING) << "Can't watch configuration files with inotify. "
+            "Polling every " << pollPeriod.count() << " s";
+        poll();
+    }
+}
+
+uint64_t ConfigWatcher::hashFiles(const std::vector<std::string> & paths){
+    uint64_t hash = fnv::offset;
+    std::array<char, 4096> buffer;
+    for (auto & path : paths){
+        std::ifstream f(path, std::ios::binary);
+        uint64_t size = 0;
+        while (f.read(buffer.data(), buffer.size()) || f.gcount() > 0){
+            hash = fnv::hash(hash, {buffer.data(),
+                                   static_cast<size_t>(f.gcount())});
+            size += f.gcount();
+        }
+        // Files boundary
+        hash = fnv::hash(hash, {reinterpret_cast<const char *>(&size),
+                                sizeof(size)});
+    }
+    return hash;
+}
+
+bool ConfigWatcher::watch(){
+    int fd = inotify_init1(IN_CLOEXEC);
+    if (fd < 0)
+        return false;
+    std::vector<std::string> names;
+    for (auto & path : paths){
+        std::filesystem::path p(path);
+        names.push_back(p.filename().string());
+        // Repeated directory returns the same watch
+        if (inotify_add_watch(fd, p.parent_path().c_str(),
+                              IN_CLOSE_WRITE | IN_MOVED_TO) < 0){
+            close(fd);
+            return false;
+        }
+    }
+    LOG(INFO) << "Watching configuration files";
+
+    alignas(inotify_event) std::array<char, 4096> buffer;
+    // Reload is pending until files are quiet for debounce
+    bool pending = false;
+    auto deadline = std::chrono::steady_clock::now();
+    auto nextRefresh = deadline + historyRefreshPeriod;
+    while (true){
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= nextRefresh){
+            callCenter->refreshHistory();
+            nextRefresh = now + historyRefreshPeriod;
+        }
+        auto wakeAt = pending ? std::min(deadline, nextRefresh) : nextRefresh;
+        auto left = std::chrono::ceil<std::chrono::milliseconds>(wakeAt - now);
+        const int timeout = std::max<int>(left.count(), 0);
+        pollfd pfd{fd, POLLIN, 0};
+        int n = ::poll(&pfd, 1, timeout);
+        if (n < 0){
+            if (errno == EINTR)
+                continue;
+            LOG(ERROR) << "Configuration watch failed, errno: " << errno;
+            close(fd);
+            return false;
+        }
+        if (n == 0){
+            if (pending && std::chrono::steady_clock::now() >= deadline){
+                pending = false;
+                reload();
+            }
+            continue;
+        }
+        auto len = read(fd, buffer.data(), buffer.size());
+        if (len <= 0)
+            continue;
+        for (char * p = buffer.data(); p < buffer.data() + len;){
+            auto event = reinterpret_cast<inotify_event *>(p);
+            p += sizeof(inotify_event) + event->len;
+            if (event->len == 0 ||
+                std::find(names.begin(), names.end(), event->name) ==
+                    names.end())
+                continue;
+            pending = true;
+            deadline = std::chrono::steady_clock::now() + debounce;
+        }
+    }
+}
+
+void ConfigWatcher::poll(){
+    if (pollPeriod.count() == 0)
+        return;
+    while (true){
+        std::this_thread::sleep_for(pollPeriod);
+        reload();
+        callCenter->refreshHistory();
+    }
+}
+
+bool ConfigWatcher::reload(){
+    auto newHash = hashFiles(paths);
+    if (newHash == hash){
+        LOG(DEBUG) << "Configuration files not changed";
+        return false;
+    }
+    hash = newHash;
+    LOG(INFO) << "Configuration files changed. Reloading configuration";
+    callCenter->configure();
+    return true;
+}
@@ -0,0 +1,358 @@
+#include <math.h>
+#include <zlib.h>
+
+#include <map>
+#include <charconv>
+#include <algorithm>
+#include <filesystem>
+#include <string_view>
+
+#include "distribution.h"
+#include "rand-generator.h"
+
+AliasTable::AliasTable(const std::vector<double> & weights) :
+    columns(weights.size())
+{
+    // Vose: columns of average weight, every column is topped up
+    // from one larger weight (its alias)
+    double sum = 0;
+    for (auto w : weights)
+        sum += w;
+    const size_t n = weights.size();
+    std::vector<double> scaled(n);
+    std::vector<uint32_t> small, large;
+    for (size_t i = 0; i < n; ++i){
+        scaled[i] = weights[i] * n / sum;
+        (scaled[i] < 1 ? small : large).push_back(static_cast<uint32_t>(i));
+    }
+    while (!small.empty() && !large.empty()){
+        const auto s = small.back();
+        small.pop_back();
+        const auto l = large.back();
+        columns[s].threshold = static_cast<uint64_t>(scaled[s] * (1ull << 32));
+        columns[s].alias = l;
+        scaled[l] -= 1 - scaled[s];
+        if (scaled[l] < 1){
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+    // Left columns are full up to rounding errors
+    for (auto i : small)
+        columns[i] = {1ull << 32, i};
+    for (auto i : large)
+        columns[i] = {1ull << 32, i};
+}
+
+Distribution::Distribution() :
+    type{Type::uniform},
+    mean{0},
+    mu{0},
+    sigma{0}
+{}
+
+Distribution Distribution::exponential(const double mean){
+    Distribution d;
+    d.type = Type::exponential;
+    d.mean = mean;
+    return d;
+}
+
+Distribution Distribution::lognormal(const double mu, const double sigma){
+    Distribution d;
+    d.type = Type::lognormal;
+    d.mu = mu;
+    d.sigma = sigma;
+    return d;
+}
+
+Distribution Distribution::empirical(std::vector<double> values,
+                                     std::vector<double> weights,
+                                     const std::string & history){
+    Distribution d;
+    d.type = Type::empirical;
+    d.values = std::move(values);
+    d.weights = std::move(weights);
+    d.history = history;
+    if (d.isValid())
+        d.table = AliasTable(d.weights);
+    return d;
+}
+
+bool Distribution::isValid() const{
+    switch (type){
+        case Type::uniform:
+            return true;
+        case Type::exponential:
+            return std::isfinite(mean) && mean > 0;
+        case Type::lognormal:
+            return std::isfinite(mu) && std::isfinite(sigma) && sigma >= 0;
+        case Type::empirical:{
+            if (values.empty() || values.size() != weights.size() ||
+                values.size() > UINT32_MAX)
+                return false;
+            double sum = 0;
+            for (size_t i = 0; i < values.size(); ++i){
+                if (!std::isfinite(values[i]) || !std::isfinite(weights[i]) ||
+                    weights[i] < 0)
+                    return false;
+                sum += weights[i];
+            }
+            return sum > 0 && std::isfinite(sum);
+        }
+    }
+    return false;
+}
+
+size_t Distribution::sample(const size_t min, const size_t max) const{
+    double value;
+    switch (type){
+        case Type::uniform:
+            return rndgen::uniform(min, max);
+        case Type::exponential:
+            // 1 - u is in (0, 1]
+            value = -mean * log(1 - rndgen::uniform01());
+            break;
+        case Type::lognormal:{
+            // Box-Muller
+            const double u = 1 - rndgen::uniform01();
+            const double v = rndgen::uniform01();
+            value = exp(mu + sigma * sqrt(-2 * log(u)) * cos(2 * M_PI * v));
+            break;
+        }
+        case Type::empirical:
+            value = values[table.sample(rndgen::next())];
+            break;
+        default:
+            value = 0;
+    }
+    value = round(value);
+    if (!(value >= min))
+        return min;
+    if (value >= max)
+        return max;
+    return static_cast<size_t>(value);
+}
+
+bool Distribution::operator==(const Distribution & other) const{
+    return type == other.type && mean == other.mean && mu == other.mu &&
+        sigma == other.sigma && values == other.values &&
+        weights == other.weights && history == other.history;
+}
+
+const char * Distribution::toString(const Type type){
+    switch (type){
+        case Type::uniform:
+            return "uniform";
+        case Type::exponential:
+            return "exponential";
+        case Type::lognormal:
+            return "lognormal";
+        case Type::empirical:
+            return "empirical";
+    }
+    return "";
+}
+
+bool Distribution::parseType(const std::string & s, Type & type){
+    for (auto t : {Type::uniform, Type::exponential, Type::lognormal,
+                   Type::empirical})
+        if (s == toString(t)){
+            type = t;
+            return true;
+        }
+    return false;
+}
+
+namespace{
+
+bool parseInt(std::string_view s, int64_t & value){
+    return !s.empty() &&
+        std::from_chars(s.data(), s.data() + s.size(), value).ec == std::errc();
+}
+
+// Fields are taken from the right, so quoted phone numbers with
+// commas don't matter:
+// call_id,phone_number,receive_time,response_time,end_time,
+// call_status,operator_id,call_duration
+bool parseCsv(std::string_view line, int64_t & receiveTime,
+              int64_t & endTime, std::string_view & status,
+              int64_t & duration){
+    std::string_view fields[6];
+    for (int i = 5; i >= 0; --i){
+        const auto comma = line.rfind(',');
+        if (comma == std::string_view::npos)
+            return false;
+        fields[i] = line.substr(comma + 1);
+        line = line.substr(0, comma);
+    }
+    status = fields[3];
+    return parseInt(fields[0], receiveTime) &&
+        parseInt(fields[2], endTime) &&
+        parseInt(fields[5], duration);
+}
+
+// Value of "key": in NDJSON record written by CDR exporter. Escaped
+// quotes of phone number can't match the key
+std::string_view jsonValue(std::string_view line, std::string_view key){
+    const auto pos = line.find(key);
+    if (pos == std::string_view::npos)
+        return {};
+    line = line.substr(pos + key.size());
+    const bool quoted = !line.empty() && line[0] == '"';
+    if (quoted)
+        line = line.substr(1);
+    return line.substr(0, line.find_first_of(quoted ? "\"" : ",}"));
+}
+
+bool parseNdjson(std::string_view line, int64_t & receiveTime,
+                 int64_t & endTime, std::string_view & status,
+                 int64_t & duration){
+    status = jsonValue(line, "\"call_status\":");
+    return parseInt(jsonValue(line, "\"receive_time\":"), receiveTime) &&
+        parseInt(jsonValue(line, "\"end_time\":"), endTime) &&
+        parseInt(jsonValue(line, "\"call_duration\":"), duration);
+}
+
+using Histogram = std::map<int64_t, double>;
+
+struct HistoryFile{
+    std::filesystem::path path;
+    bool csv;
+};
+
+// CDR export files of dir. Returns false if dir can't be read
+bool listHistory(const std::string & dir, std::vector<HistoryFile> & files){
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    fs::directory_iterator it(dir, ec);
+    if (ec)
+        return false;
+    files.clear();
+    for (const auto & entry : it){
+        const auto name = entry.path().filename().string();
+        const bool csv = name.size() > 7 &&
+            name.compare(name.size() - 7, 7, ".csv.gz") == 0;
+        const bool ndjson = name.size() > 10 &&
+            name.compare(name.size() - 10, 10, ".ndjson.gz") == 0;
+        if (name.rfind("cdr-", 0) == 0 && (csv || ndjson))
+            files.push_back({entry.path(), csv});
+    }
+    // Same order for the same files
+    std::sort(files.begin(), files.end(),
+              [](const HistoryFile & a, const HistoryFile & b){
+                  return a.path < b.path;
+              });
+    return true;
+}
+
+// Adds calls of file to histograms of both fields (seconds -> calls)
+void readHistoryFile(const HistoryFile & file, Histogram histograms[2]){
+    using Field = Distribution::HistoryField;
+    gzFile gz = gzopen(file.path.c_str(), "rb");
+    if (!gz)
+        return;
+    char line[1024];
+    while (gzgets(gz, line, sizeof(line))){
+        std::string_view s(line);
+        while (!s.empty() && (s.back() == '\n' || s.back() == '\r'))
+            s.remove_suffix(1);
+        int64_t receiveTime, endTime, duration;
+        std::string_view status;
+        if (!(file.csv ? parseCsv(s, receiveTime, endTime, status, duration) :
+                         parseNdjson(s, receiveTime, endTime, status,
+                                     duration)))
+            continue;
+        if (status == "ok")
+            histograms[static_cast<int>(Field::callDuration)][duration] += 1;
+        else if (status == "abandoned" && endTime >= receiveTime)
+            histograms[static_cast<int>(Field::patience)]
+                [endTime - receiveTime] += 1;
+    }
+    gzclose(gz);
+}
+
+void toValues(const Histogram & histogram, std::vector<double> & values,
+              std::vector<double> & weights){
+    values.clear();
+    weights.clear();
+    for (auto & [value, count] : histogram){
+        values.push_back(static_cast<double>(value));
+        weights.push_back(count);
+    }
+}
+
+};
+
+bool Distribution::readHistory(const std::string & dir,
+                               const HistoryField field,
+                               std::vector<double> & values,
+                               std::vector<double> & weights){
+    std::vector<HistoryFile> files;
+    if (!listHistory(dir, files))
+        return false;
+    Histogram histograms[2];
+    for (auto & file : files)
+        readHistoryFile(file, histograms);
+    toValues(histograms[static_cast<int>(field)], values, weights);
+    return true;
+}
+
+HistoryCache & HistoryCache::instance(){
+    static HistoryCache cache;
+    return cache;
+}
+
+std::shared_ptr<const Distribution> HistoryCache::get(
+    const std::string & dir, const Distribution::HistoryField field){
+    namespace fs = std::filesystem;
+    std::vector<HistoryFile> list;
+    if (!listHistory(dir, list))
+        return nullptr;
+    Built current;
+    std::vector<bool> csv;
+    for (auto & file : list){
+        std::error_code sizeEc, timeEc;
+        const auto size = fs::file_size(file.path, sizeEc);
+        const auto mtime = fs::last_write_time(file.path, timeEc);
+        if (sizeEc || timeEc)
+            continue;
+        current.files.emplace_back(file.path.string(), size,
+                                   mtime.time_since_epoch().count());
+        csv.push_back(file.csv);
+    }
+
+    std::lock_guard<std::mutex> lck(mtx);
+    auto & entry = built[{dir, field}];
+    if (entry.distribution && entry.files == current.files)
+        return entry.distribution;
+
+    Histogram histogram;
+    for (size_t i = 0; i < current.files.size(); ++i){
+        auto & [path, size, mtime] = current.files[i];
+        auto found = files.find(path);
+        if (found == files.end() || found->second.size != size ||
+            found->second.mtime != mtime){
+            auto & file = files[path];
+            file = File{size, mtime, {}};
+            readHistoryFile({path, csv[i]}, file.histograms);
+            found = files.find(path);
+        }
+        for (auto & [value, count] :
+                 found->second.histograms[static_cast<int>(field)])
+            histogram[value] += count;
+    }
+    std::vector<double> values, weights;
+    toValues(histogram, values, weights);
+    current.distribution = std::make_shared<const Distribution>(
+        Distribution::empirical(std::move(values), std::move(weights), dir));
+    entry = std::move(current);
+    return entry.distribution;
+}
+
+std::shared_ptr<const Distribution> HistoryCache::find(
+    const std::string & dir, const Distribution::HistoryField field) const{
+    std::lock_guard<std::mutex> lck(mtx);
+    auto found = built.find({dir, field});
+    return found == built.end() ? nullptr : found->second.distribution;
+}
@@ -0,0 +1,476 @@
+#include <fcntl.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#include <cerrno>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <charconv>
+#include <string_view>
+#include <unordered_map>
+
+#include "easylogging++.h"
+
+#include "http-parser.h"
+#include "http-router.h"
+#include "epoll-server.h"
+
+namespace{
+
+constexpr size_t readChunkSize = 65536;
+constexpr int maxEvents = 256;
+// Connection not answering a request or not reading answers for this
+// long is closed. Connections are checked once per sweepInterval
+constexpr std::chrono::seconds idleTimeout{5};
+constexpr std::chrono::milliseconds sweepInterval{1000};
+// Stream is not polled while this much output is pending
+constexpr size_t maxStreamBacklog = 1 << 20;
+
+struct Connection{
+    int fd;
+    // Received data, requests before parsed offset are answered
+    std::string in;
+    size_t parsed = 0;
+    // Responses not yet written, data before written offset is sent
+    std::string out;
+    size_t written = 0;
+    bool closeAfterWrite = false;
+    bool peerClosed = false;
+    bool waitingOut = false;
+    // Set while connection answers with stream, requests after
+    // stream request are ignored
+    HttpRouter::StreamPoll stream;
+    // Moved by idleTimeout when data is written, so a request received
+    // slowly or never and an answer not read both expire it.
+    // Streams don't expire
+    std::chrono::steady_clock::time_point deadline;
+};
+
+int openListener(const std::string & host, const int port){
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    addrinfo * addrs;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(),
+                    &hints, &addrs) != 0)
+        return -1;
+    int fd = -1;
+    for (auto addr = addrs; addr; addr = addr->ai_next){
+        fd = socket(addr->ai_family,
+                    addr->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                    addr->ai_protocol);
+        if (fd < 0)
+            continue;
+        int yes = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+        setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &yes, sizeof(yes));
+        if (bind(fd, addr->ai_addr, addr->ai_addrlen) == 0 &&
+            ::listen(fd, SOMAXCONN) == 0)
+            break;
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(addrs);
+    return fd;
+}
+
+void clear(httplib::Request & req){
+    req.headers.clear();
+    req.params.clear();
+    req.body.clear();
+    req.matches = std::smatch();
+}
+
+void clear(httplib::Response & res){
+    res.status = -1;
+    res.headers.clear();
+    res.body.clear();
+    res.content_length_ = 0;
+    res.content_provider_ = nullptr;
+    res.is_chunked_content_provider_ = false;
+    if (res.content_provider_resource_releaser_)
+        res.content_provider_resource_releaser_(false);
+    res.content_provider_resource_releaser_ = nullptr;
+}
+
+void appendHeaders(const httplib::Response & res, std::string & out){
+    char status[4];
+    auto statusEnd = std::to_chars(status, status + sizeof(status),
+                                   res.status).ptr;
+    out += "HTTP/1.1 ";
+    out.append(status, statusEnd);
+    out += ' ';
+    out += httplib::status_message(res.status);
+    out += "\r\n";
+    for (auto & header : res.headers){
+        out += header.first;
+        out += ": ";
+        out += header.second;
+        out += "\r\n";
+    }
+}
+
+// Stream body is not framed, it ends with connection close
+void appendStreamHeaders(const httplib::Response & res, std::string & out){
+    appendHeaders(res, out);
+    out += "Connection: close\r\n\r\n";
+}
+
+void appendResponse(const httplib::Request & req,
+                    const httplib::Response & res,
+                    const bool keepAlive, std::string & out){
+    appendHeaders(res, out);
+    char length[20];
+    auto lengthEnd = std::to_chars(length, length + sizeof(length),
+                                   res.body.size()).ptr;
+    out += "Content-Length: ";
+    out.append(length, lengthEnd);
+    out += keepAlive ? "\r\nConnection: keep-alive\r\n\r\n" :
+                       "\r\nConnection: close\r\n\r\n";
+    if (req.method != "HEAD")
+        out += res.body;
+}
+
+// Answers all complete requests received by connection
+void process(Connection & conn, const HttpRouter & router,
+             httplib::Request & req, httplib::Response & res){
+    while (!conn.closeAfterWrite && !conn.stream &&
+           conn.parsed < conn.in.size()){
+        clear(req);
+        clear(res);
+        size_t consumed;
+        int status;
+        auto data = std::string_view(conn.in).substr(conn.parsed);
+        auto result = http::parseRequest(data, req, consumed, status);
+        if (result == http::ParseResult::incomplete)
+            break;
+        if (result == http::ParseResult::error){
+            res.status = status;
+            req.method.clear();
+            appendResponse(req, res, false, conn.out);
+            conn.closeAfterWrite = true;
+            break;
+        }
+        conn.parsed += consumed;
+
+        bool found = router.route(req, res, conn.stream);
+        if (res.status == -1)
+            res.status = found ? 200 : 404;
+        if (conn.stream){
+            appendStreamHeaders(res, conn.out);
+            break;
+        }
+        if (res.content_provider_){
+            clear(res);
+            res.status = 501;
+        }
+        const bool keepAlive = http::isKeepAlive(req);
+        appendResponse(req, res, keepAlive, conn.out);
+        conn.closeAfterWrite = !keepAlive;
+    }
+    // Dropping answered requests
+    if (conn.stream){
+        conn.in.clear();
+        conn.parsed = 0;
+    }
+    else if (conn.parsed > 0){
+        conn.in.erase(0, conn.parsed);
+        conn.parsed = 0;
+    }
+    if (conn.peerClosed)
+        conn.closeAfterWrite = true;
+}
+
+// Appends available stream data.
+// Returns true if data was appended, stream may have more
+bool poll(Connection & conn){
+    if (conn.closeAfterWrite || conn.out.size() - conn.written >=
+                                maxStreamBacklog)
+        return false;
+    const auto size = conn.out.size();
+    if (!conn.stream(conn.out))
+        conn.closeAfterWrite = true;
+    return conn.out.size() != size;
+}
+
+// Returns false if connection failed
+bool readAll(Connection & conn){
+    while (conn.in.size() < http::maxHeaderSize + http::maxBodySize){
+        auto size = conn.in.size();
+        conn.in.resize(size + readChunkSize);
+        auto n = read(conn.fd, conn.in.data() + size, readChunkSize);
+        conn.in.resize(size + std::max<ssize_t>(n, 0));
+        if (n > 0)
+            continue;
+        if (n == 0)
+            conn.peerClosed = true;
+        return n == 0 || errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    return true;
+}
+
+// Returns false if connection failed
+bool writeAll(Connection & conn){
+    while (conn.written < conn.out.size()){
+        auto n = send(conn.fd, conn.out.data() + conn.written,
+                      conn.out.size() - conn.written, MSG_NOSIGNAL);
+        if (n < 0)
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        conn.written += n;
+    }
+    conn.out.clear();
+    conn.written = 0;
+    return true;
+}
+
+};
+
+EpollServer::EpollServer(const HttpRouter & router) :
+    router(router)
+{}
+
+bool EpollServer::listen(const std::string & host, const int port,
+                         size_t nThreads){
+    if (nThreads == 0)
+        nThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<int> listenFds;
+    for (size_t i = 0; i < nThreads; ++i){
+        auto fd = openListener(host, port);
+        if (fd < 0){
+            for (auto listenFd : listenFds)
+                close(listenFd);
+            return false;
+        }
+        listenFds.push_back(fd);
+    }
+    LOG(INFO) << "Epoll ingress listening. Event loops: " << nThreads;
+
+    std::vector<std::thread> loops;
+    for (auto fd : listenFds)
+        loops.emplace_back(&EpollServer::loop, this, fd);
+    for (auto & loop : loops)
+        loop.join();
+    return true;
+}
+
+void EpollServer::loop(const int listenFd) const{
+    int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = listenFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event);
+
+    std::unordered_map<int, Connection> connections;
+    // Reused by all requests of the loop
+    httplib::Request req;
+    httplib::Response res;
+    std::vector<epoll_event> events(maxEvents);
+
+    // Out of descriptors pending connections keep the listening
+    // socket readable. Spare descriptor is freed to accept and close
+    // them, if it can't be reopened, the listening socket is not
+    // watched until a connection closes
+    int spareFd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    bool listenPaused = false;
+    size_t nRejected = 0;
+    auto rejectConnections = [&](){
+        const int error = errno;
+        while (spareFd >= 0){
+            close(spareFd);
+            const int connFd = accept4(listenFd, nullptr, nullptr,
+                                       SOCK_CLOEXEC);
+            if (connFd >= 0){
+                close(connFd);
+                if (nRejected++ % 1000 == 0)
+                    LOG(WARNING) << "Out of file descriptors (errno: " <<
+                        error << "), connection rejected. Rejected: " <<
+                        nRejected;
+            }
+            spareFd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+            if (connFd < 0)
+                return;
+        }
+        LOG(WARNING) << "Out of file descriptors (errno: " << error <<
+            "), not accepting connections until one closes";
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, listenFd, nullptr);
+        listenPaused = true;
+    };
+
+    size_t nStreams = 0;
+    auto closeConnection = [&](int fd){
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+        auto found = connections.find(fd);
+        if (found->second.stream)
+            --nStreams;
+        connections.erase(found);
+        if (listenPaused){
+            if (spareFd < 0)
+                spareFd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.fd = listenFd;
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event);
+            listenPaused = false;
+        }
+    };
+    // Waits for writability only while responses are pending,
+    // so new requests are not read from clients not reading answers
+    auto watch = [&](Connection & conn, bool out){
+        if (conn.waitingOut == out)
+            return;
+        epoll_event event{};
+        event.events = out ? EPOLLOUT : EPOLLIN;
+        event.data.fd = conn.fd;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, conn.fd, &event);
+        conn.waitingOut = out;
+    };
+
+    // Time of the last epoll_wait return
+    auto now = std::chrono::steady_clock::now();
+
+    // Answers are written after all events are handled.
+    // Returns false if connection is closed
+    auto flush = [&](Connection & conn){
+        const auto pending = conn.out.size() - conn.written;
+        if (!writeAll(conn) || (conn.out.empty() && conn.closeAfterWrite)){
+            closeConnection(conn.fd);
+            return false;
+        }
+        if (conn.out.size() - conn.written != pending)
+            conn.deadline = now + idleTimeout;
+        watch(conn, !conn.out.empty());
+        return true;
+    };
+
+    auto lastSweep = now;
+    std::vector<int> expired;
+    auto closeExpired = [&](){
+        lastSweep = now;
+        expired.clear();
+        for (auto & [fd, conn] : connections)
+            if (!conn.stream && conn.deadline <= now)
+                expired.push_back(fd);
+        for (auto fd : expired)
+            closeConnection(fd);
+    };
+
+    // Streams are polled when stream wakeup fd is readable,
+    // right after they returned data (they may have more, their
+    // poll is limited) and at least once per interval
+    auto wakeup = router.getStreamWakeup();
+    const int wakeFd = wakeup ? wakeup->openFd() : -1;
+    if (wakeFd >= 0){
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = wakeFd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+    }
+    auto lastPoll = std::chrono::steady_clock::now();
+    bool streamsHaveMore = false;
+    std::vector<int> streams;
+    auto pollStreams = [&](){
+        // Data published while polling wakes the next epoll_wait
+        if (wakeFd >= 0)
+            wakeup->prepare();
+        lastPoll = std::chrono::steady_clock::now();
+        streamsHaveMore = false;
+        streams.clear();
+        for (auto & [fd, conn] : connections)
+            if (conn.stream)
+                streams.push_back(fd);
+        for (auto fd : streams){
+            auto & conn = connections[fd];
+            streamsHaveMore |= poll(conn);
+            flush(conn);
+        }
+    };
+
+    while (true){
+        int timeout = -1;
+        if (nStreams)
+            timeout = streamsHaveMore ? 0 :
+                static_cast<int>(HttpRouter::streamPollInterval.count());
+        // Connections which may expire
+        if (connections.size() > nStreams){
+            const int sweep = static_cast<int>(sweepInterval.count());
+            timeout = timeout < 0 ? sweep : std::min(timeout, sweep);
+        }
+        int n = epoll_wait(epollFd, events.data(), maxEvents, timeout);
+        if (n < 0 && errno != EINTR){
+            LOG(ERROR) << "epoll_wait failed, errno: " << errno;
+            break;
+        }
+        now = std::chrono::steady_clock::now();
+        bool woken = n == 0;
+        for (int i = 0; i < n; ++i){
+            const int fd = events[i].data.fd;
+            if (fd == wakeFd){
+                Wakeup::consume(wakeFd);
+                woken = true;
+                continue;
+            }
+            if (fd == listenFd){
+                int connFd;
+                while ((connFd = accept4(listenFd, nullptr, nullptr,
+                                         SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0){
+                    int yes = 1;
+                    setsockopt(connFd, IPPROTO_TCP, TCP_NODELAY,
+                               &yes, sizeof(yes));
+                    auto & conn = connections[connFd];
+                    conn.fd = connFd;
+                    conn.deadline = now + idleTimeout;
+                    epoll_event event{};
+                    event.events = EPOLLIN;
+                    event.data.fd = connFd;
+                    epoll_ctl(epollFd, EPOLL_CTL_ADD, connFd, &event);
+                }
+                if (errno == EMFILE || errno == ENFILE)
+                    rejectConnections();
+                continue;
+            }
+
+            auto found = connections.find(fd);
+            if (found == connections.end())
+                continue;
+            auto & conn = found->second;
+            if ((events[i].events & EPOLLIN) && !readAll(conn)){
+                closeConnection(fd);
+                continue;
+            }
+            const bool streaming = static_cast<bool>(conn.stream);
+            process(conn, router, req, res);
+            // New stream is polled with others after prepare()
+            if (!streaming && conn.stream){
+                ++nStreams;
+                woken = true;
+            }
+            if (!flush(conn))
+                continue;
+            // Stream stopped by backlog is polled when client read it
+            if (streaming && (events[i].events & EPOLLOUT) &&
+                conn.out.empty() && poll(conn)){
+                streamsHaveMore = true;
+                flush(conn);
+            }
+        }
+
+        if (nStreams && (woken || streamsHaveMore ||
+                         std::chrono::steady_clock::now() - lastPoll >=
+                         HttpRouter::streamPollInterval))
+            pollStreams();
+        if (now - lastSweep >= sweepInterval)
+            closeExpired();
+    }
+    if (wakeFd >= 0)
+        wakeup->closeFd(wakeFd);
+    if (spareFd >= 0)
+        close(spareFd);
+    close(epollFd);
+}
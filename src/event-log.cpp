@@ -0,0 +1,240 @@
+#include <time.h>
+#include <string.h>
+
+#include <chrono>
+#include <optional>
+#include <type_traits>
+
+#include "event-log.h"
+
+static_assert(sizeof(EventLog::Record) == 32, "Record should be 32 bytes");
+static_assert(std::is_trivially_copyable_v<EventLog::Record>);
+
+// Writer waiting for events checks stopping at least this often
+constexpr std::chrono::milliseconds maxIdleWait{100};
+constexpr size_t fileBufferSize = 1 << 20;
+
+EventLog::Reader::~Reader(){
+    if (file)
+        fclose(file);
+}
+
+bool EventLog::Reader::open(const std::string & path){
+    file = path == "-" ? stdin : fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+    Header header;
+    return fread(&header, sizeof(header), 1, file) == 1 &&
+        memcmp(header.magic, magic, sizeof(magic)) == 0 &&
+        header.version == formatVersion &&
+        header.recordSize == sizeof(Record);
+}
+
+bool EventLog::Reader::next(Record & record){
+    return fread(&record, sizeof(record), 1, file) == 1;
+}
+
+EventLog::EventLog(const CallEvents & events) :
+    events{events},
+    lossless{false},
+    file{nullptr},
+    stopping{false},
+    written{0},
+    lost{0}
+{}
+
+EventLog::~EventLog(){
+    std::lock_guard<std::mutex> lck(mtx);
+    stop();
+}
+
+bool EventLog::setFile(const std::string & path, const bool lossless){
+    std::lock_guard<std::mutex> lck(mtx);
+    if (path == this->path && (path.empty() || lossless == this->lossless))
+        return true;
+    stop();
+    this->path.clear();
+    if (path.empty())
+        return true;
+
+    file = fopen(path.c_str(), "a+b");
+    if (!file)
+        return false;
+    setvbuf(file, nullptr, _IOFBF, fileBufferSize);
+    // Existing file is appended only if it has the same format
+    Header header;
+    const bool empty = fseek(file, 0, SEEK_END) == 0 && ftell(file) == 0;
+    if (empty){
+        memcpy(header.magic, magic, sizeof(magic));
+        header.version = formatVersion;
+        header.recordSize = sizeof(Record);
+        fwrite(&header, sizeof(header), 1, file);
+    }
+    else if (fseek(file, 0, SEEK_SET) != 0 ||
+             fread(&header, sizeof(header), 1, file) != 1 ||
+             memcmp(header.magic, magic, sizeof(magic)) != 0 ||
+             header.version != formatVersion ||
+             header.recordSize != sizeof(Record)){
+        fclose(file);
+        file = nullptr;
+        return false;
+    }
+    this->path = path;
+    this->lossless = lossless;
+    stopping = false;
+    // Subscribed here, so events after setFile() are written
+    CallEvents::Subscriber subscriber(events);
+    if (lossless)
+        events.reserve(subscriber.getCursor());
+    writer = std::thread(&EventLog::write, this, subscriber);
+    return true;
+}
+
+std::string EventLog::getFile() const{
+    std::lock_guard<std::mutex> lck(mtx);
+    return path;
+}
+
+void EventLog::stop(){
+    stopping = true;
+    // Pairs with prepare() of waiting writer
+    events.getWakeup().notify();
+    if (writer.joinable())
+        writer.join();
+    if (lossless)
+        events.unreserve();
+    if (file)
+        fclose(file);
+    file = nullptr;
+}
+
+void EventLog::write(CallEvents::Subscriber first){
+    std::optional<CallEvents::Subscriber> subscriber(first);
+    auto & wakeup = events.getWakeup();
+    CallEvents::Event event;
+    bool dirty = false;
+    size_t unreserved = 0;
+    uint64_t ticket = 0;
+    bool waiting = false;
+    while (true){
+        const auto result = subscriber->next(event);
+        if (result == CallEvents::Result::ok){
+            const auto record = toRecord(event);
+            fwrite(&record, sizeof(record), 1, file);
+            written.fetch_add(1, std::memory_order_relaxed);
+            dirty = true;
+            waiting = false;
+            if (lossless && ++unreserved == CallEvents::reserveStep){
+                events.reserve(subscriber->getCursor());
+                unreserved = 0;
+            }
+            continue;
+        }
+        if (result == CallEvents::Result::lagged){
+            // Continuing from the newest events, the gap is the events
+            // between the cursors
+            const auto cursor = subscriber->getCursor();
+            subscriber.emplace(events);
+            Record record{};
+            record.time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+            record.type = lostType;
+            record.callId = subscriber->getCursor() - cursor;
+            fwrite(&record, sizeof(record), 1, file);
+            lost.fetch_add(record.callId, std::memory_order_relaxed);
+            if (lossless)
+                events.reserve(subscriber->getCursor());
+            dirty = true;
+            waiting = false;
+            continue;
+        }
+        // Events published before stopping are written
+        if (dirty){
+            fflush(file);
+            dirty = false;
+        }
+        if (stopping)
+            return;
+        if (lossless && unreserved){
+            events.reserve(subscriber->getCursor());
+            unreserved = 0;
+        }
+        // Events and stopping are checked once more after prepare(),
+        // so publishing after the check wakes the writer
+        if (!waiting){
+            ticket = wakeup.prepare();
+            waiting = true;
+            continue;
+        }
+        wakeup.wait(ticket, maxIdleWait);
+        waiting = false;
+    }
+}
+
+EventLog::Record EventLog::toRecord(const CallEvents::Event & event){
+    Record record{};
+    record.time = event.time;
+    record.callId = event.cdr.callId;
+    record.operatorId = event.cdr.operatorId;
+    record.queueSize = event.queueSize;
+    record.type = static_cast<uint8_t>(event.type);
+    record.status = static_cast<uint8_t>(event.cdr.callStatus);
+    return record;
+}
+
+const char * EventLog::typeName(const uint8_t type){
+    if (type == lostType)
+        return "lost";
+    if (type > static_cast<uint8_t>(CallEvents::Type::abandoned))
+        return "unknown";
+    return CallEvents::toString(static_cast<CallEvents::Type>(type));
+}
+
+bool EventLog::parseType(const std::string & name, uint8_t & type){
+    for (unsigned t = 0; t <= 0xFF; ++t)
+        if (name == typeName(t) && name != "unknown"){
+            type = t;
+            return true;
+        }
+    return false;
+}
+
+static std::string_view statusName(const uint8_t status){
+    if (status >= std::size(cdr::statusNames))
+        return "unknown";
+    return cdr::statusNames[status];
+}
+
+std::string EventLog::toText(const Record & record){
+    const time_t seconds = record.time / 1000000000;
+    tm utc;
+    gmtime_r(&seconds, &utc);
+    char time[40];
+    const auto n = strftime(time, sizeof(time), "%Y-%m-%dT%H:%M:%S", &utc);
+    snprintf(time + n, sizeof(time) - n, ".%09lluZ",
+             static_cast<unsigned long long>(record.time % 1000000000));
+    std::string s = std::string(time) + " " + typeName(record.type);
+    if (record.type == lostType)
+        return s + " events: " + std::to_string(record.callId);
+    s += " call_id: " + std::to_string(record.callId);
+    s += " operator_id: " + std::to_string(record.operatorId);
+    s += " status: ";
+    s += statusName(record.status);
+    s += " queue_size: " + std::to_string(record.queueSize);
+    return s;
+}
+
+std::string EventLog::toJson(const Record & record){
+    std::string s = "{\"time\":" + std::to_string(record.time) +
+        ",\"type\":\"" + typeName(record.type) + "\"";
+    if (record.type != lostType){
+        s += ",\"call_id\":" + std::to_string(record.callId);
+        s += ",\"operator_id\":" + std::to_string(record.operatorId);
+        s += ",\"status\":\"";
+        s += statusName(record.status);
+        s += "\",\"queue_size\":" + std::to_string(record.queueSize);
+    }
+    else
+        s += ",\"events\":" + std::to_string(record.callId);
+    return s + "}";
+}
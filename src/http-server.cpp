@@ -1,28 +1,633 @@
+#include <chrono>
+#include <charconv>
+#include <stdexcept>
+#include <memory_resource>
+
 #include "httplib.h"
 #include "json.hpp"
 #include "call-center.h"
 #include "cdr.h"
 #include "http-server.h"
+#include "http-router.h"
+#include "epoll-server.h"
+#include "cdr-format.h"
+#include "response-writer.h"
+#include "request-arena.h"
+
+namespace{
+
+// Max number of calls in one POST /calls request
+constexpr size_t maxCallsBatchSize = 10000;
+
+// Call in POST /calls: phone number or
+// {"phone_number" : "...", "receive_time" : Unix time}
+bool parseBatchCall(const nlohmann::json & call, Cdr & cdr){
+    auto phoneNum = &call;
+    if (call.is_object()){
+        auto found = call.find("phone_number");
+        if (found == call.end())
+            return false;
+        phoneNum = &*found;
+        auto receiveTime = call.find("receive_time");
+        if (receiveTime != call.end()){
+            if (!receiveTime->is_number_integer())
+                return false;
+            cdr.receiveDT = cdr::fromUnixTime(receiveTime->get<int64_t>());
+        }
+    }
+    if (!phoneNum->is_string())
+        return false;
+    return cdr.phoneNumber.assign(phoneNum->get_ref<const std::string &>());
+}
+
+enum class BatchParse{
+    ok,
+    invalid,
+    // More than maxCallsBatchSize calls
+    tooLarge
+};
+
+// JSON array or NDJSON (one call per line). Parsing stops at the
+// first call over maxCallsBatchSize
+BatchParse parseBatch(const std::string & body, nlohmann::json & calls,
+                      bool & isArray){
+    auto first = body.find_first_not_of(" \t\r\n");
+    isArray = first != std::string::npos && body[first] == '[';
+    try{
+        if (isArray){
+            size_t nCalls = 0;
+            // Calls are values, objects or arrays of depth 1
+            calls = nlohmann::json::parse(body,
+                [&](int depth, nlohmann::json::parse_event_t event,
+                    nlohmann::json &){
+                    using Event = nlohmann::json::parse_event_t;
+                    if (depth == 1 && (event == Event::value ||
+                                       event == Event::object_start ||
+                                       event == Event::array_start) &&
+                        ++nCalls > maxCallsBatchSize)
+                        throw std::length_error("too many calls");
+                    return true;
+                });
+            return BatchParse::ok;
+        }
+        calls = nlohmann::json::array();
+        size_t begin = 0;
+        while (begin < body.size()){
+            auto end = body.find('\n', begin);
+            if (end == std::string::npos)
+                end = body.size();
+            if (body.find_first_not_of(" \t\r", begin) < end){
+                if (calls.size() == maxCallsBatchSize)
+                    return BatchParse::tooLarge;
+                calls.push_back(nlohmann::json::parse(body.begin() + begin,
+                                                      body.begin() + end));
+            }
+            begin = end + 1;
+        }
+    }
+    catch(const std::length_error &){
+        return BatchParse::tooLarge;
+    }
+    catch(...){
+        return BatchParse::invalid;
+    }
+    return BatchParse::ok;
+}
+
+// Call in DELETE /calls: phone number,
+// {"phone_number" : "..."} or {"call_id" : N}
+bool cancelBatchCall(CallCenter & callCenter, const nlohmann::json & call,
+                     bool & valid, Cdr & cdr){
+    valid = false;
+    PhoneNumber phoneNumber;
+    if (call.is_object()){
+        auto callId = call.find("call_id");
+        if (callId != call.end()){
+            if (!callId->is_number_unsigned())
+                return false;
+            valid = true;
+            return callCenter.cancelCall(callId->get<size_t>(), cdr);
+        }
+        auto found = call.find("phone_number");
+        if (found == call.end() || !found->is_string())
+            return false;
+        valid = phoneNumber.assign(found->get_ref<const std::string &>());
+    }
+    else if (call.is_string())
+        valid = phoneNumber.assign(call.get_ref<const std::string &>());
+    return valid && callCenter.cancelCall(phoneNumber, cdr);
+}
+
+// Call of DELETE /call and GET /call/position:
+// ?call_id= or ?phone_number=. Returns false for invalid request
+bool parseCallParams(const httplib::Request & req, bool & byCallId,
+                     size_t & callId, PhoneNumber & phoneNumber){
+    if (auto param = req.params.find("call_id");
+        param != req.params.end()){
+        auto & value = param->second;
+        auto [ptr, ec] = std::from_chars(value.data(),
+                                         value.data() + value.size(),
+                                         callId);
+        byCallId = true;
+        return ec == std::errc() && ptr == value.data() + value.size();
+    }
+    auto param = req.params.find("phone_number");
+    byCallId = false;
+    return param != req.params.end() && phoneNumber.assign(param->second);
+}
+
+void setPosition(const CallCenter::QueuePosition & position,
+                 nlohmann::json & ans){
+    ans["position"] = position.position;
+    ans["estimated_wait"] = position.estimatedWait;
+}
+
+// Call shed by load shedding
+void setShed(httplib::Response & res, const uint32_t retryAfter){
+    res.status = 503;
+    res.set_header("Retry-After", std::to_string(retryAfter));
+}
+
+// Waiting for dispatcher to apply PATCH /admin/config
+constexpr std::chrono::seconds configApplyTimeout{1};
+
+// Config parameters with version
+nlohmann::json configAnswer(const CallCenter::Config & config){
+    auto ans = CallCenter::toJson(config);
+    ans["version"] = config.version;
+    return ans;
+}
+
+// GET /trace window
+constexpr uint32_t defaultTraceSeconds = 10;
+
+// /events stream poll returns after appending this much data,
+// ingress writes it and polls again
+constexpr size_t maxEventsPollSize = 1 << 20;
+// Comment sent to idle /events stream
+constexpr std::chrono::seconds eventsHeartbeat{15};
+
+// Server-Sent Event:
+// event: <type>
+// data: {"call_id":N,"phone_number":"...","time":Unix time,...}
+// operator_id is added for answered and ended calls,
+// call_status for finished calls
+void appendEvent(const CallEvents::Event & event, std::string & out){
+    using namespace cdrformat;
+    using Type = CallEvents::Type;
+    auto & cdr = event.cdr;
+    char buffer[maxRecordSize];
+    auto p = append(buffer, "event: ");
+    p = append(p, CallEvents::toString(event.type));
+    p = append(p, "\ndata: {\"call_id\":");
+    p = append(p, cdr.callId);
+    p = append(p, ",\"phone_number\":");
+    p = appendJson(p, cdr.phoneNumber.view());
+    p = append(p, ",\"time\":");
+    p = append(p, toUnixTime(event.type == Type::queued ? cdr.receiveDT :
+                             event.type == Type::answered ? cdr.responseDT :
+                                                            cdr.endDT));
+    if (event.type == Type::answered || event.type == Type::ended){
+        p = append(p, ",\"operator_id\":");
+        p = append(p, cdr.operatorId);
+    }
+    if (CallEvents::isFinal(event.type)){
+        p = append(p, ",\"call_status\":\"");
+        p = append(p, statusName(cdr.callStatus));
+        p = append(p, "\"");
+    }
+    p = append(p, "}\n\n");
+    out.append(buffer, p);
+}
+
+};
+
+HttpServer::HttpServer() :
+    ingress{Ingress::httplib},
+    nThreads{0}
+{}
+
+void HttpServer::setIngress(const Ingress ingress, const size_t nThreads){
+    this->ingress = ingress;
+    this->nThreads = nThreads;
+}
+
+bool HttpServer::parseIngress(const std::string & str, Ingress & ingress){
+    if (str == "httplib")
+        ingress = Ingress::httplib;
+    else if (str == "epoll")
+        ingress = Ingress::epoll;
+    else
+        return false;
+    return true;
+}
 
 bool HttpServer::listen(const std::string &host, const int port, std::shared_ptr<CallCenter> callCenter){
-    httplib::Server svr;
+    HttpRouter svr;
 
-    svr.Get("/call", [&](const httplib::Request& req, httplib::Response& res) {
-        res.set_content(req.body, "text/plain");
-        if (req.has_param("phone_number")) {
-            std::string phoneNum = req.get_param_value("phone_number");
-            nlohmann::json ans;
+    svr.get("/call", [&](const httplib::Request& req, httplib::Response& res) {
+        callCenter->getCallTrace().markReceived();
+        auto phoneNum = req.params.find("phone_number");
+        if (phoneNum == req.params.end()){
+            res.status = 400;
+            return;
+        }
+        Cdr cdr;
+        if (!cdr.phoneNumber.assign(phoneNum->second)){
+            res.status = 400;
+            return;
+        }
+        uint32_t retryAfter;
+        if (callCenter->shedCalls(1, retryAfter)){
+            setShed(res, retryAfter);
+            return;
+        }
+        cdr.receiveDT = cdr::now();
+        CallCenter::QueuePosition position;
+        callCenter->pushCall(cdr, &position);
+        auto ans = cdr.callStatus == CallStatus::ok ?
+            response::writeCallAnswer(cdr.callId, cdr.callStatus,
+                                      position.position,
+                                      position.estimatedWait) :
+            response::writeCallAnswer(cdr.callId, cdr.callStatus);
+        // Content type is kept for compatibility with existing clients
+        res.set_content(ans.data(), ans.size(), "text/plain");
+    });
+
+    svr.post("/calls", [&](const httplib::Request& req, httplib::Response& res) {
+        callCenter->getCallTrace().markReceived();
+        nlohmann::json calls;
+        bool isArray;
+        auto parsed = parseBatch(req.body, calls, isArray);
+        if (parsed != BatchParse::ok){
+            res.status = parsed == BatchParse::tooLarge ? 413 : 400;
+            return;
+        }
+        uint32_t retryAfter;
+        if (callCenter->shedCalls(calls.size(), retryAfter)){
+            setShed(res, retryAfter);
+            return;
+        }
+
+        const auto receiveDT = cdr::now();
+        std::vector<Cdr> cdrs;
+        std::pmr::vector<bool> valid(calls.size(),
+                                     RequestArena::local().get());
+        cdrs.reserve(calls.size());
+        for (size_t i = 0; i < calls.size(); ++i){
             Cdr cdr;
-            cdr.phoneNumber = phoneNum;
-            cdr.receiveDT =  std::chrono::steady_clock::now();
-            callCenter->pushCall(cdr);
-            ans["call_id"] = cdr.callId;
+            cdr.receiveDT = receiveDT;
+            valid[i] = parseBatchCall(calls[i], cdr);
+            if (valid[i])
+                cdrs.push_back(cdr);
+        }
+        callCenter->pushCalls(cdrs);
+
+        // Results in order of calls in request. Buffered, not streamed:
+        // all of them are known after the single queue lock
+        // Written in place, httplib would copy a separate string
+        auto & body = res.body;
+        body.reserve(calls.size() * (response::detail::maxCallAnswerSize + 1) + 2);
+        if (isArray)
+            body += '[';
+        auto cdr = cdrs.begin();
+        for (size_t i = 0; i < calls.size(); ++i){
+            if (isArray && i > 0)
+                body += ',';
+            if (valid[i]){
+                body += response::writeCallAnswer(cdr->callId,
+                                                  cdr->callStatus);
+                ++cdr;
+            }
+            else
+                body += "{\"error\":\"invalid call\"}";
+            if (!isArray)
+                body += '\n';
+        }
+        if (isArray)
+            body += ']';
+        res.set_header("Content-Type", isArray ? "application/json" :
+                                                 "application/x-ndjson");
+    });
+
+    // Caller hung up: call waiting in queue is removed
+    // by phone_number or call_id
+    svr.del("/call", [&](const httplib::Request& req, httplib::Response& res) {
+        bool byCallId;
+        size_t callId;
+        PhoneNumber phoneNumber;
+        if (!parseCallParams(req, byCallId, callId, phoneNumber)){
+            res.status = 400;
+            return;
+        }
+        Cdr cdr;
+        if (!(byCallId ? callCenter->cancelCall(callId, cdr) :
+                         callCenter->cancelCall(phoneNumber, cdr))){
+            res.status = 404;
+            return;
+        }
+        auto ans = response::writeCallAnswer(cdr.callId, cdr.callStatus);
+        res.set_content(ans.data(), ans.size(), "application/json");
+    });
+
+    // Bulk cancel for gateways, format of POST /calls
+    svr.del("/calls", [&](const httplib::Request& req, httplib::Response& res) {
+        nlohmann::json calls;
+        bool isArray;
+        auto parsed = parseBatch(req.body, calls, isArray);
+        if (parsed != BatchParse::ok){
+            res.status = parsed == BatchParse::tooLarge ? 413 : 400;
+            return;
+        }
+
+        // Results in order of calls in request
+        // Written in place, httplib would copy a separate string
+        auto & body = res.body;
+        body.reserve(calls.size() * (response::detail::maxCallAnswerSize + 1) + 2);
+        if (isArray)
+            body += '[';
+        for (size_t i = 0; i < calls.size(); ++i){
+            if (isArray && i > 0)
+                body += ',';
+            Cdr cdr;
+            bool valid;
+            if (cancelBatchCall(*callCenter, calls[i], valid, cdr))
+                body += response::writeCallAnswer(cdr.callId,
+                                                  cdr.callStatus);
+            else if (valid)
+                body += "{\"error\":\"not found\"}";
+            else
+                body += "{\"error\":\"invalid call\"}";
+            if (!isArray)
+                body += '\n';
+        }
+        if (isArray)
+            body += ']';
+        res.set_header("Content-Type", isArray ? "application/json" :
+                                                 "application/x-ndjson");
+    });
+
+    // Place in line of call waiting in queue
+    svr.get("/call/position", [&](const httplib::Request& req, httplib::Response& res) {
+        bool byCallId;
+        size_t callId;
+        PhoneNumber phoneNumber;
+        if (!parseCallParams(req, byCallId, callId, phoneNumber)){
+            res.status = 400;
+            return;
+        }
+        CallCenter::QueuePosition position;
+        if (!(byCallId ? callCenter->getQueuePosition(callId, position) :
+                         callCenter->getQueuePosition(phoneNumber, position))){
+            res.status = 404;
+            return;
+        }
+        auto ans = response::writePositionAnswer(position.callId,
+                                                 position.position,
+                                                 position.estimatedWait);
+        res.set_content(ans.data(), ans.size(), "application/json");
+    });
+
+    svr.get(R"(/call/(\d+))", [&](const httplib::Request& req, httplib::Response& res) {
+        const auto id = req.matches[1].str();
+        size_t callId;
+        auto [ptr, ec] = std::from_chars(id.data(), id.data() + id.size(),
+                                         callId);
+        if (ec != std::errc() || ptr != id.data() + id.size()){
+            res.status = 400;
+            return;
+        }
+        CallIndex::Entry entry;
+        if (!callCenter->findCall(callId, entry)){
+            res.status = 404;
+            return;
+        }
+        const auto & cdr = entry.cdr;
+        nlohmann::json ans;
+        ans["call_id"] = cdr.callId;
+        ans["state"] = toString(entry.state);
+        ans["phone_number"] = cdr.phoneNumber.view();
+        ans["receive_time"] = toUnixTime(cdr.receiveDT);
+        if (CallIndex::isFinished(entry.state))
             ans["call_status"] = toString(cdr.callStatus);
-            res.body.append(ans.dump());    
+        CallCenter::QueuePosition position;
+        if (entry.state == CallIndex::State::queued &&
+            callCenter->getQueuePosition(callId, position))
+            setPosition(position, ans);
+        if (entry.state == CallIndex::State::serving ||
+            entry.state == CallIndex::State::ended){
+            ans["operator_id"] = cdr.operatorId;
+            ans["response_time"] = toUnixTime(cdr.responseDT);
+            ans["call_duration"] = cdr.callDuration;
         }
-        else
+        if (entry.state == CallIndex::State::ended ||
+            entry.state == CallIndex::State::timeout ||
+            entry.state == CallIndex::State::abandoned)
+            ans["end_time"] = toUnixTime(cdr.endDT);
+        res.set_content(ans.dump(), "application/json");
+    });
+
+    // Prometheus scrape
+    svr.get("/metrics", [&](const httplib::Request&, httplib::Response& res) {
+        res.set_content(Metrics::format(callCenter->getMetrics()),
+                        "text/plain; version=0.0.4");
+    });
+
+    svr.get("/kpi", [&](const httplib::Request&, httplib::Response& res) {
+        nlohmann::json ans;
+        ans["service_level_time"] = callCenter->getServiceLevelTime();
+        for (auto window : {Kpi::Window::m1, Kpi::Window::m5,
+                            Kpi::Window::m15, Kpi::Window::h1}){
+            auto kpi = callCenter->getKpi(window);
+            auto & w = ans["windows"][Kpi::toString(window)];
+            w["offered"] = kpi.offered;
+            w["rejected"] = kpi.rejected;
+            w["answered"] = kpi.answered;
+            w["timed_out"] = kpi.timedOut;
+            w["abandoned"] = kpi.abandoned;
+            w["ended"] = kpi.ended;
+            w["average_speed_of_answer"] = kpi.getAverageSpeedOfAnswer();
+            w["service_level"] = kpi.getServiceLevel();
+            w["timeout_rate"] = kpi.getTimeoutRate();
+            w["average_handle_time"] = kpi.getAverageHandleTime();
+        }
+        auto overload = callCenter->getOverload();
+        auto & shedding = ans["load_shedding"];
+        shedding["enabled"] = overload.enabled;
+        shedding["shed"] = overload.shed;
+        shedding["arrival_rate"] = overload.arrivalRate;
+        shedding["drain_rate"] = overload.drainRate;
+        res.set_content(ans.dump(), "application/json");
+    });
+
+    // Stages of sampled calls of the last seconds (default 10)
+    // as Chrome trace JSON
+    svr.get("/trace", [&](const httplib::Request& req, httplib::Response& res) {
+        uint32_t seconds = defaultTraceSeconds;
+        if (auto param = req.params.find("seconds");
+            param != req.params.end()){
+            auto & value = param->second;
+            auto [ptr, ec] = std::from_chars(value.data(),
+                                             value.data() + value.size(),
+                                             seconds);
+            if (ec != std::errc() || ptr != value.data() + value.size()){
+                res.status = 400;
+                return;
+            }
+        }
+        res.set_content(callCenter->getCallTrace().dump(seconds),
+                        "application/json");
+    });
+
+    svr.get("/admin/config", [&](const httplib::Request&, httplib::Response& res) {
+        auto ans = configAnswer(callCenter->getConfig());
+        // Index of schedule window applied now, null outside of windows
+        const auto activeWindow = callCenter->getActiveConfig().activeWindow;
+        ans["active_window"] = activeWindow == Schedule::noWindow ?
+            nlohmann::json() : nlohmann::json(activeWindow);
+        res.set_content(ans.dump(), "application/json");
+    });
+
+    // Changes config parameters given in body. With "version" the
+    // change is applied only if config wasn't changed after that
+    // version (409 otherwise). ?persist=true writes parameters into
+    // configuration file. Answers after dispatcher applied the change
+    svr.patch("/admin/config", [&](const httplib::Request& req, httplib::Response& res) {
+        nlohmann::json patch;
+        try{
+            patch = nlohmann::json::parse(req.body);
+        }
+        catch(...){
             res.status = 400;
+            return;
+        }
+        if (!patch.is_object()){
+            res.status = 400;
+            return;
+        }
+        const auto current = callCenter->getConfig();
+        uint64_t expectedVersion = current.version;
+        if (auto version = patch.find("version"); version != patch.end()){
+            if (!version->is_number_unsigned()){
+                res.status = 400;
+                return;
+            }
+            expectedVersion = *version;
+            patch.erase(version);
+        }
+        auto conf = CallCenter::toJson(current);
+        for (auto & param : patch.items())
+            if (!conf.contains(param.key())){
+                res.status = 400;
+                nlohmann::json ans;
+                ans["error"] = "unknown parameter: " + param.key();
+                res.set_content(ans.dump(), "application/json");
+                return;
+            }
+        // Replaced as a whole: distribution of another type doesn't
+        // keep old parameters, null patience disables it
+        for (auto & param : patch.items())
+            conf[param.key()] = param.value();
+        CallCenter::Config config;
+        // History is refreshed by configuration watcher
+        if (!CallCenter::readConfig(conf, config, false)){
+            res.status = 400;
+            res.set_content("{\"error\":\"invalid parameters\"}",
+                            "application/json");
+            return;
+        }
+
+        const auto begin = std::chrono::steady_clock::now();
+        // Version of this change, not of a change made meanwhile
+        std::shared_ptr<const CallCenter::Config> published;
+        auto result = callCenter->setConfig(config, expectedVersion,
+                                            &published);
+        if (result != CallCenter::ConfigResult::ok){
+            res.status = result == CallCenter::ConfigResult::conflict ?
+                409 : 400;
+            res.set_content(configAnswer(*published).dump(),
+                            "application/json");
+            return;
+        }
+        const bool applied = callCenter->waitConfigApplied(
+            published->version, configApplyTimeout);
+        const auto latency = std::chrono::duration_cast<
+            std::chrono::microseconds>(std::chrono::steady_clock::now() -
+                                       begin);
+        auto ans = configAnswer(*published);
+        ans["applied"] = applied;
+        ans["apply_latency_us"] = latency.count();
+        if (req.get_param_value("persist") == "true")
+            ans["persisted"] = callCenter->persistConfig();
+        res.set_content(ans.dump(), "application/json");
+    });
+
+    // Call lifecycle events (Server-Sent Events).
+    // With call_id only events of the call are sent,
+    // stream ends after the call is finished
+    svr.stream("/events", [&](const httplib::Request& req,
+                              httplib::Response& res) -> HttpRouter::StreamPoll {
+        // Subscribed before call lookup, so call finishing
+        // after lookup is not missed
+        CallEvents::Subscriber subscriber(callCenter->getCallEvents());
+        uint64_t callId = 0;
+        auto param = req.params.find("call_id");
+        const bool filter = param != req.params.end();
+        if (filter){
+            auto & value = param->second;
+            auto [ptr, ec] = std::from_chars(value.data(),
+                                             value.data() + value.size(),
+                                             callId);
+            if (ec != std::errc() || ptr != value.data() + value.size()){
+                res.status = 400;
+                return nullptr;
+            }
+            CallIndex::Entry entry;
+            if (!callCenter->findCall(callId, entry) ||
+                CallIndex::isFinished(entry.state)){
+                res.status = 404;
+                return nullptr;
+            }
+        }
+        res.set_header("Content-Type", "text/event-stream");
+        res.set_header("Cache-Control", "no-cache");
+        return [subscriber, filter, callId,
+                lastWrite = std::chrono::steady_clock::now()]
+               (std::string & out) mutable {
+            const auto size = out.size();
+            CallEvents::Event event;
+            while (out.size() - size < maxEventsPollSize){
+                auto result = subscriber.next(event);
+                if (result == CallEvents::Result::empty)
+                    break;
+                // Slow subscriber is dropped
+                if (result == CallEvents::Result::lagged){
+                    out += "event: lagged\ndata: {}\n\n";
+                    return false;
+                }
+                if (filter && event.cdr.callId != callId)
+                    continue;
+                appendEvent(event, out);
+                if (filter && CallEvents::isFinal(event.type))
+                    return false;
+            }
+            auto now = std::chrono::steady_clock::now();
+            if (out.size() != size)
+                lastWrite = now;
+            else if (now - lastWrite >= eventsHeartbeat){
+                out += ":\n\n";
+                lastWrite = now;
+            }
+            return true;
+        };
     });
 
-    return svr.listen(host, port);
+    svr.setStreamWakeup(callCenter->getCallEvents().getWakeup());
+    if (ingress == Ingress::epoll){
+        EpollServer epollSvr(svr);
+        return epollSvr.listen(host, port, nThreads);
+    }
+    httplib::Server httplibSvr;
+    svr.mount(httplibSvr);
+    return httplibSvr.listen(host, port);
 }
@@ -0,0 +1,111 @@
+#include <time.h>
+
+#include <atomic>
+
+#include "id-generator.h"
+
+using namespace idgen;
+
+namespace{
+
+// 2024-01-01T00:00:00Z
+constexpr int64_t epochMs = 1704067200000;
+constexpr uint32_t nLanes = 1u << laneBits;
+// Used by threads started when all other lanes are owned
+constexpr uint32_t sharedLane = nLanes - 1;
+constexpr uint64_t timeMask = (1ull << timeBits) - 1;
+constexpr uint64_t sequenceMask = (1ull << sequenceBits) - 1;
+
+std::atomic<uint32_t> nodeId{0};
+// Owned lanes bit mask
+std::atomic<uint64_t> ownedLanes{1ull << sharedLane};
+
+// Lane state: time << sequenceBits | sequence of the last id.
+// Kept after owner thread exit, so next owner continues the sequence
+struct alignas(64) Lane{
+    std::atomic<uint64_t> state{0};
+};
+Lane lanes[nLanes];
+
+class LaneOwner{
+public:
+    LaneOwner() :
+        lane{sharedLane}
+    {
+        auto owned = ownedLanes.load(std::memory_order_relaxed);
+        while (~owned){
+            uint32_t free = __builtin_ctzll(~owned);
+            if (ownedLanes.compare_exchange_weak(owned, owned | (1ull << free),
+                                                 std::memory_order_acquire)){
+                lane = free;
+                break;
+            }
+        }
+    }
+    ~LaneOwner(){
+        if (lane != sharedLane)
+            ownedLanes.fetch_and(~(1ull << lane), std::memory_order_release);
+    }
+    uint32_t getLane() const{
+        return lane;
+    }
+
+private:
+    uint32_t lane;
+};
+
+// Coarse clock is read from vDSO in a few ns (resolution ~1-4 ms)
+uint64_t nowMs(){
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+    return ts.tv_sec * 1000 + ts.tv_nsec / 1000000 - epochMs;
+}
+
+// Sequence overflow carries into time, borrowing the next millisecond
+uint64_t advance(const uint64_t state, const uint64_t now){
+    if (now > (state >> sequenceBits))
+        return now << sequenceBits;
+    return state + 1;
+}
+
+};
+
+uint64_t idgen::next(){
+    thread_local LaneOwner owner;
+    const auto lane = owner.getLane();
+    auto & state = lanes[lane].state;
+    const auto now = nowMs();
+    uint64_t next;
+    if (lane != sharedLane){
+        next = advance(state.load(std::memory_order_relaxed), now);
+        state.store(next, std::memory_order_relaxed);
+    }
+    else{
+        auto current = state.load(std::memory_order_relaxed);
+        do
+            next = advance(current, now);
+        while (!state.compare_exchange_weak(current, next,
+                                            std::memory_order_relaxed));
+    }
+    return ((next >> sequenceBits) & timeMask) <<
+               (nodeBits + laneBits + sequenceBits) |
+           static_cast<uint64_t>(nodeId.load(std::memory_order_relaxed)) <<
+               (laneBits + sequenceBits) |
+           static_cast<uint64_t>(lane) << sequenceBits |
+           (next & sequenceMask);
+}
+
+bool idgen::setNodeId(const uint32_t nodeId){
+    if (nodeId > maxNodeId)
+        return false;
+    ::nodeId = nodeId;
+    return true;
+}
+
+uint32_t idgen::getNodeId(){
+    return nodeId;
+}
+
+int64_t idgen::toUnixTimeMs(const uint64_t idTime){
+    return epochMs + idTime;
+}
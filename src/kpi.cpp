@@ -0,0 +1,113 @@
+#include "kpi.h"
+
+using namespace cdr;
+
+Kpi::Kpi() :
+    serviceLevelTime{20}
+{
+    rings[static_cast<size_t>(Window::m1)].bucketWidth = 60 / nBuckets;
+    rings[static_cast<size_t>(Window::m5)].bucketWidth = 300 / nBuckets;
+    rings[static_cast<size_t>(Window::m15)].bucketWidth = 900 / nBuckets;
+    rings[static_cast<size_t>(Window::h1)].bucketWidth = 3600 / nBuckets;
+}
+
+void Kpi::onPush(const CallStatus callStatus, const Seconds now){
+    if (callStatus == CallStatus::ok)
+        add<1>({offered}, {1}, now);
+    else
+        add<2>({offered, rejected}, {1, 1}, now);
+}
+
+void Kpi::onAnswer(const Seconds waitTime, const Seconds now){
+    if (waitTime <= serviceLevelTime)
+        add<3>({answered, answeredInTime, Counter::waitTime},
+               {1, 1, waitTime}, now);
+    else
+        add<2>({answered, Counter::waitTime}, {1, waitTime}, now);
+}
+
+void Kpi::onTimeout(const Seconds now){
+    add<1>({timedOut}, {1}, now);
+}
+
+void Kpi::onAbandon(const Seconds now){
+    add<1>({abandoned}, {1}, now);
+}
+
+void Kpi::onEnd(const Seconds handleTime, const Seconds now){
+    add<2>({ended, Counter::handleTime}, {1, handleTime}, now);
+}
+
+template <size_t N>
+void Kpi::add(const std::array<Counter, N> & counters,
+              const std::array<uint64_t, N> & values,
+              const Seconds now){
+    for (auto & ring : rings){
+        auto & bucket = getBucket(ring, now / ring.bucketWidth);
+        for (size_t i = 0; i < N; ++i)
+            bucket.counters[counters[i]].fetch_add(values[i],
+                                                   std::memory_order_relaxed);
+    }
+}
+
+// Returns bucket of the slot, resetting it if it holds an old slot
+Kpi::Bucket & Kpi::getBucket(Ring & ring, const uint32_t slot){
+    auto & bucket = ring.buckets[slot % nBuckets];
+    auto bucketSlot = bucket.slot.load(std::memory_order_acquire);
+    while (bucketSlot != slot){
+        if (bucketSlot != resetting && bucketSlot < slot &&
+            bucket.slot.compare_exchange_weak(bucketSlot, resetting,
+                                              std::memory_order_acquire)){
+            for (auto & counter : bucket.counters)
+                counter.store(0, std::memory_order_relaxed);
+            bucket.slot.store(slot, std::memory_order_release);
+            break;
+        }
+        // Late writer of the previous slot lands in the current one
+        if (bucketSlot != resetting && bucketSlot > slot)
+            break;
+        bucketSlot = bucket.slot.load(std::memory_order_acquire);
+    }
+    return bucket;
+}
+
+Kpi::Snapshot Kpi::get(const Window window, const Seconds now) const{
+    auto & ring = rings[static_cast<size_t>(window)];
+    const uint32_t last = now / ring.bucketWidth;
+    const uint32_t first = last >= nBuckets ? last - nBuckets + 1 : 0;
+    std::array<uint64_t, nCounters> sums{};
+    for (auto & bucket : ring.buckets){
+        auto slot = bucket.slot.load(std::memory_order_acquire);
+        if (slot == resetting || slot < first || slot > last)
+            continue;
+        for (size_t i = 0; i < nCounters; ++i)
+            sums[i] += bucket.counters[i].load(std::memory_order_relaxed);
+    }
+
+    Snapshot snapshot;
+    snapshot.window = ring.bucketWidth * nBuckets;
+    snapshot.offered = sums[offered];
+    snapshot.rejected = sums[rejected];
+    snapshot.answered = sums[answered];
+    snapshot.answeredInTime = sums[answeredInTime];
+    snapshot.timedOut = sums[timedOut];
+    snapshot.abandoned = sums[abandoned];
+    snapshot.ended = sums[ended];
+    snapshot.waitTime = sums[waitTime];
+    snapshot.handleTime = sums[handleTime];
+    return snapshot;
+}
+
+const char * Kpi::toString(const Window window){
+    switch (window){
+    case Window::m1:
+        return "1m";
+    case Window::m5:
+        return "5m";
+    case Window::m15:
+        return "15m";
+    case Window::h1:
+        return "1h";
+    }
+    return "";
+}
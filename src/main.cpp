@@ -5,19 +5,73 @@
 
 #include "call-center.h"
 #include "http-server.h"
+#include "binary-server.h"
+#include "sip-server.h"
+#include "config-watcher.h"
+#include "async-log.h"
 
 INITIALIZE_EASYLOGGINGPP
 
+// Hot path messages formatted by async log writer thread.
+// Written with the function of the call site (%func), time of logging
+// is added to the message, the logger prints the time of writing
+void writeLog(const AsyncLog::Record & record, const std::string & msg){
+    el::Level level = el::Level::Info;
+    switch (record.level){
+        case AsyncLog::Level::debug:
+            level = el::Level::Debug;
+            break;
+        case AsyncLog::Level::info:
+            level = el::Level::Info;
+            break;
+        case AsyncLog::Level::warning:
+            level = el::Level::Warning;
+            break;
+        case AsyncLog::Level::error:
+            level = el::Level::Error;
+            break;
+    }
+    el::base::Writer(level, __FILE__, __LINE__, record.func).construct(
+        1, ELPP_CURR_FILE_LOGGER_ID) << msg << " [logged " <<
+        AsyncLog::formatTime(record.time) << "]";
+}
+
+// Levels enabled in logger configuration and not disabled at compile time
+uint32_t enabledLogLevels(){
+    auto logger = el::Loggers::getLogger("default");
+    uint32_t levels = 0;
+    auto enable = [&](const bool compiled, const el::Level elLevel,
+                      const AsyncLog::Level level){
+        if (compiled && logger->enabled(elLevel))
+            levels |= AsyncLog::levelBit(level);
+    };
+    enable(ELPP_DEBUG_LOG, el::Level::Debug, AsyncLog::Level::debug);
+    enable(ELPP_INFO_LOG, el::Level::Info, AsyncLog::Level::info);
+    enable(ELPP_WARNING_LOG, el::Level::Warning, AsyncLog::Level::warning);
+    enable(ELPP_ERROR_LOG, el::Level::Error, AsyncLog::Level::error);
+    return levels;
+}
+
 void runCallCenter(std::shared_ptr<CallCenter> callCenter){
     callCenter->run();
 }
-void reloadConf(size_t everyNSec, std::shared_ptr<CallCenter> callCenter){
-    if (everyNSec == 0)
+void runBinaryServer(std::string address, size_t nThreads,
+                     std::shared_ptr<CallCenter> callCenter){
+    BinaryServer svr;
+    if (!svr.listen(address, nThreads, callCenter))
+        LOG(ERROR) << "Can't listen binary ingress on " << address;
+}
+void runSipServer(std::string address, size_t nThreads,
+                  std::shared_ptr<CallCenter> callCenter){
+    SipServer svr;
+    if (!svr.listen(address, nThreads, callCenter))
+        LOG(ERROR) << "Can't listen SIP ingress on " << address;
+}
+void reloadConf(size_t pollEveryNSec, std::shared_ptr<CallCenter> callCenter){
+    if (pollEveryNSec == 0)
         return;
-    while (true){
-        std::this_thread::sleep_for(std::chrono::duration<long long>(everyNSec));
-        callCenter->configure();
-   }
+    ConfigWatcher watcher(callCenter, std::chrono::seconds(pollEveryNSec));
+    watcher.run();
 }
 
 int main(int argc, char *argv[]){
@@ -33,9 +87,25 @@ int main(int argc, char *argv[]){
 
     // Run call center
     auto callCenter = CallCenter::getCallCenter("call-center.json");
+    // Parameters read below are validated by configuring
+    if (callCenter->getConfig().version == 0){
+        std::cerr << "Invalid configuration\n";
+        return 2;
+    }
+    auto callCenterConf = callCenter->getConfiguration();
+
+    // Text logging can be replaced by binary event log
+    if (!callCenterConf["textLog"].get<bool>()){
+        LOG(INFO) << "Text logging disabled";
+        el::Loggers::reconfigureAllLoggers(el::ConfigurationType::Enabled,
+                                           "false");
+    }
+    else
+        AsyncLog::instance().start(writeLog, enabledLogLevels());
     std::thread callCenterTh(runCallCenter, callCenter);
 
-    // Run reload configuration thread
+    // Run reload configuration thread. Files are watched with inotify,
+    // the period is used for polling when inotify is unavailable
     if (argc > 3){
         std::stringstream ss(argv[3]);
         size_t reloadEveryNSec;
@@ -46,8 +116,33 @@ int main(int argc, char *argv[]){
         }
     }
 
+    // Run binary ingress
+    std::string binaryIngress = callCenterConf["binaryIngress"];
+    if (!binaryIngress.empty()){
+        std::thread binaryServerTh(runBinaryServer, binaryIngress,
+                                   callCenterConf["binaryIngressThreads"],
+                                   callCenter);
+        binaryServerTh.detach();
+    }
+
+    // Run SIP ingress
+    std::string sipIngress = callCenterConf["sipIngress"];
+    if (!sipIngress.empty()){
+        std::thread sipServerTh(runSipServer, sipIngress,
+                                callCenterConf["sipIngressThreads"],
+                                callCenter);
+        sipServerTh.detach();
+    }
+
     // Run http server
     HttpServer svr;
+    HttpServer::Ingress ingress;
+    if (!HttpServer::parseIngress(callCenterConf["httpIngress"], ingress)){
+        std::cerr << "Invalid httpIngress: " <<
+            callCenterConf["httpIngress"] << "\n";
+        return 2;
+    }
+    svr.setIngress(ingress, callCenterConf["httpIngressThreads"]);
     if (!svr.listen(std::string(argv[1]), atoi(argv[2]), callCenter)){
         std::cerr << "Invalid host or port format\n";
         return 2;
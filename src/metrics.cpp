@@ -0,0 +1,92 @@
+#include "metrics.h"
+
+static_assert(sizeof(Metrics::Counters) % 64 == 0,
+              "Counters should be padded to cache lines");
+
+static std::atomic<uint64_t> nextId{1};
+
+Metrics::Metrics() :
+    id{nextId.fetch_add(1, std::memory_order_relaxed)}
+{}
+
+Metrics::Counters & Metrics::local(){
+    struct Local{
+        uint64_t owner = 0;
+        std::shared_ptr<Counters> counters;
+    };
+    thread_local Local local;
+    if (local.owner != id){
+        local.counters = std::make_shared<Counters>();
+        local.owner = id;
+        std::lock_guard<std::mutex> lck(countersMtx);
+        counters.push_back(local.counters);
+    }
+    return *local.counters;
+}
+
+Metrics::Snapshot Metrics::collect() const{
+    Snapshot snapshot{};
+    std::lock_guard<std::mutex> lck(countersMtx);
+    for (auto & c : counters){
+        for (size_t i = 0; i < nStatuses; ++i)
+            snapshot.pushed[i] += c->pushed[i].load(std::memory_order_relaxed);
+        snapshot.shed += c->shed.load(std::memory_order_relaxed);
+        snapshot.dispatcherIterations +=
+            c->dispatcherIterations.load(std::memory_order_relaxed);
+        // Other threads don't write gauges, their values are 0
+        snapshot.freeOperators +=
+            c->freeOperators.load(std::memory_order_relaxed);
+        snapshot.servicedCalls +=
+            c->servicedCalls.load(std::memory_order_relaxed);
+    }
+    return snapshot;
+}
+
+std::string Metrics::format(const Snapshot & snapshot){
+    std::string out;
+    auto header = [&out](const char * name, const char * type,
+                         const char * help){
+        out += "# HELP ";
+        out += name;
+        out += " ";
+        out += help;
+        out += "\n# TYPE ";
+        out += name;
+        out += " ";
+        out += type;
+        out += "\n";
+    };
+    auto metric = [&out](const char * name, const uint64_t value){
+        out += name;
+        out += " " + std::to_string(value) + "\n";
+    };
+
+    header("call_center_pushed_calls_total", "counter",
+           "Calls pushed into the call queue by call status");
+    for (size_t i = 0; i < nStatuses; ++i){
+        out += "call_center_pushed_calls_total{status=\"";
+        out += cdr::statusNames[i];
+        out += "\"} " + std::to_string(snapshot.pushed[i]) + "\n";
+    }
+    header("call_center_shed_calls_total", "counter",
+           "Calls rejected by load shedding");
+    metric("call_center_shed_calls_total", snapshot.shed);
+    header("call_center_dispatcher_iterations_total", "counter",
+           "Dispatcher loop iterations");
+    metric("call_center_dispatcher_iterations_total",
+           snapshot.dispatcherIterations);
+    header("call_center_call_queue_size", "gauge", "Calls waiting in queue");
+    metric("call_center_call_queue_size", snapshot.callQueueSize);
+    header("call_center_free_operators", "gauge", "Operators without calls");
+    metric("call_center_free_operators", snapshot.freeOperators);
+    header("call_center_serviced_calls", "gauge",
+           "Calls being served by operators");
+    metric("call_center_serviced_calls", snapshot.servicedCalls);
+    header("call_center_event_log_records_total", "counter",
+           "Call events written to event log");
+    metric("call_center_event_log_records_total", snapshot.eventLogWritten);
+    header("call_center_event_log_lost_total", "counter",
+           "Call events missed by event log writer");
+    metric("call_center_event_log_lost_total", snapshot.eventLogLost);
+    return out;
+}
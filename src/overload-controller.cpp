@@ -0,0 +1,73 @@
+#include <math.h>
+
+#include <algorithm>
+
+#include "overload-controller.h"
+
+using namespace cdr;
+
+OverloadController::OverloadController() :
+    nShed{0},
+    enabled{true}
+{}
+
+bool OverloadController::shed(const size_t nCalls, const size_t queueSize,
+                              const size_t maxQueueSize, uint32_t & retryAfter,
+                              const Seconds now){
+    if (!enabled || queueSize < maxQueueSize)
+        return false;
+    nShed.fetch_add(nCalls, std::memory_order_relaxed);
+
+    const auto drainRate = getDrainRate(now);
+    if (drainRate <= 0){
+        retryAfter = maxRetryAfter;
+        return true;
+    }
+    // Time to free a place for the caller, stretched by arrivals
+    // competing for freed places faster than they are freed
+    const double excess = queueSize - maxQueueSize + 1.0;
+    const double pressure = std::max(1.0, getArrivalRate(now) / drainRate);
+    const double wait = ceil(excess / drainRate * pressure);
+    retryAfter = static_cast<uint32_t>(
+        std::clamp(wait, 1.0, static_cast<double>(maxRetryAfter)));
+    return true;
+}
+
+OverloadController::Snapshot OverloadController::get(const Seconds now) const{
+    return {enabled, nShed.load(std::memory_order_relaxed),
+            getArrivalRate(now), getDrainRate(now)};
+}
+
+void OverloadController::Rate::add(const uint64_t n, const Seconds now){
+    const uint32_t slot = now + 1;
+    auto & bucket = buckets[now % nBuckets];
+    auto bucketSlot = bucket.slot.load(std::memory_order_acquire);
+    while (bucketSlot != slot){
+        if (bucketSlot != resetting && bucketSlot < slot &&
+            bucket.slot.compare_exchange_weak(bucketSlot, resetting,
+                                              std::memory_order_acquire)){
+            bucket.count.store(0, std::memory_order_relaxed);
+            bucket.slot.store(slot, std::memory_order_release);
+            break;
+        }
+        // Bucket is reset by other thread or holds newer second
+        if (bucketSlot > slot && bucketSlot != resetting)
+            return;
+        bucketSlot = bucket.slot.load(std::memory_order_acquire);
+    }
+    bucket.count.fetch_add(n, std::memory_order_relaxed);
+}
+
+// Average over complete seconds of the window (fewer after start)
+double OverloadController::Rate::get(const Seconds now) const{
+    const size_t window = std::min<size_t>(rateWindow, now);
+    if (window == 0)
+        return 0;
+    uint64_t sum = 0;
+    for (size_t second = now - window; second < now; ++second){
+        auto & bucket = buckets[second % nBuckets];
+        if (bucket.slot.load(std::memory_order_acquire) == second + 1)
+            sum += bucket.count.load(std::memory_order_relaxed);
+    }
+    return static_cast<double>(sum) / window;
+}
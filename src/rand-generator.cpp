@@ -0,0 +1,186 @@
+#include <string.h>
+
+#include <atomic>
+#include <random>
+#include <algorithm>
+
+#include "rand-generator.h"
+
+using namespace rndgen;
+
+// Streams of a thread: scalar generator and batch lanes
+constexpr size_t streamsPerThread = 1 + Xoshiro256x4::lanes;
+// Samples mapped at once by batch functions
+constexpr size_t chunkSize = 64;
+
+static uint64_t randomSeed(){
+    std::random_device rd;
+    return (static_cast<uint64_t>(rd()) << 32) | rd();
+}
+
+static std::atomic<uint64_t> currentSeed{randomSeed()};
+// Threads reseed when it changes
+static std::atomic<uint64_t> seedGeneration{1};
+// Threads seeded since the last setSeed()
+static std::atomic<uint64_t> nSeededThreads{0};
+
+Xoshiro256::Xoshiro256(const uint64_t seed){
+    uint64_t x = seed;
+    for (auto & word : s){
+        x += 0x9E3779B97F4A7C15ull;
+        uint64_t z = x;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        word = z ^ (z >> 31);
+    }
+}
+
+Xoshiro256::Xoshiro256(const std::array<uint64_t, 4> & state) :
+    s{state}
+{}
+
+void Xoshiro256::jump(){
+    static constexpr uint64_t jumpPolynomial[] = {
+        0x180ec6d33cfd0abaull, 0xd5a61266f0c9392cull,
+        0xa9582618e03fc9aaull, 0x39abdc4529b1661cull};
+    std::array<uint64_t, 4> jumped{};
+    for (auto word : jumpPolynomial)
+        for (int bit = 0; bit < 64; ++bit){
+            if (word & (1ull << bit))
+                for (size_t i = 0; i < jumped.size(); ++i)
+                    jumped[i] ^= s[i];
+            (*this)();
+        }
+    s = jumped;
+}
+
+Xoshiro256x4::Xoshiro256x4(Xoshiro256 first) :
+    nBuffered{0}
+{
+    for (size_t lane = 0; lane < lanes; ++lane){
+        const auto & state = first.getState();
+        for (size_t word = 0; word < 4; ++word)
+            s[word][lane] = state[word];
+        first.jump();
+    }
+}
+
+void Xoshiro256x4::step(uint64_t * out){
+    for (size_t i = 0; i < lanes; ++i){
+        const uint64_t x = s[1][i] * 5;
+        out[i] = ((x << 7) | (x >> 57)) * 9;
+    }
+    for (size_t i = 0; i < lanes; ++i){
+        const uint64_t t = s[1][i] << 17;
+        s[2][i] ^= s[0][i];
+        s[3][i] ^= s[1][i];
+        s[1][i] ^= s[2][i];
+        s[0][i] ^= s[3][i];
+        s[2][i] ^= t;
+        s[3][i] = (s[3][i] << 45) | (s[3][i] >> 19);
+    }
+}
+
+void Xoshiro256x4::fill(uint64_t * out, size_t n){
+    const size_t fromBuffer = std::min(n, nBuffered);
+    memcpy(out, buffered + lanes - nBuffered, fromBuffer * sizeof(uint64_t));
+    nBuffered -= fromBuffer;
+    out += fromBuffer;
+    n -= fromBuffer;
+    for (; n >= lanes; n -= lanes, out += lanes)
+        step(out);
+    if (n > 0){
+        step(buffered);
+        memcpy(out, buffered, n * sizeof(uint64_t));
+        nBuffered = lanes - n;
+    }
+}
+
+namespace{
+
+struct Local{
+    uint64_t generation = 0;
+    Xoshiro256 scalar;
+    Xoshiro256x4 batch;
+};
+
+Local & local(){
+    thread_local Local local;
+    const auto generation = seedGeneration.load(std::memory_order_acquire);
+    if (local.generation != generation){
+        Xoshiro256 first(currentSeed.load(std::memory_order_relaxed));
+        const auto thread = nSeededThreads.fetch_add(1);
+        for (size_t i = 0; i < thread * streamsPerThread; ++i)
+            first.jump();
+        local.scalar = first;
+        first.jump();
+        local.batch = Xoshiro256x4(first);
+        local.generation = generation;
+    }
+    return local;
+}
+
+};
+
+void rndgen::setSeed(const uint64_t seed){
+    currentSeed = seed != 0 ? seed : randomSeed();
+    nSeededThreads = 0;
+    seedGeneration.fetch_add(1, std::memory_order_release);
+}
+
+uint64_t rndgen::getSeed(){
+    return currentSeed;
+}
+
+uint64_t rndgen::next(){
+    return local().scalar();
+}
+
+uint64_t rndgen::uniform(const uint64_t min, const uint64_t max){
+    const uint64_t range = max - min + 1;
+    auto & gen = local().scalar;
+    // Full range
+    if (range == 0)
+        return gen();
+    // Lemire: multiply-shift with rejection of the biased low part
+    unsigned __int128 m = static_cast<unsigned __int128>(gen()) * range;
+    if (static_cast<uint64_t>(m) < range){
+        const uint64_t threshold = -range % range;
+        while (static_cast<uint64_t>(m) < threshold)
+            m = static_cast<unsigned __int128>(gen()) * range;
+    }
+    return min + static_cast<uint64_t>(m >> 64);
+}
+
+double rndgen::uniform01(){
+    return (next() >> 11) * 0x1.0p-53;
+}
+
+void rndgen::fill(uint64_t * out, const size_t n){
+    local().batch.fill(out, n);
+}
+
+void rndgen::fillUniform(const uint32_t min, const uint32_t max,
+                         uint32_t * out, const size_t n){
+    const uint64_t range = static_cast<uint64_t>(max) - min + 1;
+    auto & batch = local().batch;
+    uint64_t raw[chunkSize];
+    for (size_t done = 0; done < n; done += chunkSize){
+        const size_t count = std::min(chunkSize, n - done);
+        batch.fill(raw, count);
+        for (size_t i = 0; i < count; ++i)
+            out[done + i] = min + static_cast<uint32_t>(
+                ((raw[i] >> 32) * range) >> 32);
+    }
+}
+
+void rndgen::fillUniform01(double * out, const size_t n){
+    auto & batch = local().batch;
+    uint64_t raw[chunkSize];
+    for (size_t done = 0; done < n; done += chunkSize){
+        const size_t count = std::min(chunkSize, n - done);
+        batch.fill(raw, count);
+        for (size_t i = 0; i < count; ++i)
+            out[done + i] = (raw[i] >> 11) * 0x1.0p-53;
+    }
+}
@@ -0,0 +1,43 @@
+#include "request-arena.h"
+
+RequestArena::RequestArena() :
+    heap(std::pmr::new_delete_resource()),
+    monotonic(buffer.data(), buffer.size(), &heap),
+    arena(&monotonic),
+    lastStats{}
+{}
+
+RequestArena & RequestArena::local(){
+    thread_local RequestArena arena;
+    return arena;
+}
+
+void RequestArena::reset(){
+    lastStats = getStats();
+    // Next allocations start from the beginning of buffer
+    monotonic.release();
+    arena.allocations = arena.bytes = 0;
+    heap.allocations = heap.bytes = 0;
+}
+
+RequestArena::Counter::Counter(std::pmr::memory_resource * upstream) :
+    allocations{0},
+    bytes{0},
+    upstream{upstream}
+{}
+
+void * RequestArena::Counter::do_allocate(size_t bytes, size_t alignment){
+    ++allocations;
+    this->bytes += bytes;
+    return upstream->allocate(bytes, alignment);
+}
+
+void RequestArena::Counter::do_deallocate(void * p, size_t bytes,
+                                          size_t alignment){
+    upstream->deallocate(p, bytes, alignment);
+}
+
+bool RequestArena::Counter::do_is_equal(
+    const std::pmr::memory_resource & other) const noexcept{
+    return this == &other;
+}
@@ -0,0 +1,84 @@
+#include <time.h>
+#include <stdio.h>
+
+#include <algorithm>
+
+#include "schedule.h"
+
+bool Schedule::Window::contains(const uint32_t secondOfDay) const{
+    if (begin < end)
+        return begin <= secondOfDay && secondOfDay < end;
+    // Crosses midnight
+    return secondOfDay >= begin || secondOfDay < end;
+}
+
+bool Schedule::Window::operator==(const Window & other) const{
+    return begin == other.begin && end == other.end &&
+        nOperators == other.nOperators &&
+        maxCallQueueSize == other.maxCallQueueSize &&
+        minResponseTime == other.minResponseTime &&
+        maxResponseTime == other.maxResponseTime;
+}
+
+bool Schedule::add(const Window & window){
+    if (window.begin >= secondsPerDay || window.end >= secondsPerDay ||
+        window.begin == window.end)
+        return false;
+    windows.push_back(window);
+    return true;
+}
+
+size_t Schedule::find(const uint32_t secondOfDay) const{
+    for (size_t i = 0; i < windows.size(); ++i)
+        if (windows[i].contains(secondOfDay))
+            return i;
+    return noWindow;
+}
+
+uint32_t Schedule::secondsToBoundary(const uint32_t secondOfDay) const{
+    // Boundary at secondOfDay itself is the one of the next day
+    auto until = [secondOfDay](const uint32_t boundary){
+        return boundary > secondOfDay ? boundary - secondOfDay :
+                                        boundary + secondsPerDay - secondOfDay;
+    };
+    uint32_t seconds = secondsPerDay;
+    for (auto & w : windows)
+        seconds = std::min({seconds, until(w.begin), until(w.end)});
+    return seconds;
+}
+
+bool Schedule::parseTime(const std::string & s, uint32_t & secondOfDay){
+    unsigned hours, minutes, seconds = 0;
+    int length = 0;
+    const bool parsed =
+        sscanf(s.c_str(), "%2u:%2u%n", &hours, &minutes, &length) == 2 &&
+        (static_cast<size_t>(length) == s.size() ||
+         sscanf(s.c_str(), "%2u:%2u:%2u%n",
+                &hours, &minutes, &seconds, &length) == 3);
+    if (!parsed || static_cast<size_t>(length) != s.size() ||
+        hours > 23 || minutes > 59 || seconds > 59)
+        return false;
+    secondOfDay = (hours * 60 + minutes) * 60 + seconds;
+    return true;
+}
+
+std::string Schedule::formatTime(const uint32_t secondOfDay){
+    char s[9];
+    // Narrowed to time of day, so the fields fit 2 digits
+    const unsigned hours = secondOfDay / 3600 % 24;
+    const unsigned minutes = secondOfDay / 60 % 60;
+    const unsigned seconds = secondOfDay % 60;
+    if (seconds)
+        snprintf(s, sizeof(s), "%02u:%02u:%02u", hours, minutes, seconds);
+    else
+        snprintf(s, sizeof(s), "%02u:%02u", hours, minutes);
+    return s;
+}
+
+uint32_t Schedule::secondOfDay(const int64_t unixTime){
+    const time_t t = unixTime;
+    tm local;
+    localtime_r(&t, &local);
+    return (local.tm_hour * 60 + local.tm_min) * 60 +
+        std::min(local.tm_sec, 59);
+}
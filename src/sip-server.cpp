@@ -0,0 +1,232 @@
+#include <netdb.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#include <array>
+#include <utility>
+#include <algorithm>
+#include <cerrno>
+#include <thread>
+#include <vector>
+
+#include "easylogging++.h"
+
+#include "call-center.h"
+#include "sip-parser.h"
+#include "sip-server.h"
+#include "sip-transactions.h"
+
+namespace{
+
+constexpr size_t batchSize = 64;
+// SIP over UDP messages should fit into path MTU
+constexpr size_t maxDatagramSize = 4096;
+constexpr size_t maxResponseSize = maxDatagramSize + sip::maxResponseOverhead;
+// Capped by net.core.rmem_max
+constexpr int receiveBufferSize = 4 << 20;
+// Answered INVITEs remembered by every thread
+constexpr size_t maxTransactions = 1 << 18;
+
+// "host:port"
+int openSocket(const std::string & address){
+    auto colon = address.rfind(':');
+    if (colon == std::string::npos)
+        return -1;
+    auto host = address.substr(0, colon);
+    auto port = address.substr(colon + 1);
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_flags = AI_PASSIVE;
+    addrinfo * addrs;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &addrs) != 0)
+        return -1;
+    int fd = -1;
+    for (auto addr = addrs; addr; addr = addr->ai_next){
+        fd = socket(addr->ai_family, addr->ai_socktype | SOCK_CLOEXEC,
+                    addr->ai_protocol);
+        if (fd < 0)
+            continue;
+        int yes = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &yes, sizeof(yes));
+        // Absorbs bursts while the thread pushes a batch
+        int bufferSize = receiveBufferSize;
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+        if (bind(fd, addr->ai_addr, addr->ai_addrlen) == 0)
+            break;
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(addrs);
+    return fd;
+}
+
+// Buffers of one recvmmsg/sendmmsg batch
+struct Batch{
+    std::vector<char> in = std::vector<char>(batchSize * maxDatagramSize);
+    std::vector<char> out = std::vector<char>(batchSize * maxResponseSize);
+    std::array<sockaddr_storage, batchSize> addrs;
+    std::array<iovec, batchSize> inIov;
+    std::array<iovec, batchSize> outIov;
+    std::array<mmsghdr, batchSize> inMsgs;
+    std::array<mmsghdr, batchSize> outMsgs;
+
+    Batch(){
+        for (size_t i = 0; i < batchSize; ++i){
+            inIov[i] = {in.data() + i * maxDatagramSize, maxDatagramSize};
+            inMsgs[i] = {};
+            inMsgs[i].msg_hdr.msg_iov = &inIov[i];
+            inMsgs[i].msg_hdr.msg_iovlen = 1;
+            inMsgs[i].msg_hdr.msg_name = &addrs[i];
+        }
+    }
+};
+
+};
+
+bool SipServer::listen(const std::string & address, size_t nThreads,
+                       std::shared_ptr<CallCenter> callCenter){
+    this->callCenter = callCenter;
+    if (nThreads == 0)
+        nThreads = 1;
+    std::vector<int> fds;
+    for (size_t i = 0; i < nThreads; ++i){
+        auto fd = openSocket(address);
+        if (fd < 0){
+            for (auto openFd : fds)
+                close(openFd);
+            return false;
+        }
+        fds.push_back(fd);
+    }
+    LOG(INFO) << "SIP ingress listening on " << address <<
+        ". Threads: " << nThreads;
+
+    std::vector<std::thread> loops;
+    for (auto fd : fds)
+        loops.emplace_back(&SipServer::loop, this, fd);
+    for (auto & loop : loops)
+        loop.join();
+    return true;
+}
+
+void SipServer::loop(const int fd) const{
+    Batch batch;
+    std::vector<sip::Request> requests(batchSize);
+    // Index of received datagram of every new INVITE
+    std::vector<size_t> invites;
+    std::vector<uint64_t> keys;
+    std::vector<Cdr> cdrs;
+    // Received datagram and its answer
+    std::vector<std::pair<size_t, sip::Answer>> replies;
+    // Received datagram and index of the INVITE of the same batch
+    // it retransmits
+    std::vector<std::pair<size_t, size_t>> retransmits;
+    sip::Transactions transactions(maxTransactions);
+
+    while (true){
+        for (auto & msg : batch.inMsgs)
+            msg.msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+        // Waits for one datagram, then takes all already received
+        int n = recvmmsg(fd, batch.inMsgs.data(), batchSize,
+                         MSG_WAITFORONE, nullptr);
+        if (n < 0){
+            if (errno == EINTR)
+                continue;
+            LOG(ERROR) << "recvmmsg failed, errno: " << errno;
+            break;
+        }
+
+        invites.clear();
+        keys.clear();
+        cdrs.clear();
+        replies.clear();
+        retransmits.clear();
+        const auto now = cdr::now();
+        for (int i = 0; i < n; ++i){
+            auto & request = requests[i];
+            std::string_view data(batch.in.data() + i * maxDatagramSize,
+                                  batch.inMsgs[i].msg_len);
+            if (!sip::parseRequest(data, request) ||
+                request.method != "INVITE")
+                continue;
+            Cdr cdr;
+            // Too long or missing number is rejected as invalid call
+            if (request.fromUser.empty() ||
+                !cdr.phoneNumber.assign(request.fromUser))
+                continue;
+            // Retransmission is answered the same way, not pushed
+            const auto key = sip::Transactions::key(request);
+            if (auto answer = transactions.find(key, now)){
+                replies.emplace_back(i, *answer);
+                continue;
+            }
+            auto same = std::find(keys.begin(), keys.end(), key);
+            if (same != keys.end()){
+                retransmits.emplace_back(i, same - keys.begin());
+                continue;
+            }
+            cdr.receiveDT = now;
+            cdrs.push_back(cdr);
+            invites.push_back(i);
+            keys.push_back(key);
+        }
+
+        if (!cdrs.empty()){
+            uint32_t retryAfter = 0;
+            const bool shed = callCenter->shedCalls(cdrs.size(), retryAfter);
+            if (!shed)
+                callCenter->pushCalls(cdrs);
+            // Answers of new INVITEs follow answers of earlier ones
+            const auto first = replies.size();
+            for (size_t i = 0; i < invites.size(); ++i){
+                sip::Answer answer{503, 0, retryAfter};
+                if (!shed){
+                    answer = {503, cdrs[i].callId, 0};
+                    if (cdrs[i].callStatus == CallStatus::ok)
+                        answer.code = 180;
+                    else if (cdrs[i].callStatus == CallStatus::alreadyInQueue)
+                        answer.code = 486;
+                }
+                transactions.add(keys[i], answer, now);
+                replies.emplace_back(invites[i], answer);
+            }
+            for (auto & [datagram, invite] : retransmits){
+                const auto answer = replies[first + invite].second;
+                replies.emplace_back(datagram, answer);
+            }
+        }
+        if (replies.empty())
+            continue;
+
+        for (size_t i = 0; i < replies.size(); ++i){
+            auto & [datagram, answer] = replies[i];
+            auto begin = batch.out.data() + i * maxResponseSize;
+            auto end = sip::writeResponse(begin, requests[datagram],
+                                          answer.code,
+                                          sip::reason(answer.code),
+                                          answer.tag, answer.retryAfter);
+            auto & in = batch.inMsgs[datagram].msg_hdr;
+            batch.outIov[i] = {begin, static_cast<size_t>(end - begin)};
+            batch.outMsgs[i] = {};
+            batch.outMsgs[i].msg_hdr.msg_iov = &batch.outIov[i];
+            batch.outMsgs[i].msg_hdr.msg_iovlen = 1;
+            batch.outMsgs[i].msg_hdr.msg_name = in.msg_name;
+            batch.outMsgs[i].msg_hdr.msg_namelen = in.msg_namelen;
+        }
+        size_t sent = 0;
+        while (sent < replies.size()){
+            int m = sendmmsg(fd, batch.outMsgs.data() + sent,
+                             replies.size() - sent, 0);
+            if (m < 0){
+                if (errno == EINTR)
+                    continue;
+                LOG(ERROR) << "sendmmsg failed, errno: " << errno;
+                break;
+            }
+            sent += m;
+        }
+    }
+    close(fd);
+}
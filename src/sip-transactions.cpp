@@ -0,0 +1,54 @@
+#include "fnv-hash.h"
+#include "sip-transactions.h"
+
+namespace sip{
+
+std::string_view reason(const int code){
+    switch (code){
+        case 180:
+            return "Ringing";
+        case 486:
+            return "Busy Here";
+        default:
+            return "Service Unavailable";
+    }
+}
+
+Transactions::Transactions(const size_t maxSize) :
+    maxSize{maxSize}
+{}
+
+uint64_t Transactions::key(const Request & request){
+    // Separator keeps "a" + "bc" and "ab" + "c" apart
+    auto hash = fnv::hash(fnv::offset, request.callId);
+    hash = fnv::hash(hash, std::string_view("\0", 1));
+    return fnv::hash(hash, request.cseq);
+}
+
+const Answer * Transactions::find(const uint64_t key,
+                                  const cdr::Seconds now){
+    expire(now);
+    auto answer = answers.find(key);
+    return answer == answers.end() ? nullptr : &answer->second;
+}
+
+void Transactions::add(const uint64_t key, const Answer & answer,
+                       const cdr::Seconds now){
+    expire(now);
+    if (!answers.emplace(key, answer).second)
+        return;
+    added.emplace_back(now, key);
+    if (answers.size() > maxSize){
+        answers.erase(added.front().second);
+        added.pop_front();
+    }
+}
+
+void Transactions::expire(const cdr::Seconds now){
+    while (!added.empty() && now - added.front().first >= lifetime){
+        answers.erase(added.front().second);
+        added.pop_front();
+    }
+}
+
+};
@@ -0,0 +1,52 @@
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#include "wakeup.h"
+
+Wakeup::~Wakeup(){
+    for (auto fd : fds)
+        close(fd);
+}
+
+bool Wakeup::wait(const uint64_t ticket,
+                  const std::chrono::milliseconds timeout){
+    std::unique_lock<std::mutex> lck(mtx);
+    return cv.wait_for(lck, timeout, [this, ticket]{
+        return generation.load(std::memory_order_relaxed) != ticket;
+    });
+}
+
+int Wakeup::openFd(){
+    const int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd < 0)
+        return -1;
+    std::lock_guard<std::mutex> lck(mtx);
+    fds.push_back(fd);
+    return fd;
+}
+
+void Wakeup::closeFd(const int fd){
+    std::lock_guard<std::mutex> lck(mtx);
+    for (auto it = fds.begin(); it != fds.end(); ++it)
+        if (*it == fd){
+            fds.erase(it);
+            close(fd);
+            return;
+        }
+}
+
+void Wakeup::consume(const int fd){
+    uint64_t value;
+    [[maybe_unused]] auto n = read(fd, &value, sizeof(value));
+}
+
+void Wakeup::wakeAll(){
+    {
+        std::lock_guard<std::mutex> lck(mtx);
+        generation.fetch_add(1, std::memory_order_release);
+        const uint64_t one = 1;
+        for (auto fd : fds)
+            [[maybe_unused]] auto n = write(fd, &one, sizeof(one));
+    }
+    cv.notify_all();
+}
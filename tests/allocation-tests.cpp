@@ -0,0 +1,41 @@
+#include <gtest/gtest.h>
+
+#include <new>
+#include <cstdlib>
+#include <string>
+
+#include "../include/response-writer.h"
+#include "../include/cdr.h"
+
+using namespace cdr;
+
+// Global heap allocations of the calling thread. Replacing operator new
+// affects the whole binary, so these tests have an executable of their own
+static thread_local size_t nHeapAllocations = 0;
+
+void * operator new(size_t size){
+    ++nHeapAllocations;
+    if (auto p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void * p) noexcept{
+    std::free(p);
+}
+
+void operator delete(void * p, size_t) noexcept{
+    std::free(p);
+}
+
+TEST(allocations, phoneNumberAndAnswerDontAllocate){
+    const std::string phoneNumber = "79990000000";
+    const auto before = nHeapAllocations;
+    Cdr cdr;
+    ASSERT_TRUE(cdr.phoneNumber.assign(phoneNumber));
+    auto answer = response::writeCallAnswer(UINT64_MAX, CallStatus::ok, 1, 2);
+    auto position = response::writePositionAnswer(UINT64_MAX, 1, 2);
+    ASSERT_EQ(nHeapAllocations, before);
+    EXPECT_FALSE(answer.empty());
+    ASSERT_FALSE(position.empty());
+}
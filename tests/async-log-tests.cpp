@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+
+#include <time.h>
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../include/async-log.h"
+
+using Level = AsyncLog::Level;
+using Message = AsyncLog::Message;
+
+namespace{
+
+struct Captured{
+    std::mutex mtx;
+    std::vector<std::pair<Level, std::string>> lines;
+    std::vector<std::string> funcs;
+    std::vector<uint64_t> times;
+
+    AsyncLog::Sink sink(){
+        return [this](const AsyncLog::Record & record,
+                      const std::string & line){
+            std::lock_guard<std::mutex> lck(mtx);
+            lines.emplace_back(record.level, line);
+            funcs.push_back(record.func);
+            times.push_back(record.time);
+        };
+    }
+};
+
+constexpr uint32_t allLevels = AsyncLog::levelBit(Level::debug) |
+    AsyncLog::levelBit(Level::info) | AsyncLog::levelBit(Level::warning) |
+    AsyncLog::levelBit(Level::error);
+
+}
+
+TEST(asyncLog, formatArguments){
+    AsyncLog::Record record{Message::servingStarted, Level::info, {42, 7},
+                            0, ""};
+    EXPECT_EQ(AsyncLog::format(record),
+              "Call serving started. CallId: 42, operatorId: 7");
+
+    record = {Message::endedByTimeout, Level::info, {1, 2, 3, 4}, 0, ""};
+    ASSERT_EQ(AsyncLog::format(record),
+              "Call with callId: 1 ending by timeout. Elapsed time: 2, "
+              "maxResponseTime: 3, receiveTime: 4");
+}
+
+TEST(asyncLog, formatTime){
+    // Local time zone
+    const time_t t = 1700000000;
+    tm local;
+    localtime_r(&t, &local);
+    char expected[32];
+    strftime(expected, sizeof(expected), "%Y-%m-%d %H:%M:%S", &local);
+    ASSERT_EQ(AsyncLog::formatTime(1700000000123456789ull),
+              std::string(expected) + ".123");
+}
+
+TEST(asyncLog, callSiteAndTimeKept){
+    Captured captured;
+    const auto begin = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    {
+        AsyncLog log;
+        log.start(captured.sink(), allLevels);
+        log.log(Level::info, "caller", Message::callEnded, 5);
+        log.flush();
+    }
+    ASSERT_EQ(captured.funcs.size(), 1);
+    EXPECT_EQ(captured.funcs[0], "caller");
+    // Coarse clock lags by its resolution
+    ASSERT_NEAR(static_cast<double>(captured.times[0]),
+                static_cast<double>(begin), 50e6);
+}
+
+TEST(asyncLog, notStartedWritesNothing){
+    AsyncLog log;
+    log.log(Level::info, __func__, Message::pushed, 1);
+    log.flush();
+    ASSERT_EQ(log.getDropped(), 0);
+}
+
+TEST(asyncLog, threadOrderKept){
+    Captured captured;
+    {
+        AsyncLog log;
+        log.start(captured.sink(), allLevels);
+        for (uint64_t i = 0; i < 100; ++i)
+            log.log(Level::info, __func__, Message::pushed, i);
+        log.flush();
+    }
+    ASSERT_EQ(captured.lines.size(), 100);
+    for (uint64_t i = 0; i < 100; ++i)
+        EXPECT_EQ(captured.lines[i].second,
+                  "Pushed call with call id: " + std::to_string(i));
+}
+
+TEST(asyncLog, disabledLevelNotWritten){
+    Captured captured;
+    {
+        AsyncLog log;
+        log.start(captured.sink(), AsyncLog::levelBit(Level::info));
+        log.log(Level::debug, __func__, Message::operatorAssigned);
+        log.log(Level::info, __func__, Message::callEnded, 5);
+        log.flush();
+    }
+    ASSERT_EQ(captured.lines.size(), 1);
+    EXPECT_EQ(captured.lines[0].first, Level::info);
+    ASSERT_EQ(captured.lines[0].second, "Call with callId: 5 ended");
+}
+
+TEST(asyncLog, exitedThreadsDrained){
+    Captured captured;
+    AsyncLog log;
+    log.start(captured.sink(), allLevels);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+        threads.emplace_back([&log]{
+            for (uint64_t i = 0; i < 1000; ++i)
+                log.log(Level::info, __func__, Message::pushed, i);
+        });
+    for (auto & t : threads)
+        t.join();
+    log.flush();
+    std::lock_guard<std::mutex> lck(captured.mtx);
+    ASSERT_EQ(captured.lines.size() + log.getDropped(), 4000);
+}
@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "../include/binary-protocol.h"
+
+using namespace binproto;
+
+TEST(binaryProtocol, callRoundTrip){
+    char buffer[maxCallSize];
+    Call call;
+    call.requestId = 0x0102030405060708;
+    call.receiveTime = 1700000000;
+    call.priority = 3;
+    call.phoneNumber = "79990000001";
+    auto end = writeCall(buffer, call);
+    ASSERT_EQ(end - buffer, callHeaderSize + 11);
+
+    Call parsed;
+    size_t consumed = 0;
+    ASSERT_EQ(parseCall(buffer, end - buffer, parsed, consumed),
+              ParseResult::ok);
+    EXPECT_EQ(consumed, callHeaderSize + 11);
+    EXPECT_EQ(parsed.requestId, call.requestId);
+    EXPECT_EQ(parsed.receiveTime, call.receiveTime);
+    EXPECT_EQ(parsed.priority, 3);
+    ASSERT_EQ(parsed.phoneNumber, "79990000001");
+}
+
+TEST(binaryProtocol, littleEndianLength){
+    char buffer[maxCallSize];
+    Call call;
+    call.phoneNumber = "1";
+    writeCall(buffer, call);
+    EXPECT_EQ(buffer[0], callHeaderSize - 2 + 1);
+    ASSERT_EQ(buffer[1], 0);
+}
+
+TEST(binaryProtocol, severalFramesInOneBuffer){
+    std::string data(2 * maxCallSize, '\0');
+    Call call;
+    call.requestId = 1;
+    call.phoneNumber = "111";
+    auto end = writeCall(data.data(), call);
+    call.requestId = 2;
+    call.phoneNumber = "2222";
+    end = writeCall(end, call);
+    const size_t size = end - data.data();
+
+    Call parsed;
+    size_t consumed = 0;
+    ASSERT_EQ(parseCall(data.data(), size, parsed, consumed), ParseResult::ok);
+    ASSERT_EQ(parseCall(data.data() + consumed, size - consumed, parsed,
+                        consumed), ParseResult::ok);
+    EXPECT_EQ(parsed.requestId, 2);
+    ASSERT_EQ(parsed.phoneNumber, "2222");
+}
+
+TEST(binaryProtocol, incompleteCall){
+    char buffer[maxCallSize];
+    Call call;
+    call.phoneNumber = "79990000001";
+    auto end = writeCall(buffer, call);
+
+    Call parsed;
+    size_t consumed = 0;
+    EXPECT_EQ(parseCall(buffer, 1, parsed, consumed),
+              ParseResult::incomplete);
+    ASSERT_EQ(parseCall(buffer, end - buffer - 1, parsed, consumed),
+              ParseResult::incomplete);
+}
+
+TEST(binaryProtocol, invalidCall){
+    char buffer[maxCallSize];
+    Call call;
+    call.phoneNumber = "79990000001";
+    writeCall(buffer, call);
+    // Phone number length doesn't match frame length
+    buffer[callHeaderSize - 1] = 5;
+
+    Call parsed;
+    size_t consumed = 0;
+    EXPECT_EQ(parseCall(buffer, sizeof(buffer), parsed, consumed),
+              ParseResult::invalid);
+    // Frame longer than the longest call frame
+    buffer[0] = static_cast<char>(maxCallSize);
+    ASSERT_EQ(parseCall(buffer, sizeof(buffer), parsed, consumed),
+              ParseResult::invalid);
+}
+
+TEST(binaryProtocol, replyRoundTrip){
+    char buffer[replySize];
+    Reply reply;
+    reply.requestId = 7;
+    reply.callId = 370405383979663360;
+    reply.callStatus = cdr::CallStatus::alreadyInQueue;
+    ASSERT_EQ(writeReply(buffer, reply) - buffer, replySize);
+
+    Reply parsed;
+    ASSERT_EQ(parseReply(buffer, replySize, parsed), ParseResult::ok);
+    EXPECT_EQ(parsed.requestId, 7);
+    EXPECT_EQ(parsed.callId, reply.callId);
+    ASSERT_EQ(parsed.callStatus, cdr::CallStatus::alreadyInQueue);
+}
@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/un.h>
+#include <sys/socket.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <filesystem>
+
+#include "../include/call-center.h"
+#include "../include/binary-server.h"
+#include "../include/binary-protocol.h"
+
+namespace{
+
+int connectUnix(const std::string & path){
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    path.copy(addr.sun_path, path.size());
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    for (int i = 0; i < 100; ++i){
+        if (connect(fd, reinterpret_cast<sockaddr *>(&addr),
+                    sizeof(addr)) == 0)
+            return fd;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    close(fd);
+    return -1;
+}
+
+std::string callFrame(const uint64_t requestId){
+    char buffer[binproto::maxCallSize];
+    binproto::Call call;
+    call.requestId = requestId;
+    call.phoneNumber = "7999" + std::to_string(requestId);
+    return std::string(buffer, binproto::writeCall(buffer, call));
+}
+
+}
+
+// SIGPIPE would kill the test process
+TEST(binaryServer, clientClosingWithRepliesPending){
+    const auto path = testing::TempDir() + "binary-server-" +
+        std::to_string(getpid()) + ".sock";
+    auto callCenter = std::make_shared<CallCenter>();
+    CallCenter::Config config;
+    config.minCallDuration = config.maxCallDuration = 60;
+    config.nOperators = 1;
+    config.maxCallQueueSize = 10;
+    ASSERT_TRUE(callCenter->setConfig(config));
+    // Event loops never return, the server lives until the process ends
+    std::thread([path, callCenter]{
+        BinaryServer().listen("unix:" + path, 1, callCenter);
+    }).detach();
+
+    int fd = connectUnix(path);
+    ASSERT_GE(fd, 0);
+    // Replies are not read until they fill the socket buffers and the
+    // server stops reading calls
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+    std::string frames;
+    for (uint64_t id = 1; id <= 1000; ++id)
+        frames += callFrame(id);
+    size_t nFrames = 0;
+    for (bool full = false; !full && nFrames < 1000000; nFrames += 1000){
+        for (size_t sent = 0; sent < frames.size();){
+            auto n = send(fd, frames.data() + sent, frames.size() - sent,
+                          MSG_NOSIGNAL);
+            if (n < 0){
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                n = send(fd, frames.data() + sent, frames.size() - sent,
+                         MSG_NOSIGNAL);
+                if (n < 0){
+                    full = true;
+                    break;
+                }
+            }
+            sent += n;
+        }
+    }
+    ASSERT_LT(nFrames, 1000000);
+    close(fd);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    // Server is still answering
+    fd = connectUnix(path);
+    ASSERT_GE(fd, 0);
+    const auto frame = callFrame(42);
+    ASSERT_EQ(send(fd, frame.data(), frame.size(), MSG_NOSIGNAL),
+              static_cast<ssize_t>(frame.size()));
+    char buffer[binproto::replySize];
+    size_t received = 0;
+    while (received < sizeof(buffer)){
+        auto n = recv(fd, buffer + received, sizeof(buffer) - received, 0);
+        ASSERT_GT(n, 0);
+        received += n;
+    }
+    binproto::Reply reply;
+    ASSERT_EQ(binproto::parseReply(buffer, sizeof(buffer), reply),
+              binproto::ParseResult::ok);
+    EXPECT_EQ(reply.requestId, 42);
+    close(fd);
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,272 @@
+#include <gtest/gtest.h>
+
+#include <list>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include "../include/call-center.h"
+#include "../include/id-generator.h"
+
+namespace{
+
+using Config = CallCenter::Config;
+
+Config validConfig(const size_t nOperators){
+    Config config;
+    config.minResponseTime = 0;
+    config.maxResponseTime = 180;
+    config.minCallDuration = 60;
+    config.maxCallDuration = 300;
+    config.nOperators = nOperators;
+    config.maxCallQueueSize = 100;
+    return config;
+}
+
+// Parameters of default-call-center.json read by the call center
+nlohmann::json validConf(){
+    return nlohmann::json::parse(R"({
+        "minResponseTime" : 0,
+        "maxResponseTime" : 180,
+        "minCallDuration" : 60,
+        "maxCallDuration" : 300,
+        "nOperators" : 10,
+        "rejectRepeatedCalls" : false,
+        "maxCallQueueSize" : 100,
+        "callDuration" : {"type" : "uniform"},
+        "patience" : null,
+        "schedule" : [],
+        "callIndexRetention" : 600,
+        "callIndexCapacity" : 100000,
+        "serviceLevelTime" : 20,
+        "nodeId" : 0,
+        "cdrExportDir" : "",
+        "cdrExportFormat" : "csv",
+        "eventLogFile" : "",
+        "eventLogLossless" : false,
+        "textLog" : true,
+        "traceSampleRate" : 0,
+        "randomSeed" : 0,
+        "loadShedding" : true,
+        "httpIngress" : "httplib",
+        "httpIngressThreads" : 0,
+        "binaryIngress" : "",
+        "binaryIngressThreads" : 1,
+        "sipIngress" : "",
+        "sipIngressThreads" : 1
+    })");
+}
+
+}
+
+TEST(callCenterConfig, isValid){
+    ASSERT_TRUE(validConfig(1).isValid());
+    // Not configured call center has no operators
+    ASSERT_FALSE(Config().isValid());
+    ASSERT_FALSE(validConfig(0).isValid());
+
+    auto config = validConfig(1);
+    config.minResponseTime = 200;
+    ASSERT_FALSE(config.isValid());
+    config = validConfig(1);
+    config.minCallDuration = 0;
+    ASSERT_FALSE(config.isValid());
+    config = validConfig(1);
+    config.maxCallQueueSize = 0;
+    ASSERT_FALSE(config.isValid());
+    config = validConfig(1);
+    config.callDuration = std::make_shared<const Distribution>(
+        Distribution::exponential(0));
+    ASSERT_FALSE(config.isValid());
+    config = validConfig(1);
+    config.patience = std::make_shared<const Distribution>(
+        Distribution::empirical({}, {}));
+    ASSERT_FALSE(config.isValid());
+}
+
+TEST(callCenterConfig, invalidWindowParams){
+    auto config = validConfig(1);
+    Schedule::Window window{};
+    window.begin = 9 * 3600;
+    window.end = 18 * 3600;
+    window.nOperators = 5;
+    ASSERT_TRUE(config.schedule.add(window));
+    ASSERT_TRUE(config.isValid());
+    ASSERT_EQ(config.withWindow(0).nOperators, 5);
+    ASSERT_EQ(config.withWindow(0).maxCallQueueSize, 100);
+
+    window.begin = 20 * 3600;
+    window.end = 21 * 3600;
+    // Window maxResponseTime is below the base minResponseTime
+    window.maxResponseTime = 0;
+    config.minResponseTime = 10;
+    ASSERT_TRUE(config.schedule.add(window));
+    ASSERT_FALSE(config.isValid());
+}
+
+TEST(callCenterConfig, readConfParams){
+    Config config;
+    ASSERT_TRUE(CallCenter::readConfParams(validConf(), config));
+    EXPECT_EQ(config.nOperators, 10);
+    EXPECT_FALSE(config.rejectRepeatedCalls);
+    EXPECT_EQ(config.patience, nullptr);
+
+    auto rejected = [](const char * name, const nlohmann::json & value){
+        auto conf = validConf();
+        conf[name] = value;
+        Config config;
+        return !CallCenter::readConfParams(conf, config);
+    };
+    EXPECT_TRUE(rejected("nOperators", 0));
+    EXPECT_TRUE(rejected("nOperators", -1));
+    EXPECT_TRUE(rejected("minResponseTime", 181));
+    EXPECT_TRUE(rejected("maxCallDuration", "300"));
+    EXPECT_TRUE(rejected("rejectRepeatedCalls", 1));
+    EXPECT_TRUE(rejected("callDuration", {{"type", "normal"}}));
+    EXPECT_TRUE(rejected("patience", {{"type", "exponential"}}));
+    EXPECT_TRUE(rejected("schedule", {{{"begin", "09:00"}, {"end", "18:00"},
+                                       {"operators", 5}}}));
+    EXPECT_TRUE(rejected("callIndexCapacity", CallIndex::minCapacity - 1));
+    EXPECT_TRUE(rejected("nodeId", idgen::maxNodeId + 1));
+    EXPECT_TRUE(rejected("cdrExportFormat", "xml"));
+    EXPECT_TRUE(rejected("callIndexRetention", -1));
+    EXPECT_TRUE(rejected("eventLogFile", nullptr));
+    EXPECT_TRUE(rejected("eventLogLossless", "true"));
+    EXPECT_TRUE(rejected("traceSampleRate", 1.5));
+    EXPECT_TRUE(rejected("randomSeed", 0.5));
+    EXPECT_TRUE(rejected("loadShedding", 0));
+    EXPECT_TRUE(rejected("httpIngress", 1));
+    EXPECT_TRUE(rejected("httpIngressThreads", -1));
+    EXPECT_TRUE(rejected("binaryIngress", nullptr));
+    EXPECT_TRUE(rejected("binaryIngressThreads", "2"));
+    EXPECT_TRUE(rejected("sipIngress", false));
+    EXPECT_TRUE(rejected("sipIngressThreads", -2));
+
+    auto conf = validConf();
+    conf.erase("serviceLevelTime");
+    ASSERT_FALSE(CallCenter::readConfParams(conf, config));
+}
+
+TEST(callCenterConfig, reconcileOperators){
+    const std::multimap<cdr::Seconds, Cdr> noCalls;
+    std::list<size_t> freeOperators{1, 2, 3};
+    CallCenter::reconcileOperators(freeOperators, noCalls, 3, 5);
+    freeOperators.sort();
+    ASSERT_EQ(freeOperators, (std::list<size_t>{1, 2, 3, 4, 5}));
+
+    // Operator 4 is busy: it is not free and is not added back
+    freeOperators = {1, 3, 5};
+    CallCenter::reconcileOperators(freeOperators, noCalls, 5, 3);
+    ASSERT_EQ(freeOperators, (std::list<size_t>{1, 3}));
+
+    CallCenter::reconcileOperators(freeOperators, noCalls, 3, 3);
+    ASSERT_EQ(freeOperators, (std::list<size_t>{1, 3}));
+}
+
+TEST(callCenterConfig, shrinkGrowRelease){
+    // Operators 4 and 5 are busy
+    std::multimap<cdr::Seconds, Cdr> servicedCalls;
+    for (size_t operatorId : {4, 5}){
+        Cdr cdr;
+        cdr.operatorId = operatorId;
+        servicedCalls.emplace(100, cdr);
+    }
+    std::list<size_t> freeOperators{1, 2, 3};
+    CallCenter::reconcileOperators(freeOperators, servicedCalls, 5, 3);
+    ASSERT_EQ(freeOperators, (std::list<size_t>{1, 2, 3}));
+
+    // Grown back before their calls end: only idle operator 6 is added
+    CallCenter::reconcileOperators(freeOperators, servicedCalls, 3, 6);
+    ASSERT_EQ(freeOperators, (std::list<size_t>{1, 2, 3, 6}));
+
+    // Calls end, every operator is free once
+    for (auto & call : servicedCalls)
+        freeOperators.push_back(call.second.operatorId);
+    freeOperators.sort();
+    ASSERT_EQ(freeOperators, (std::list<size_t>{1, 2, 3, 4, 5, 6}));
+}
+
+TEST(callCenterConfig, configCachedPerInstance){
+    auto a = std::make_unique<CallCenter>();
+    auto b = std::make_unique<CallCenter>();
+    ASSERT_TRUE(a->setConfig(validConfig(3)));
+    ASSERT_TRUE(b->setConfig(validConfig(5)));
+    // Both snapshots have version 1
+    ASSERT_EQ(a->getConfig().version, b->getConfig().version);
+    ASSERT_EQ(a->getConfig().nOperators, 3);
+    ASSERT_EQ(b->getConfig().nOperators, 5);
+    ASSERT_EQ(a->getConfig().nOperators, 3);
+    ASSERT_EQ(a->getActiveConfig().nOperators, 3);
+    ASSERT_EQ(b->getActiveConfig().nOperators, 5);
+
+    // Cache of another thread is refreshed on a new version
+    std::thread([&a]{ ASSERT_EQ(a->getConfig().nOperators, 3); }).join();
+    ASSERT_TRUE(a->setNOperators(4));
+    std::thread([&a]{ ASSERT_EQ(a->getConfig().nOperators, 4); }).join();
+
+    // New instance may get the address of the destroyed one and
+    // publish the same version
+    ASSERT_EQ(b->getConfig().nOperators, 5);
+    b.reset();
+    b = std::make_unique<CallCenter>();
+    ASSERT_EQ(b->getConfig().nOperators, 0);
+    ASSERT_TRUE(b->setConfig(validConfig(7)));
+    ASSERT_EQ(b->getConfig().version, 1);
+    ASSERT_EQ(b->getConfig().nOperators, 7);
+}
+
+TEST(callCenterConfig, sameParamsKeepVersion){
+    CallCenter callCenter;
+    ASSERT_TRUE(callCenter.setConfig(validConfig(3)));
+    ASSERT_EQ(callCenter.getConfig().version, 1);
+    ASSERT_TRUE(callCenter.setConfig(validConfig(3)));
+    ASSERT_EQ(callCenter.getConfig().version, 1);
+
+    std::shared_ptr<const Config> published;
+    ASSERT_EQ(callCenter.setConfig(validConfig(3), 1, &published),
+              CallCenter::ConfigResult::ok);
+    ASSERT_EQ(published->version, 1);
+    ASSERT_FALSE(callCenter.setConfig(validConfig(0)));
+    ASSERT_EQ(callCenter.setConfig(validConfig(0), 1, &published),
+              CallCenter::ConfigResult::invalid);
+    ASSERT_EQ(published->version, 1);
+    ASSERT_EQ(callCenter.getConfig().version, 1);
+}
+
+TEST(callCenterConfig, conflict){
+    CallCenter callCenter;
+    ASSERT_TRUE(callCenter.setConfig(validConfig(3)));
+    std::shared_ptr<const Config> published;
+    ASSERT_EQ(callCenter.setConfig(validConfig(4), 1, &published),
+              CallCenter::ConfigResult::ok);
+    ASSERT_EQ(published->version, 2);
+    ASSERT_EQ(published->nOperators, 4);
+
+    // Change based on version 1 doesn't overwrite version 2
+    ASSERT_EQ(callCenter.setConfig(validConfig(5), 1, &published),
+              CallCenter::ConfigResult::conflict);
+    ASSERT_EQ(published->version, 2);
+    ASSERT_EQ(published->nOperators, 4);
+    ASSERT_EQ(callCenter.getConfig().nOperators, 4);
+
+    // Published snapshot is the one of this change, not the latest
+    ASSERT_EQ(callCenter.setConfig(validConfig(5), 2, &published),
+              CallCenter::ConfigResult::ok);
+    ASSERT_TRUE(callCenter.setNOperators(6));
+    ASSERT_EQ(published->version, 3);
+    ASSERT_EQ(published->nOperators, 5);
+    ASSERT_EQ(callCenter.getConfig().version, 4);
+}
+
+TEST(callCenterConfig, waitConfigAppliedTimeout){
+    // Dispatcher isn't running
+    CallCenter callCenter;
+    ASSERT_TRUE(callCenter.setConfig(validConfig(3)));
+    const auto begin = std::chrono::steady_clock::now();
+    ASSERT_FALSE(callCenter.waitConfigApplied(
+        1, std::chrono::milliseconds(20)));
+    ASSERT_GE(std::chrono::steady_clock::now() - begin,
+              std::chrono::milliseconds(20));
+    ASSERT_TRUE(callCenter.waitConfigApplied(
+        0, std::chrono::milliseconds(0)));
+}
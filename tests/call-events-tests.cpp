@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "../include/call-events.h"
+
+using namespace cdr;
+
+namespace{
+
+Cdr makeCdr(const uint64_t callId){
+    Cdr cdr;
+    cdr.callId = callId;
+    cdr.operatorId = static_cast<uint32_t>(callId * 3);
+    cdr.phoneNumber = std::to_string(callId);
+    return cdr;
+}
+
+};
+
+TEST(callEvents, subscriberReceivesEventsInOrder){
+    CallEvents events;
+    CallEvents::Subscriber subscriber(events);
+    events.publish(CallEvents::Type::queued, makeCdr(1));
+    events.publish(CallEvents::Type::answered, makeCdr(1));
+
+    CallEvents::Event event;
+    ASSERT_EQ(subscriber.next(event), CallEvents::Result::ok);
+    EXPECT_EQ(event.type, CallEvents::Type::queued);
+    ASSERT_EQ(subscriber.next(event), CallEvents::Result::ok);
+    EXPECT_EQ(event.type, CallEvents::Type::answered);
+    EXPECT_EQ(event.cdr.callId, 1);
+    EXPECT_EQ(event.cdr.phoneNumber.view(), "1");
+    ASSERT_EQ(subscriber.next(event), CallEvents::Result::empty);
+}
+
+TEST(callEvents, subscriberSkipsEarlierEvents){
+    CallEvents events;
+    events.publish(CallEvents::Type::queued, makeCdr(1));
+    CallEvents::Subscriber subscriber(events);
+    events.publish(CallEvents::Type::queued, makeCdr(2));
+
+    CallEvents::Event event;
+    ASSERT_EQ(subscriber.next(event), CallEvents::Result::ok);
+    ASSERT_EQ(event.cdr.callId, 2);
+}
+
+TEST(callEvents, slowSubscriberLagged){
+    CallEvents events;
+    CallEvents::Subscriber slow(events);
+    for (size_t i = 0; i < CallEvents::capacity + 1; ++i)
+        events.publish(CallEvents::Type::queued, makeCdr(i));
+
+    CallEvents::Event event;
+    ASSERT_EQ(slow.next(event), CallEvents::Result::lagged);
+}
+
+TEST(callEvents, concurrentPublishers){
+    CallEvents events;
+    const size_t nThreads = 4;
+    const size_t nEvents = 10000;
+    CallEvents::Subscriber subscriber(events);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < nThreads; ++i)
+        threads.emplace_back([&events, i, nEvents]{
+            for (size_t j = 0; j < nEvents; ++j)
+                events.publish(CallEvents::Type::ended,
+                               makeCdr(i * nEvents + j));
+        });
+
+    size_t received = 0;
+    CallEvents::Event event;
+    while (received < nThreads * nEvents){
+        auto result = subscriber.next(event);
+        ASSERT_NE(result, CallEvents::Result::lagged);
+        if (result == CallEvents::Result::empty){
+            std::this_thread::yield();
+            continue;
+        }
+        // Event is not torn
+        ASSERT_EQ(event.cdr.phoneNumber.view(),
+                  std::to_string(event.cdr.callId));
+        ASSERT_EQ(event.cdr.operatorId, event.cdr.callId * 3);
+        ++received;
+    }
+    for (auto & th : threads)
+        th.join();
+}
+
+TEST(callEvents, publishWakesWaitingSubscriber){
+    CallEvents events;
+    CallEvents::Subscriber subscriber(events);
+    auto & wakeup = events.getWakeup();
+    const auto ticket = wakeup.prepare();
+    CallEvents::Event event;
+    ASSERT_EQ(subscriber.next(event), CallEvents::Result::empty);
+    std::thread publisher([&events]{
+        events.publish(CallEvents::Type::queued, makeCdr(1));
+    });
+    ASSERT_TRUE(wakeup.wait(ticket, std::chrono::seconds(10)));
+    publisher.join();
+    ASSERT_EQ(subscriber.next(event), CallEvents::Result::ok);
+    EXPECT_EQ(event.cdr.callId, 1);
+}
+
+TEST(callEvents, wakeupFdIsReadableAfterPublish){
+    CallEvents events;
+    auto & wakeup = events.getWakeup();
+    const int fd = wakeup.openFd();
+    ASSERT_GE(fd, 0);
+    uint64_t value;
+    // Nobody waits, publish doesn't notify
+    events.publish(CallEvents::Type::queued, makeCdr(1));
+    ASSERT_LT(read(fd, &value, sizeof(value)), 0);
+
+    wakeup.prepare();
+    events.publish(CallEvents::Type::answered, makeCdr(1));
+    ASSERT_EQ(read(fd, &value, sizeof(value)), sizeof(value));
+    Wakeup::consume(fd);
+    ASSERT_LT(read(fd, &value, sizeof(value)), 0);
+    wakeup.closeFd(fd);
+}
+
+TEST(callEvents, waitTimesOutWithoutPublish){
+    CallEvents events;
+    auto & wakeup = events.getWakeup();
+    const auto ticket = wakeup.prepare();
+    ASSERT_FALSE(wakeup.wait(ticket, std::chrono::milliseconds(10)));
+}
@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+#include "../include/call-index.h"
+#include "../include/cdr.h"
+
+using namespace cdr;
+
+class CallIndexTest : public ::testing::Test{
+protected:
+	void SetUp(){
+        cdr1.callId = 1;
+        cdr1.phoneNumber = "1";
+        cdr2.callId = 2;
+        cdr2.phoneNumber = "2";
+	}
+	void TearDown(){
+	}
+    CallIndex index;
+    Cdr cdr1;
+    Cdr cdr2;
+    CallIndex::Entry entry;
+};
+
+
+TEST_F(CallIndexTest, findNotExistingCall){
+    ASSERT_FALSE(index.find(cdr1.callId, entry));
+}
+
+TEST_F(CallIndexTest, findQueuedCall){
+    index.update(CallIndex::State::queued, cdr1);
+
+    ASSERT_TRUE(index.find(cdr1.callId, entry));
+    EXPECT_EQ(entry.state, CallIndex::State::queued);
+    ASSERT_EQ(entry.cdr.phoneNumber, cdr1.phoneNumber);
+}
+
+TEST_F(CallIndexTest, updateCallState){
+    index.update(CallIndex::State::queued, cdr1);
+    cdr1.operatorId = 7;
+    index.update(CallIndex::State::serving, cdr1);
+
+    ASSERT_TRUE(index.find(cdr1.callId, entry));
+    EXPECT_EQ(entry.state, CallIndex::State::serving);
+    EXPECT_EQ(entry.cdr.operatorId, 7);
+    ASSERT_EQ(index.getSize(), 1);
+}
+
+TEST_F(CallIndexTest, finishedCallsEvictedByRetention){
+    index.setRetention(0);
+    index.update(CallIndex::State::timeout, cdr1);
+    index.update(CallIndex::State::queued, cdr2);
+
+    EXPECT_FALSE(index.find(cdr1.callId, entry));
+    ASSERT_TRUE(index.find(cdr2.callId, entry));
+}
+
+TEST_F(CallIndexTest, finishedCallsBoundedByCapacity){
+    ASSERT_TRUE(index.setCapacity(16));
+    for (size_t i = 1; i <= 1000; ++i){
+        cdr1.callId = i;
+        index.update(CallIndex::State::ended, cdr1);
+    }
+
+    ASSERT_LE(index.getSize(), 16);
+}
+
+TEST_F(CallIndexTest, liveCallsNotEvicted){
+    index.setRetention(0);
+    index.update(CallIndex::State::queued, cdr1);
+    index.update(CallIndex::State::ended, cdr2);
+
+    ASSERT_TRUE(index.find(cdr1.callId, entry));
+}
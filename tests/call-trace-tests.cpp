@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "../include/call-trace.h"
+
+using Stage = CallTrace::Stage;
+
+namespace{
+
+size_t count(const std::string & s, const std::string & what){
+    size_t n = 0;
+    for (auto pos = s.find(what); pos != std::string::npos;
+         pos = s.find(what, pos + what.size()))
+        ++n;
+    return n;
+}
+
+}
+
+TEST(callTrace, disabledRecordsNothing){
+    CallTrace trace;
+    trace.markReceived();
+    trace.recordPush(1);
+    trace.record(Stage::queued, 1);
+    ASSERT_EQ(trace.dump(10), "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[]}");
+}
+
+TEST(callTrace, slicesBetweenStages){
+    CallTrace trace;
+    trace.setSampleRate(1);
+    trace.markReceived();
+    trace.recordPush(42);
+    trace.record(Stage::queued, 42);
+    trace.record(Stage::popped, 42);
+    trace.record(Stage::answered, 42);
+    trace.record(Stage::ended, 42);
+    auto json = trace.dump(10);
+
+    // received -> pushing -> queued -> popped -> answered -> ended
+    EXPECT_EQ(count(json, "\"ph\":\"b\""), 5);
+    EXPECT_EQ(count(json, "\"ph\":\"e\""), 5);
+    EXPECT_EQ(count(json, "\"name\":\"wait\""), 2);
+    EXPECT_EQ(count(json, "\"name\":\"talk\""), 2);
+    ASSERT_EQ(count(json, "\"call_id\":\"42\""), 10);
+}
+
+TEST(callTrace, samplingIsPerCall){
+    CallTrace trace;
+    trace.setSampleRate(0.25);
+    size_t sampled = 0;
+    for (uint64_t callId = 1; callId <= 4000; ++callId){
+        trace.record(Stage::queued, callId);
+        trace.record(Stage::popped, callId);
+    }
+    auto json = trace.dump(10);
+    sampled = count(json, "\"ph\":\"b\"");
+    // Both stages of a sampled call are recorded
+    EXPECT_EQ(count(json, "\"ph\":\"e\""), sampled);
+    EXPECT_GT(sampled, 800);
+    ASSERT_LT(sampled, 1200);
+}
+
+TEST(callTrace, ringKeepsLastStages){
+    CallTrace trace;
+    trace.setSampleRate(1);
+    for (uint64_t callId = 1; callId <= CallTrace::ringCapacity; ++callId){
+        trace.record(Stage::queued, callId);
+        trace.record(Stage::popped, callId);
+    }
+    auto json = trace.dump(10);
+    EXPECT_EQ(count(json, "\"ph\":\"b\""), CallTrace::ringCapacity / 2);
+    ASSERT_EQ(count(json, "\"call_id\":\"1\""), 0);
+}
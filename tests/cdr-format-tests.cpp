@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+#include "../include/cdr-format.h"
+
+using namespace cdr;
+
+class CdrFormatTest : public ::testing::Test{
+protected:
+	void SetUp(){
+        cdr.callId = 123;
+        cdr.phoneNumber = "79990000000";
+        cdr.receiveDT = 10;
+        cdr.responseDT = 15;
+        cdr.endDT = 75;
+        cdr.operatorId = 3;
+        cdr.callDuration = 60;
+        cdr.callStatus = CallStatus::ok;
+	}
+	void TearDown(){
+	}
+    std::string format(char * (*f)(const Cdr &, char *)){
+        char buf[cdrformat::maxRecordSize];
+        return std::string(buf, f(cdr, buf));
+    }
+    std::string unixTime(Seconds t){
+        return std::to_string(toUnixTime(t));
+    }
+    Cdr cdr;
+};
+
+
+TEST_F(CdrFormatTest, csvAnsweredCall){
+    ASSERT_EQ(format(cdrformat::formatCsv),
+              "123,79990000000," + unixTime(10) + "," + unixTime(15) + "," +
+              unixTime(75) + ",ok,3,60\n");
+}
+
+TEST_F(CdrFormatTest, csvNotAnsweredCall){
+    cdr.callStatus = CallStatus::timeout;
+    cdr.callDuration = 0;
+    ASSERT_EQ(format(cdrformat::formatCsv),
+              "123,79990000000," + unixTime(10) + ",," +
+              unixTime(75) + ",timeout,,0\n");
+}
+
+TEST_F(CdrFormatTest, csvQuotedPhoneNumber){
+    cdr.phoneNumber = "1,\"2";
+    auto line = format(cdrformat::formatCsv);
+    ASSERT_EQ(line.substr(0, 12), "123,\"1,\"\"2\",");
+}
+
+TEST_F(CdrFormatTest, ndjsonAnsweredCall){
+    ASSERT_EQ(format(cdrformat::formatNdjson),
+              "{\"call_id\":123,\"phone_number\":\"79990000000\","
+              "\"receive_time\":" + unixTime(10) +
+              ",\"response_time\":" + unixTime(15) +
+              ",\"end_time\":" + unixTime(75) +
+              ",\"call_status\":\"ok\",\"operator_id\":3,"
+              "\"call_duration\":60}\n");
+}
+
+TEST_F(CdrFormatTest, ndjsonEscapedPhoneNumber){
+    cdr.phoneNumber = "1\"\\\n";
+    auto line = format(cdrformat::formatNdjson);
+    ASSERT_NE(line.find("\"phone_number\":\"1\\\"\\\\\\u000a\""),
+              std::string::npos);
+}
+
+TEST_F(CdrFormatTest, maxRecordFitsBuffer){
+    cdr.phoneNumber = std::string(PhoneNumber::capacity, '\n');
+    cdr.callId = UINT64_MAX;
+    cdr.operatorId = UINT32_MAX;
+    cdr.callDuration = UINT32_MAX;
+    ASSERT_LT(format(cdrformat::formatNdjson).size(),
+              cdrformat::maxRecordSize);
+}
@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+#include <fstream>
+#include <filesystem>
+
+#include "../include/call-center.h"
+#include "../include/config-watcher.h"
+
+namespace{
+
+std::string tempDir(){
+    auto dir = testing::TempDir() + "config-watcher-" +
+        std::to_string(getpid());
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    return dir;
+}
+
+void writeFile(const std::string & path, const std::string & content){
+    std::ofstream f(path);
+    f << content;
+}
+
+// Configuration files are looked up in the parent of working directory
+class ConfigDir{
+public:
+    ConfigDir() :
+        dir{tempDir()},
+        cwd{std::filesystem::current_path()}
+    {
+        std::filesystem::create_directories(dir + "/run");
+        std::filesystem::current_path(dir + "/run");
+    }
+    ~ConfigDir(){
+        std::filesystem::current_path(cwd);
+        std::filesystem::remove_all(dir);
+    }
+
+    const std::string dir;
+
+private:
+    const std::filesystem::path cwd;
+};
+
+const char * const defaultConf = R"({
+    "minResponseTime" : 0,
+    "maxResponseTime" : 180,
+    "minCallDuration" : 60,
+    "maxCallDuration" : 300,
+    "nOperators" : 10,
+    "rejectRepeatedCalls" : false,
+    "maxCallQueueSize" : 100,
+    "callDuration" : {"type" : "uniform"},
+    "patience" : null,
+    "schedule" : [],
+    "callIndexRetention" : 600,
+    "callIndexCapacity" : 100000,
+    "serviceLevelTime" : 20,
+    "nodeId" : 0,
+    "cdrExportDir" : "",
+    "cdrExportFormat" : "csv",
+    "eventLogFile" : "",
+    "eventLogLossless" : false,
+    "textLog" : true,
+    "traceSampleRate" : 0,
+    "randomSeed" : 0,
+    "loadShedding" : true,
+    "httpIngress" : "httplib",
+    "httpIngressThreads" : 0,
+    "binaryIngress" : "",
+    "binaryIngressThreads" : 1,
+    "sipIngress" : "",
+    "sipIngressThreads" : 1
+})";
+
+}
+
+TEST(configWatcher, hashFiles){
+    const auto dir = tempDir();
+    const auto a = dir + "/a.json", b = dir + "/b.json";
+    writeFile(a, "{\"nOperators\" : 1}");
+    writeFile(b, "{}");
+    const auto hash = ConfigWatcher::hashFiles({a, b});
+    ASSERT_EQ(ConfigWatcher::hashFiles({a, b}), hash);
+
+    // Rewritten with the same content
+    writeFile(a, "{\"nOperators\" : 1}");
+    ASSERT_EQ(ConfigWatcher::hashFiles({a, b}), hash);
+
+    writeFile(a, "{\"nOperators\" : 2}");
+    const auto changed = ConfigWatcher::hashFiles({a, b});
+    ASSERT_NE(changed, hash);
+
+    // Missing file is hashed as empty, file boundaries are hashed
+    std::filesystem::remove(b);
+    const auto missing = ConfigWatcher::hashFiles({a, b});
+    ASSERT_NE(missing, changed);
+    writeFile(b, "");
+    ASSERT_EQ(ConfigWatcher::hashFiles({a, b}), missing);
+    ASSERT_NE(ConfigWatcher::hashFiles({a}), missing);
+    std::filesystem::remove_all(dir);
+}
+
+TEST(configWatcher, reloadOnlyChangedContent){
+    ConfigDir configDir;
+    writeFile(configDir.dir + "/default-call-center.json", defaultConf);
+    writeFile(configDir.dir + "/call-center.json", "{\"nOperators\" : 3}");
+    auto callCenter = CallCenter::getCallCenter("call-center.json");
+    ASSERT_EQ(callCenter->getConfig().nOperators, 3);
+    const auto version = callCenter->getConfig().version;
+
+    ConfigWatcher watcher(callCenter, std::chrono::seconds(0));
+    ASSERT_FALSE(watcher.reload());
+    // Editor saving the file without changes
+    writeFile(configDir.dir + "/call-center.json", "{\"nOperators\" : 3}");
+    ASSERT_FALSE(watcher.reload());
+    ASSERT_EQ(callCenter->getConfig().version, version);
+
+    writeFile(configDir.dir + "/call-center.json", "{\"nOperators\" : 4}");
+    ASSERT_TRUE(watcher.reload());
+    ASSERT_EQ(callCenter->getConfig().nOperators, 4);
+    ASSERT_EQ(callCenter->getConfig().version, version + 1);
+    ASSERT_FALSE(watcher.reload());
+}
@@ -0,0 +1,199 @@
+#include <gtest/gtest.h>
+
+#include <zlib.h>
+#include <unistd.h>
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+
+#include "../include/distribution.h"
+#include "../include/rand-generator.h"
+#include "../include/cdr-format.h"
+
+using namespace cdr;
+
+namespace{
+
+std::string tempDir(){
+    auto dir = testing::TempDir() + "cdr-history-" +
+        std::to_string(getpid());
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    return dir;
+}
+
+Cdr makeCdr(const CallStatus status, const Seconds wait,
+            const uint32_t duration){
+    Cdr cdr;
+    cdr.callId = 1;
+    cdr.phoneNumber = "8,800";
+    cdr.receiveDT = 0;
+    cdr.responseDT = wait;
+    cdr.endDT = wait + duration;
+    cdr.callStatus = status;
+    cdr.operatorId = 1;
+    cdr.callDuration = duration;
+    return cdr;
+}
+
+void writeGz(const std::string & path, const std::vector<Cdr> & cdrs,
+             const bool csv){
+    gzFile file = gzopen(path.c_str(), "wb");
+    if (csv)
+        gzwrite(file, cdrformat::csvHeader.data(), cdrformat::csvHeader.size());
+    char buffer[cdrformat::maxRecordSize];
+    for (auto & cdr : cdrs){
+        auto end = csv ? cdrformat::formatCsv(cdr, buffer) :
+                         cdrformat::formatNdjson(cdr, buffer);
+        gzwrite(file, buffer, end - buffer);
+    }
+    gzclose(file);
+}
+
+}
+
+TEST(aliasTable, frequenciesFollowWeights){
+    const std::vector<double> weights{1, 0, 3, 6};
+    AliasTable table(weights);
+    ASSERT_EQ(table.size(), weights.size());
+    rndgen::setSeed(3);
+    const size_t n = 200000;
+    std::vector<size_t> counts(weights.size());
+    for (size_t i = 0; i < n; ++i)
+        ++counts[table.sample(rndgen::next())];
+    ASSERT_EQ(counts[1], 0);
+    for (size_t i = 0; i < weights.size(); ++i)
+        ASSERT_NEAR(static_cast<double>(counts[i]) / n, weights[i] / 10, 0.01);
+}
+
+TEST(aliasTable, singleValue){
+    AliasTable table({5});
+    ASSERT_EQ(table.sample(0), 0);
+    ASSERT_EQ(table.sample(UINT64_MAX), 0);
+}
+
+TEST(distribution, uniformWithinBounds){
+    Distribution d;
+    for (int i = 0; i < 1000; ++i){
+        auto x = d.sample(60, 70);
+        ASSERT_GE(x, 60);
+        ASSERT_LE(x, 70);
+    }
+}
+
+TEST(distribution, exponentialMean){
+    auto d = Distribution::exponential(100);
+    ASSERT_TRUE(d.isValid());
+    rndgen::setSeed(4);
+    double sum = 0;
+    const int n = 100000;
+    for (int i = 0; i < n; ++i)
+        sum += d.sample(0, 1000000);
+    ASSERT_NEAR(sum / n, 100, 2);
+    ASSERT_FALSE(Distribution::exponential(0).isValid());
+}
+
+TEST(distribution, lognormalMedian){
+    // Median is exp(mu)
+    auto d = Distribution::lognormal(std::log(200.0), 0.5);
+    ASSERT_TRUE(d.isValid());
+    rndgen::setSeed(5);
+    std::vector<size_t> samples(20001);
+    for (auto & x : samples)
+        x = d.sample(0, 1000000);
+    std::nth_element(samples.begin(), samples.begin() + 10000, samples.end());
+    ASSERT_NEAR(samples[10000], 200, 6);
+    ASSERT_FALSE(Distribution::lognormal(0, -1).isValid());
+}
+
+TEST(distribution, clampedToBounds){
+    auto d = Distribution::empirical({1, 1000}, {1, 1});
+    for (int i = 0; i < 100; ++i){
+        auto x = d.sample(10, 100);
+        ASSERT_TRUE(x == 10 || x == 100);
+    }
+}
+
+TEST(distribution, empiricalValues){
+    auto d = Distribution::empirical({30, 60, 90}, {0, 1, 1});
+    ASSERT_TRUE(d.isValid());
+    for (int i = 0; i < 1000; ++i){
+        auto x = d.sample(1, 1000);
+        ASSERT_TRUE(x == 60 || x == 90);
+    }
+    ASSERT_FALSE(Distribution::empirical({}, {}).isValid());
+    ASSERT_FALSE(Distribution::empirical({1, 2}, {1}).isValid());
+    ASSERT_FALSE(Distribution::empirical({1}, {-1}).isValid());
+    ASSERT_FALSE(Distribution::empirical({1, 2}, {0, 0}).isValid());
+}
+
+TEST(distribution, parseType){
+    Distribution::Type type;
+    ASSERT_TRUE(Distribution::parseType("lognormal", type));
+    ASSERT_EQ(type, Distribution::Type::lognormal);
+    ASSERT_STREQ(Distribution::toString(Distribution::Type::empirical),
+                 "empirical");
+    ASSERT_FALSE(Distribution::parseType("normal", type));
+}
+
+TEST(distribution, readHistory){
+    const auto dir = tempDir();
+    writeGz(dir + "/cdr-2026101909.csv.gz",
+            {makeCdr(CallStatus::ok, 5, 60), makeCdr(CallStatus::ok, 5, 120),
+             makeCdr(CallStatus::abandoned, 40, 0),
+             makeCdr(CallStatus::timeout, 180, 0)}, true);
+    writeGz(dir + "/cdr-2026101910.ndjson.gz",
+            {makeCdr(CallStatus::ok, 1, 60),
+             makeCdr(CallStatus::abandoned, 40, 0),
+             makeCdr(CallStatus::abandoned, 25, 0)}, false);
+    // Not CDR export file
+    writeGz(dir + "/other.csv.gz", {makeCdr(CallStatus::ok, 1, 999)}, true);
+
+    std::vector<double> values, weights;
+    ASSERT_TRUE(Distribution::readHistory(
+        dir, Distribution::HistoryField::callDuration, values, weights));
+    ASSERT_EQ(values, (std::vector<double>{60, 120}));
+    ASSERT_EQ(weights, (std::vector<double>{2, 1}));
+
+    ASSERT_TRUE(Distribution::readHistory(
+        dir, Distribution::HistoryField::patience, values, weights));
+    ASSERT_EQ(values, (std::vector<double>{25, 40}));
+    ASSERT_EQ(weights, (std::vector<double>{1, 2}));
+
+    ASSERT_FALSE(Distribution::readHistory(
+        dir + "/missing", Distribution::HistoryField::patience,
+        values, weights));
+    std::filesystem::remove_all(dir);
+}
+
+TEST(historyCache, unchangedHistoryReused){
+    const auto dir = tempDir();
+    const auto field = Distribution::HistoryField::callDuration;
+    auto & cache = HistoryCache::instance();
+    ASSERT_EQ(cache.find(dir, field), nullptr);
+    writeGz(dir + "/cdr-2026101909.csv.gz",
+            {makeCdr(CallStatus::ok, 5, 60)}, true);
+
+    auto first = cache.get(dir, field);
+    ASSERT_NE(first, nullptr);
+    EXPECT_EQ(first->getValues(), (std::vector<double>{60}));
+    EXPECT_EQ(first->getHistory(), dir);
+    ASSERT_EQ(cache.get(dir, field), first);
+    ASSERT_EQ(cache.find(dir, field), first);
+
+    // New file is read, the old one is taken from cache
+    writeGz(dir + "/cdr-2026101910.ndjson.gz",
+            {makeCdr(CallStatus::ok, 5, 90)}, false);
+    auto second = cache.get(dir, field);
+    ASSERT_NE(second, first);
+    EXPECT_EQ(second->getValues(), (std::vector<double>{60, 90}));
+    // find() doesn't check files
+    std::filesystem::remove(dir + "/cdr-2026101910.ndjson.gz");
+    ASSERT_EQ(cache.find(dir, field), second);
+    ASSERT_EQ(cache.get(dir, field)->getValues(), (std::vector<double>{60}));
+
+    std::filesystem::remove_all(dir);
+    ASSERT_EQ(cache.get(dir, field), nullptr);
+}
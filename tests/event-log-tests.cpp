@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#include "../include/event-log.h"
+
+using namespace cdr;
+
+namespace{
+
+Cdr makeCdr(const uint64_t callId, const uint32_t operatorId,
+            const CallStatus status){
+    Cdr cdr;
+    cdr.callId = callId;
+    cdr.operatorId = operatorId;
+    cdr.callStatus = status;
+    return cdr;
+}
+
+std::string tempPath(){
+    return testing::TempDir() + "event-log-" + std::to_string(getpid()) +
+        ".bin";
+}
+
+}
+
+TEST(eventLog, recordFields){
+    CallEvents::Event event{CallEvents::Type::answered, 3,
+                            1700000000123456789ull,
+                            makeCdr(42, 7, CallStatus::ok)};
+    auto record = EventLog::toRecord(event);
+
+    EXPECT_EQ(EventLog::toText(record),
+              "2023-11-14T22:13:20.123456789Z answered call_id: 42 "
+              "operator_id: 7 status: ok queue_size: 3");
+    ASSERT_EQ(EventLog::toJson(record),
+              "{\"time\":1700000000123456789,\"type\":\"answered\","
+              "\"call_id\":42,\"operator_id\":7,\"status\":\"ok\","
+              "\"queue_size\":3}");
+}
+
+TEST(eventLog, lostRecordFields){
+    EventLog::Record record{};
+    record.time = 1700000000000000000ull;
+    record.type = EventLog::lostType;
+    record.callId = 70000;
+    EXPECT_EQ(EventLog::toText(record),
+              "2023-11-14T22:13:20.000000000Z lost events: 70000");
+    ASSERT_EQ(EventLog::toJson(record),
+              "{\"time\":1700000000000000000,\"type\":\"lost\","
+              "\"events\":70000}");
+}
+
+TEST(eventLog, parseType){
+    uint8_t type = 0;
+    EXPECT_TRUE(EventLog::parseType("timedOut", type));
+    EXPECT_EQ(type, static_cast<uint8_t>(CallEvents::Type::timedOut));
+    EXPECT_TRUE(EventLog::parseType("lost", type));
+    EXPECT_EQ(type, EventLog::lostType);
+    ASSERT_FALSE(EventLog::parseType("unknown", type));
+}
+
+TEST(eventLog, writtenRecordsRead){
+    const auto path = tempPath();
+    unlink(path.c_str());
+    CallEvents events;
+    {
+        EventLog log(events);
+        ASSERT_TRUE(log.setFile(path, false));
+        events.publish(CallEvents::Type::queued,
+                       makeCdr(1, 0, CallStatus::ok), 1);
+        events.publish(CallEvents::Type::rejected,
+                       makeCdr(2, 0, CallStatus::overload), 1);
+        while (log.getWritten() < 2)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    // Appended to existing file
+    {
+        EventLog log(events);
+        ASSERT_TRUE(log.setFile(path, false));
+        events.publish(CallEvents::Type::ended,
+                       makeCdr(1, 5, CallStatus::ok), 0);
+        while (log.getWritten() < 1)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    EventLog::Reader reader;
+    ASSERT_TRUE(reader.open(path));
+    std::vector<EventLog::Record> records;
+    EventLog::Record record;
+    while (reader.next(record))
+        records.push_back(record);
+    unlink(path.c_str());
+
+    ASSERT_EQ(records.size(), 3);
+    EXPECT_EQ(records[0].type, static_cast<uint8_t>(CallEvents::Type::queued));
+    EXPECT_EQ(records[1].status, static_cast<uint8_t>(CallStatus::overload));
+    EXPECT_EQ(records[2].operatorId, 5);
+    ASSERT_EQ(records[2].queueSize, 0);
+}
+
+// Publishing more than the ring holds at once
+TEST(eventLog, losslessLogKeepsAllEvents){
+    const auto path = tempPath();
+    unlink(path.c_str());
+    CallEvents events;
+    const size_t n = 3 * CallEvents::capacity;
+    {
+        EventLog log(events);
+        ASSERT_TRUE(log.setFile(path, true));
+        for (size_t i = 0; i < n; ++i)
+            events.publish(CallEvents::Type::queued,
+                           makeCdr(i, 0, CallStatus::ok), 1);
+        while (log.getWritten() < n)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        EXPECT_EQ(log.getLost(), 0);
+    }
+
+    EventLog::Reader reader;
+    ASSERT_TRUE(reader.open(path));
+    EventLog::Record record;
+    size_t count = 0;
+    while (reader.next(record)){
+        ASSERT_EQ(record.callId, count);
+        ++count;
+    }
+    unlink(path.c_str());
+    ASSERT_EQ(count, n);
+}
+
+TEST(eventLog, foreignFileNotAppended){
+    const auto path = tempPath();
+    FILE * f = fopen(path.c_str(), "wb");
+    fputs("not an event log", f);
+    fclose(f);
+
+    CallEvents events;
+    EventLog log(events);
+    EXPECT_FALSE(log.setFile(path, false));
+    unlink(path.c_str());
+    ASSERT_EQ(log.getFile(), "");
+}
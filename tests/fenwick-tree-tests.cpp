@@ -0,0 +1,32 @@
+#include <gtest/gtest.h>
+#include "../include/fenwick-tree.h"
+
+TEST(fenwickTree, prefixSums){
+    FenwickTree<int64_t> tree(10);
+    for (size_t i = 0; i < 10; ++i)
+        tree.add(i, i);
+
+    EXPECT_EQ(tree.prefixSum(0), 0);
+    EXPECT_EQ(tree.prefixSum(4), 10);
+    ASSERT_EQ(tree.prefixSum(9), 45);
+}
+
+TEST(fenwickTree, negativeDelta){
+    FenwickTree<int64_t> tree(8);
+    for (size_t i = 0; i < 8; ++i)
+        tree.add(i, 1);
+    tree.add(2, -1);
+
+    EXPECT_EQ(tree.prefixSum(1), 2);
+    EXPECT_EQ(tree.prefixSum(2), 2);
+    ASSERT_EQ(tree.prefixSum(7), 7);
+}
+
+TEST(fenwickTree, resetZeroes){
+    FenwickTree<int64_t> tree(4);
+    tree.add(1, 5);
+    tree.reset(16);
+
+    EXPECT_EQ(tree.size(), 16);
+    ASSERT_EQ(tree.prefixSum(15), 0);
+}
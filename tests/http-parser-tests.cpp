@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "../include/http-parser.h"
+
+using http::ParseResult;
+
+namespace{
+
+ParseResult parse(const std::string & data, httplib::Request & req,
+                  size_t & consumed, int & status){
+    req = httplib::Request();
+    consumed = 0;
+    return http::parseRequest(data, req, consumed, status);
+}
+
+};
+
+TEST(httpParser, requestLine){
+    httplib::Request req;
+    size_t consumed;
+    int status;
+    const std::string data =
+        "GET /call%2Fposition?phone_number=79990000001&x=1 HTTP/1.1\r\n"
+        "Host: localhost\r\n"
+        "\r\n";
+    ASSERT_EQ(parse(data, req, consumed, status), ParseResult::complete);
+    EXPECT_EQ(consumed, data.size());
+    EXPECT_EQ(req.method, "GET");
+    EXPECT_EQ(req.path, "/call/position");
+    EXPECT_EQ(req.version, "HTTP/1.1");
+    EXPECT_EQ(req.get_param_value("phone_number"), "79990000001");
+    EXPECT_EQ(req.get_param_value("x"), "1");
+    ASSERT_EQ(req.get_header_value("host"), "localhost");
+
+    ASSERT_EQ(parse("GET\r\n\r\n", req, consumed, status),
+              ParseResult::error);
+    EXPECT_EQ(status, 400);
+    ASSERT_EQ(parse("GET / SIP/2.0\r\n\r\n", req, consumed, status),
+              ParseResult::error);
+    EXPECT_EQ(status, 400);
+    ASSERT_EQ(parse("GET / HTTP/1.1\r\nNo colon\r\n\r\n", req, consumed,
+                    status), ParseResult::error);
+    ASSERT_EQ(status, 400);
+}
+
+TEST(httpParser, contentLength){
+    httplib::Request req;
+    size_t consumed;
+    int status;
+    const std::string head = "POST /calls HTTP/1.1\r\n"
+        "content-length:  11 \r\n"
+        "\r\n";
+    ASSERT_EQ(parse(head + "[\"7999000\"", req, consumed, status),
+              ParseResult::incomplete);
+    ASSERT_EQ(parse(head + "[\"7999000\"]", req, consumed, status),
+              ParseResult::complete);
+    EXPECT_EQ(req.body, "[\"7999000\"]");
+    EXPECT_EQ(consumed, head.size() + 11);
+
+    ASSERT_EQ(parse("POST / HTTP/1.1\r\nContent-Length: 1x\r\n\r\n", req,
+                    consumed, status), ParseResult::error);
+    EXPECT_EQ(status, 400);
+    ASSERT_EQ(parse("POST / HTTP/1.1\r\nContent-Length: -1\r\n\r\n", req,
+                    consumed, status), ParseResult::error);
+    ASSERT_EQ(status, 400);
+}
+
+TEST(httpParser, errorStatuses){
+    httplib::Request req;
+    size_t consumed;
+    int status;
+    const auto tooLarge = "POST / HTTP/1.1\r\nContent-Length: " +
+        std::to_string(http::maxBodySize + 1) + "\r\n\r\n";
+    ASSERT_EQ(parse(tooLarge, req, consumed, status), ParseResult::error);
+    EXPECT_EQ(status, 413);
+
+    // Headers without end are incomplete until maxHeaderSize
+    std::string headers = "GET / HTTP/1.1\r\nX: ";
+    ASSERT_EQ(parse(headers, req, consumed, status),
+              ParseResult::incomplete);
+    headers.append(http::maxHeaderSize, 'x');
+    ASSERT_EQ(parse(headers, req, consumed, status), ParseResult::error);
+    EXPECT_EQ(status, 431);
+
+    ASSERT_EQ(parse("POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n",
+                    req, consumed, status), ParseResult::error);
+    ASSERT_EQ(status, 501);
+}
+
+TEST(httpParser, pipelining){
+    const std::string first = "POST /calls HTTP/1.1\r\n"
+        "Content-Length: 2\r\n"
+        "\r\n"
+        "[]";
+    const std::string second = "GET /metrics HTTP/1.1\r\n\r\n";
+    const std::string data = first + second + "GET /ca";
+    httplib::Request req;
+    size_t consumed;
+    int status;
+    ASSERT_EQ(parse(data, req, consumed, status), ParseResult::complete);
+    EXPECT_EQ(req.path, "/calls");
+    EXPECT_EQ(req.body, "[]");
+    ASSERT_EQ(consumed, first.size());
+
+    auto rest = std::string_view(data).substr(consumed);
+    req = httplib::Request();
+    ASSERT_EQ(http::parseRequest(rest, req, consumed, status),
+              ParseResult::complete);
+    EXPECT_EQ(req.path, "/metrics");
+    ASSERT_EQ(consumed, second.size());
+
+    rest.remove_prefix(consumed);
+    ASSERT_EQ(http::parseRequest(rest, req, consumed, status),
+              ParseResult::incomplete);
+}
+
+TEST(httpParser, keepAlive){
+    httplib::Request req;
+    size_t consumed;
+    int status;
+    auto keepAlive = [&](const std::string & version,
+                         const std::string & connection){
+        auto data = "GET / " + version + "\r\n";
+        if (!connection.empty())
+            data += "Connection: " + connection + "\r\n";
+        EXPECT_EQ(parse(data + "\r\n", req, consumed, status),
+                  ParseResult::complete);
+        return http::isKeepAlive(req);
+    };
+    EXPECT_TRUE(keepAlive("HTTP/1.1", ""));
+    EXPECT_TRUE(keepAlive("HTTP/1.1", "keep-alive"));
+    EXPECT_FALSE(keepAlive("HTTP/1.1", "close"));
+    EXPECT_FALSE(keepAlive("HTTP/1.1", "Close"));
+    EXPECT_FALSE(keepAlive("HTTP/1.0", ""));
+    EXPECT_TRUE(keepAlive("HTTP/1.0", "Keep-Alive"));
+    ASSERT_FALSE(keepAlive("HTTP/1.0", "close"));
+}
@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "../include/http-router.h"
+
+namespace{
+
+httplib::Request request(const std::string & method,
+                         const std::string & path){
+    httplib::Request req;
+    req.method = method;
+    req.path = path;
+    return req;
+}
+
+// Route name set as body by handler
+std::string route(const HttpRouter & router, const std::string & method,
+                  const std::string & path){
+    auto req = request(method, path);
+    httplib::Response res;
+    HttpRouter::StreamPoll stream;
+    if (!router.route(req, res, stream))
+        return "";
+    return res.body;
+}
+
+HttpRouter::Handler answer(const std::string & name){
+    return [name](const httplib::Request &, httplib::Response & res){
+        res.body = name;
+    };
+}
+
+};
+
+TEST(httpRouter, methodsAndPaths){
+    HttpRouter router;
+    router.get("/call", answer("get call"))
+        .post("/calls", answer("post calls"))
+        .del("/call", answer("delete call"))
+        .patch("/config", answer("patch config"));
+
+    EXPECT_EQ(route(router, "GET", "/call"), "get call");
+    EXPECT_EQ(route(router, "DELETE", "/call"), "delete call");
+    EXPECT_EQ(route(router, "POST", "/calls"), "post calls");
+    EXPECT_EQ(route(router, "PATCH", "/config"), "patch config");
+    // GET routes answer HEAD
+    EXPECT_EQ(route(router, "HEAD", "/call"), "get call");
+
+    EXPECT_EQ(route(router, "POST", "/call"), "");
+    EXPECT_EQ(route(router, "GET", "/calls"), "");
+    ASSERT_EQ(route(router, "GET", "/call/position"), "");
+}
+
+TEST(httpRouter, regexRoutes){
+    HttpRouter router;
+    router.get("/calls/(\\d+)", [](const httplib::Request & req,
+                                  httplib::Response & res){
+        res.body = req.matches[1];
+    });
+    router.get("/calls/.*", answer("any"));
+
+    EXPECT_EQ(route(router, "GET", "/calls/42"), "42");
+    // Routes are matched in registration order
+    EXPECT_EQ(route(router, "GET", "/calls/x"), "any");
+    // Whole path must match
+    ASSERT_EQ(route(router, "GET", "/v1/calls/42"), "");
+}
+
+TEST(httpRouter, stream){
+    HttpRouter router;
+    router.stream("/events", [](const httplib::Request &,
+                                httplib::Response & res){
+        res.set_header("Content-Type", "text/event-stream");
+        return HttpRouter::StreamPoll([](std::string & out){
+            out += "data\n\n";
+            return false;
+        });
+    });
+    router.stream("/none", [](const httplib::Request &,
+                              httplib::Response & res){
+        res.status = 404;
+        return HttpRouter::StreamPoll();
+    });
+
+    auto req = request("GET", "/events");
+    httplib::Response res;
+    HttpRouter::StreamPoll stream;
+    ASSERT_TRUE(router.route(req, res, stream));
+    ASSERT_TRUE(stream);
+    std::string out;
+    EXPECT_FALSE(stream(out));
+    EXPECT_EQ(out, "data\n\n");
+
+    // Handler answering without stream
+    req = request("GET", "/none");
+    res = httplib::Response();
+    stream = nullptr;
+    ASSERT_TRUE(router.route(req, res, stream));
+    EXPECT_FALSE(stream);
+    ASSERT_EQ(res.status, 404);
+}
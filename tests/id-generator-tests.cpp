@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+
+#include <set>
+#include <thread>
+#include <vector>
+#include <chrono>
+
+#include "../include/id-generator.h"
+
+TEST(idGenerator, idsAreIncreasingInThread){
+    auto prev = idgen::next();
+    for (size_t i = 0; i < 100000; ++i){
+        auto id = idgen::next();
+        ASSERT_GT(id, prev);
+        prev = id;
+    }
+}
+
+TEST(idGenerator, idsAreUniqueAcrossThreads){
+    const size_t nThreads = 8;
+    const size_t nIds = 50000;
+    std::vector<std::vector<uint64_t>> ids(nThreads);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < nThreads; ++i)
+        threads.emplace_back([&ids, i, nIds]{
+            for (size_t j = 0; j < nIds; ++j)
+                ids[i].push_back(idgen::next());
+        });
+    for (auto & th : threads)
+        th.join();
+
+    std::set<uint64_t> unique;
+    for (auto & threadIds : ids)
+        unique.insert(threadIds.begin(), threadIds.end());
+    ASSERT_EQ(unique.size(), nThreads * nIds);
+}
+
+TEST(idGenerator, idContainsNodeId){
+    ASSERT_TRUE(idgen::setNodeId(42));
+    auto id = idgen::next();
+    EXPECT_EQ(idgen::getNodeId(id), 42);
+    ASSERT_TRUE(idgen::setNodeId(0));
+}
+
+TEST(idGenerator, invalidNodeId){
+    ASSERT_FALSE(idgen::setNodeId(idgen::maxNodeId + 1));
+}
+
+TEST(idGenerator, idContainsCurrentTime){
+    auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    auto idTime = idgen::toUnixTimeMs(idgen::getTime(idgen::next()));
+    ASSERT_LT(std::abs(idTime - now), 1000);
+}
+
+TEST(idGenerator, idIsPositiveSigned){
+    ASSERT_GT(static_cast<int64_t>(idgen::next()), 0);
+}
@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+#include "../include/kpi.h"
+
+using namespace cdr;
+
+class KpiTest : public ::testing::Test{
+protected:
+	void SetUp(){
+        kpi.setServiceLevelTime(20);
+	}
+	void TearDown(){
+	}
+    Kpi kpi;
+};
+
+
+TEST_F(KpiTest, emptyWindow){
+    auto snapshot = kpi.get(Kpi::Window::m1, 1000);
+
+    EXPECT_EQ(snapshot.window, 60);
+    EXPECT_EQ(snapshot.offered, 0);
+    ASSERT_EQ(snapshot.getServiceLevel(), 0);
+}
+
+TEST_F(KpiTest, countPushedCalls){
+    kpi.onPush(CallStatus::ok, 1000);
+    kpi.onPush(CallStatus::overload, 1000);
+    kpi.onPush(CallStatus::alreadyInQueue, 1001);
+    auto snapshot = kpi.get(Kpi::Window::m1, 1001);
+
+    EXPECT_EQ(snapshot.offered, 3);
+    ASSERT_EQ(snapshot.rejected, 2);
+}
+
+TEST_F(KpiTest, serviceLevelAndAverageSpeedOfAnswer){
+    kpi.onAnswer(10, 1000);
+    kpi.onAnswer(30, 1000);
+    auto snapshot = kpi.get(Kpi::Window::m5, 1000);
+
+    EXPECT_EQ(snapshot.answered, 2);
+    EXPECT_DOUBLE_EQ(snapshot.getServiceLevel(), 0.5);
+    ASSERT_DOUBLE_EQ(snapshot.getAverageSpeedOfAnswer(), 20);
+}
+
+TEST_F(KpiTest, timeoutRateAndAverageHandleTime){
+    kpi.onAnswer(0, 1000);
+    kpi.onTimeout(1000);
+    kpi.onEnd(100, 1100);
+    kpi.onEnd(200, 1100);
+    auto snapshot = kpi.get(Kpi::Window::m15, 1100);
+
+    EXPECT_DOUBLE_EQ(snapshot.getTimeoutRate(), 0.5);
+    ASSERT_DOUBLE_EQ(snapshot.getAverageHandleTime(), 150);
+}
+
+TEST_F(KpiTest, abandonedNotCountedAsTimeout){
+    kpi.onAnswer(0, 1000);
+    kpi.onAbandon(1000);
+    auto snapshot = kpi.get(Kpi::Window::m1, 1000);
+
+    EXPECT_EQ(snapshot.abandoned, 1);
+    EXPECT_EQ(snapshot.timedOut, 0);
+    ASSERT_DOUBLE_EQ(snapshot.getTimeoutRate(), 0);
+}
+
+TEST_F(KpiTest, oldEventsLeaveWindow){
+    kpi.onPush(CallStatus::ok, 1000);
+    kpi.onPush(CallStatus::ok, 1050);
+
+    EXPECT_EQ(kpi.get(Kpi::Window::m1, 1059).offered, 2);
+    EXPECT_EQ(kpi.get(Kpi::Window::m1, 1070).offered, 1);
+    EXPECT_EQ(kpi.get(Kpi::Window::h1, 1070).offered, 2);
+    ASSERT_EQ(kpi.get(Kpi::Window::m1, 2000).offered, 0);
+}
+
+TEST_F(KpiTest, reusedBucketIsReset){
+    kpi.onPush(CallStatus::ok, 1000);
+    kpi.onPush(CallStatus::ok, 1060);
+
+    ASSERT_EQ(kpi.get(Kpi::Window::m1, 1060).offered, 1);
+}
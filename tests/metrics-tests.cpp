@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../include/metrics.h"
+
+using namespace cdr;
+
+TEST(metrics, countersOfThreadsAreSummed){
+    Metrics metrics;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+        threads.emplace_back([&metrics]{
+            for (int i = 0; i < 1000; ++i)
+                metrics.onPush(CallStatus::ok);
+            metrics.onPush(CallStatus::overload);
+            metrics.onShed(3);
+        });
+    for (auto & thread : threads)
+        thread.join();
+    metrics.onPush(CallStatus::alreadyInQueue);
+
+    auto snapshot = metrics.collect();
+    ASSERT_EQ(snapshot.pushed[static_cast<size_t>(CallStatus::ok)], 4000);
+    ASSERT_EQ(snapshot.pushed[static_cast<size_t>(CallStatus::overload)], 4);
+    ASSERT_EQ(
+        snapshot.pushed[static_cast<size_t>(CallStatus::alreadyInQueue)], 1);
+    ASSERT_EQ(snapshot.pushed[static_cast<size_t>(CallStatus::timeout)], 0);
+    ASSERT_EQ(snapshot.shed, 12);
+}
+
+TEST(metrics, instancesAreSeparate){
+    Metrics a, b;
+    a.onPush(CallStatus::ok);
+    ASSERT_EQ(a.collect().pushed[0], 1);
+    ASSERT_EQ(b.collect().pushed[0], 0);
+}
+
+TEST(metrics, dispatcherGauges){
+    Metrics metrics;
+    std::thread([&metrics]{
+        auto & counters = metrics.local();
+        Metrics::add(counters.dispatcherIterations, 5);
+        counters.freeOperators = 2;
+        counters.servicedCalls = 8;
+    }).join();
+    auto snapshot = metrics.collect();
+    ASSERT_EQ(snapshot.dispatcherIterations, 5);
+    ASSERT_EQ(snapshot.freeOperators, 2);
+    ASSERT_EQ(snapshot.servicedCalls, 8);
+}
+
+TEST(metrics, prometheusFormat){
+    Metrics::Snapshot snapshot{};
+    snapshot.pushed[static_cast<size_t>(CallStatus::ok)] = 7;
+    snapshot.callQueueSize = 3;
+    snapshot.dispatcherIterations = 100;
+    snapshot.eventLogLost = 5;
+    auto text = Metrics::format(snapshot);
+    ASSERT_NE(text.find("# TYPE call_center_pushed_calls_total counter\n"),
+              std::string::npos);
+    ASSERT_NE(text.find("call_center_pushed_calls_total{status=\"ok\"} 7\n"),
+              std::string::npos);
+    ASSERT_NE(text.find(
+                  "call_center_pushed_calls_total{status=\"overload\"} 0\n"),
+              std::string::npos);
+    ASSERT_NE(text.find("# TYPE call_center_call_queue_size gauge\n"
+                        "call_center_call_queue_size 3\n"),
+              std::string::npos);
+    ASSERT_NE(text.find("call_center_dispatcher_iterations_total 100\n"),
+              std::string::npos);
+    ASSERT_NE(text.find("call_center_event_log_lost_total 5\n"),
+              std::string::npos);
+    ASSERT_EQ(text.back(), '\n');
+}
@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+#include "../include/overload-controller.h"
+
+TEST(overloadController, ratesOverCompleteSeconds){
+    OverloadController controller;
+    for (cdr::Seconds second = 100; second < 110; ++second){
+        controller.onArrival(4, second);
+        controller.onDeparture(second);
+        controller.onDeparture(second);
+    }
+    // Current second is not counted
+    controller.onArrival(100, 110);
+
+    EXPECT_DOUBLE_EQ(controller.getArrivalRate(110), 4);
+    ASSERT_DOUBLE_EQ(controller.getDrainRate(110), 2);
+}
+
+TEST(overloadController, oldSecondsForgotten){
+    OverloadController controller;
+    controller.onDeparture(100);
+    ASSERT_DOUBLE_EQ(controller.getDrainRate(100 + 2 * 16), 0);
+}
+
+TEST(overloadController, acceptWhileQueueNotFull){
+    OverloadController controller;
+    uint32_t retryAfter = 0;
+    ASSERT_FALSE(controller.shed(1, 9, 10, retryAfter, 100));
+    ASSERT_EQ(controller.get(100).shed, 0);
+}
+
+TEST(overloadController, disabled){
+    OverloadController controller;
+    controller.setEnabled(false);
+    uint32_t retryAfter = 0;
+    ASSERT_FALSE(controller.shed(1, 10, 10, retryAfter, 100));
+}
+
+TEST(overloadController, retryAfterFromDrainRate){
+    OverloadController controller;
+    for (cdr::Seconds second = 100; second < 110; ++second){
+        controller.onDeparture(second);
+        controller.onDeparture(second);
+    }
+    uint32_t retryAfter = 0;
+    // 5 places over limit at 2 calls/s
+    ASSERT_TRUE(controller.shed(1, 14, 10, retryAfter, 110));
+    EXPECT_EQ(retryAfter, 3);
+
+    // Arrivals 4 times faster than drain
+    for (cdr::Seconds second = 100; second < 110; ++second)
+        controller.onArrival(8, second);
+    ASSERT_TRUE(controller.shed(2, 14, 10, retryAfter, 110));
+    EXPECT_EQ(retryAfter, 10);
+    ASSERT_EQ(controller.get(110).shed, 3);
+}
+
+TEST(overloadController, retryAfterWithoutDrain){
+    OverloadController controller;
+    uint32_t retryAfter = 0;
+    ASSERT_TRUE(controller.shed(1, 10, 10, retryAfter, 100));
+    ASSERT_EQ(retryAfter, OverloadController::maxRetryAfter);
+}
@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+#include "../include/rand-generator.h"
+
+using namespace rndgen;
+
+// Reference implementation outputs
+TEST(randGenerator, xoshiroReference){
+    Xoshiro256 gen(std::array<uint64_t, 4>{1, 2, 3, 4});
+    const uint64_t expected[] = {11520, 0, 1509978240, 1215971899390074240,
+                                 1216172134540287360};
+    for (auto e : expected)
+        ASSERT_EQ(gen(), e);
+}
+
+TEST(randGenerator, splitmixSeeding){
+    Xoshiro256 gen(42);
+    const std::array<uint64_t, 4> expected{
+        13679457532755275413ull, 2949826092126892291ull,
+        5139283748462763858ull, 6349198060258255764ull};
+    ASSERT_EQ(gen.getState(), expected);
+}
+
+TEST(randGenerator, lanesAreJumpedStreams){
+    Xoshiro256 first(5);
+    Xoshiro256x4 batch(first);
+    std::vector<uint64_t> out(4 * 10 + 3);
+    // Odd sizes go through the buffered outputs
+    batch.fill(out.data(), 3);
+    batch.fill(out.data() + 3, 21);
+    batch.fill(out.data() + 24, out.size() - 24);
+
+    for (size_t lane = 0; lane < Xoshiro256x4::lanes; ++lane){
+        Xoshiro256 stream = first;
+        for (size_t i = 0; i < lane; ++i)
+            stream.jump();
+        for (size_t i = lane; i < out.size(); i += Xoshiro256x4::lanes)
+            ASSERT_EQ(out[i], stream()) << "lane " << lane << " i " << i;
+    }
+}
+
+TEST(randGenerator, sameSeedSameSequence){
+    setSeed(123);
+    ASSERT_EQ(getSeed(), 123);
+    std::vector<uint64_t> a(10), b(10);
+    for (auto & x : a)
+        x = next();
+    std::vector<uint32_t> batchA(100), batchB(100);
+    fillUniform(1, 1000, batchA.data(), batchA.size());
+
+    setSeed(123);
+    for (auto & x : b)
+        x = next();
+    fillUniform(1, 1000, batchB.data(), batchB.size());
+    ASSERT_EQ(a, b);
+    ASSERT_EQ(batchA, batchB);
+
+    setSeed(124);
+    ASSERT_NE(next(), a[0]);
+}
+
+TEST(randGenerator, randomSeed){
+    setSeed(0);
+    ASSERT_NE(getSeed(), 0);
+}
+
+TEST(randGenerator, threadsHaveOwnStreams){
+    setSeed(9);
+    const auto mine = next();
+    uint64_t other = 0;
+    std::thread([&other]{ other = next(); }).join();
+    ASSERT_NE(mine, other);
+}
+
+TEST(randGenerator, uniformInRange){
+    setSeed(1);
+    bool seenMin = false, seenMax = false;
+    for (int i = 0; i < 10000; ++i){
+        auto x = uniform(60, 70);
+        ASSERT_GE(x, 60);
+        ASSERT_LE(x, 70);
+        seenMin |= x == 60;
+        seenMax |= x == 70;
+    }
+    ASSERT_TRUE(seenMin && seenMax);
+    ASSERT_EQ(uniform(5, 5), 5);
+    // Full range doesn't overflow
+    uniform(0, UINT64_MAX);
+
+    for (int i = 0; i < 1000; ++i){
+        auto x = uniform01();
+        ASSERT_GE(x, 0.0);
+        ASSERT_LT(x, 1.0);
+    }
+}
+
+TEST(randGenerator, batchInRange){
+    setSeed(2);
+    std::vector<uint32_t> ints(1000);
+    fillUniform(10, 20, ints.data(), ints.size());
+    for (auto x : ints){
+        ASSERT_GE(x, 10);
+        ASSERT_LE(x, 20);
+    }
+    fillUniform(0, UINT32_MAX, ints.data(), ints.size());
+
+    std::vector<double> reals(1000);
+    fillUniform01(reals.data(), reals.size());
+    double sum = 0;
+    for (auto x : reals){
+        ASSERT_GE(x, 0.0);
+        ASSERT_LT(x, 1.0);
+        sum += x;
+    }
+    ASSERT_NEAR(sum / reals.size(), 0.5, 0.05);
+}
@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "../include/request-arena.h"
+#include "../include/http-router.h"
+
+// Every test starts with empty arena of the thread
+class RequestArenaTest : public ::testing::Test{
+protected:
+    void SetUp() override{
+        RequestArena::local().reset();
+    }
+};
+
+TEST_F(RequestArenaTest, allocatesFromBufferAndResets){
+    auto & arena = RequestArena::local();
+    arena.reset();
+    {
+        std::pmr::string s(100, 'x', arena.get());
+    }
+    auto stats = arena.getStats();
+    EXPECT_EQ(stats.allocations, 1);
+    EXPECT_GE(stats.bytes, 100);
+    EXPECT_EQ(stats.heapAllocations, 0);
+
+    arena.reset();
+    EXPECT_EQ(arena.getLastStats().allocations, 1);
+    ASSERT_EQ(arena.getStats().allocations, 0);
+}
+
+TEST_F(RequestArenaTest, largeRequestUsesHeap){
+    auto & arena = RequestArena::local();
+    arena.reset();
+    {
+        std::pmr::string s(RequestArena::bufferSize, 'x', arena.get());
+    }
+    EXPECT_EQ(arena.getStats().heapAllocations, 1);
+
+    arena.reset();
+    {
+        std::pmr::string s(100, 'x', arena.get());
+    }
+    ASSERT_EQ(arena.getStats().heapAllocations, 0);
+}
+
+TEST_F(RequestArenaTest, resetByRouterAfterHandler){
+    HttpRouter router;
+    router.get("/call", [](const httplib::Request &, httplib::Response &){
+        std::pmr::string body(200, 'x', RequestArena::local().get());
+    });
+    httplib::Request req;
+    req.method = "GET";
+    req.path = "/call";
+    httplib::Response res;
+    HttpRouter::StreamPoll stream;
+
+    ASSERT_TRUE(router.route(req, res, stream));
+    auto & arena = RequestArena::local();
+    EXPECT_EQ(arena.getLastStats().allocations, 1);
+    EXPECT_EQ(arena.getLastStats().heapAllocations, 0);
+    ASSERT_EQ(arena.getStats().allocations, 0);
+}
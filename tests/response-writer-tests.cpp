@@ -0,0 +1,47 @@
+#include <gtest/gtest.h>
+#include "../include/response-writer.h"
+#include "../external/json.hpp"
+
+using namespace cdr;
+
+static std::string dumpCallAnswer(uint64_t callId, CallStatus callStatus){
+    nlohmann::json ans;
+    ans["call_id"] = callId;
+    ans["call_status"] = toString(callStatus);
+    return ans.dump();
+}
+
+TEST(responseWriter, callAnswerIdenticalToJsonDump){
+    for (auto callStatus : {CallStatus::ok, CallStatus::overload,
+                            CallStatus::alreadyInQueue,
+                            CallStatus::callDuplication, CallStatus::timeout})
+        for (uint64_t callId : {uint64_t(0), uint64_t(1),
+                                uint64_t(370405383979663360), UINT64_MAX})
+            ASSERT_EQ(response::writeCallAnswer(callId, callStatus),
+                      dumpCallAnswer(callId, callStatus));
+}
+
+TEST(responseWriter, positionAnswerIdenticalToJsonDump){
+    for (uint64_t position : {uint64_t(1), uint64_t(12345), UINT64_MAX})
+        for (uint32_t wait : {uint32_t(0), uint32_t(60), UINT32_MAX}){
+            nlohmann::json ans;
+            ans["call_id"] = UINT64_MAX;
+            ans["call_status"] = "ok";
+            ans["position"] = position;
+            ans["estimated_wait"] = wait;
+            ASSERT_EQ(response::writeCallAnswer(UINT64_MAX, CallStatus::ok,
+                                                position, wait),
+                      ans.dump());
+            ans.erase("call_status");
+            ASSERT_EQ(response::writePositionAnswer(UINT64_MAX, position,
+                                                    wait),
+                      ans.dump());
+        }
+}
+
+TEST(responseWriter, statusNamesMatchToString){
+    for (auto callStatus : {CallStatus::ok, CallStatus::overload,
+                            CallStatus::alreadyInQueue,
+                            CallStatus::callDuplication, CallStatus::timeout})
+        ASSERT_EQ(statusName(callStatus), toString(callStatus));
+}
@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+#include "../include/schedule.h"
+
+namespace{
+
+Schedule::Window window(const uint32_t begin, const uint32_t end){
+    Schedule::Window w{};
+    w.begin = begin;
+    w.end = end;
+    return w;
+}
+
+}
+
+TEST(schedule, parseTime){
+    uint32_t t = 0;
+    EXPECT_TRUE(Schedule::parseTime("08:30", t));
+    EXPECT_EQ(t, 8 * 3600 + 30 * 60);
+    EXPECT_TRUE(Schedule::parseTime("23:59:59", t));
+    EXPECT_EQ(t, Schedule::secondsPerDay - 1);
+    EXPECT_FALSE(Schedule::parseTime("24:00", t));
+    EXPECT_FALSE(Schedule::parseTime("08:60", t));
+    EXPECT_FALSE(Schedule::parseTime("08:30x", t));
+    ASSERT_FALSE(Schedule::parseTime("8", t));
+}
+
+TEST(schedule, formatTime){
+    EXPECT_EQ(Schedule::formatTime(8 * 3600 + 30 * 60), "08:30");
+    ASSERT_EQ(Schedule::formatTime(Schedule::secondsPerDay - 1), "23:59:59");
+}
+
+TEST(schedule, invalidWindow){
+    Schedule schedule;
+    EXPECT_FALSE(schedule.add(window(3600, 3600)));
+    EXPECT_FALSE(schedule.add(window(0, Schedule::secondsPerDay)));
+    ASSERT_TRUE(schedule.isEmpty());
+}
+
+TEST(schedule, firstWindowWins){
+    Schedule schedule;
+    schedule.add(window(9 * 3600, 18 * 3600));
+    schedule.add(window(12 * 3600, 13 * 3600));
+
+    EXPECT_EQ(schedule.find(8 * 3600), Schedule::noWindow);
+    EXPECT_EQ(schedule.find(9 * 3600), 0);
+    EXPECT_EQ(schedule.find(12 * 3600), 0);
+    ASSERT_EQ(schedule.find(18 * 3600), Schedule::noWindow);
+}
+
+TEST(schedule, windowCrossingMidnight){
+    Schedule schedule;
+    schedule.add(window(22 * 3600, 6 * 3600));
+
+    EXPECT_EQ(schedule.find(23 * 3600), 0);
+    EXPECT_EQ(schedule.find(0), 0);
+    EXPECT_EQ(schedule.find(5 * 3600), 0);
+    ASSERT_EQ(schedule.find(6 * 3600), Schedule::noWindow);
+}
+
+TEST(schedule, secondsToBoundary){
+    Schedule schedule;
+    EXPECT_EQ(schedule.secondsToBoundary(0), Schedule::secondsPerDay);
+
+    schedule.add(window(9 * 3600, 18 * 3600));
+    EXPECT_EQ(schedule.secondsToBoundary(8 * 3600), 3600);
+    EXPECT_EQ(schedule.secondsToBoundary(17 * 3600), 3600);
+    // Boundary reached: the next one
+    EXPECT_EQ(schedule.secondsToBoundary(9 * 3600), 9 * 3600);
+    // Through midnight
+    ASSERT_EQ(schedule.secondsToBoundary(20 * 3600), 13 * 3600);
+}
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "../include/sip-parser.h"
+
+namespace{
+
+const std::string invite =
+    "INVITE sip:operator@call-center SIP/2.0\r\n"
+    "Via: SIP/2.0/UDP 10.0.0.1:5060;branch=z9hG4bK1\r\n"
+    "Via: SIP/2.0/UDP 10.0.0.2:5060;branch=z9hG4bK2\r\n"
+    "From: \"Ivan\" <sip:79990000001@10.0.0.1>;tag=abc\r\n"
+    "To: <sip:operator@call-center>\r\n"
+    "Call-ID: 12345@10.0.0.1\r\n"
+    "CSeq: 1 INVITE\r\n"
+    "Content-Length: 0\r\n"
+    "\r\n";
+
+};
+
+TEST(sipParser, parseInvite){
+    sip::Request request;
+    ASSERT_TRUE(sip::parseRequest(invite, request));
+    EXPECT_EQ(request.method, "INVITE");
+    ASSERT_EQ(request.nVias, 2);
+    EXPECT_EQ(request.vias[1], "SIP/2.0/UDP 10.0.0.2:5060;branch=z9hG4bK2");
+    EXPECT_EQ(request.callId, "12345@10.0.0.1");
+    EXPECT_EQ(request.cseq, "1 INVITE");
+    ASSERT_EQ(request.fromUser, "79990000001");
+}
+
+TEST(sipParser, fieldsPointIntoDatagram){
+    sip::Request request;
+    ASSERT_TRUE(sip::parseRequest(invite, request));
+    ASSERT_GE(request.fromUser.data(), invite.data());
+    ASSERT_LT(request.fromUser.data(), invite.data() + invite.size());
+}
+
+TEST(sipParser, compactHeaders){
+    std::string compact =
+        "INVITE sip:operator@call-center SIP/2.0\r\n"
+        "v: SIP/2.0/UDP 10.0.0.1:5060;branch=z9hG4bK1\r\n"
+        "f: tel:+79990000001;tag=1\r\n"
+        "t: <sip:operator@call-center>\r\n"
+        "i: 1@10.0.0.1\r\n"
+        "CSeq: 1 INVITE\r\n"
+        "\r\n";
+    sip::Request request;
+    ASSERT_TRUE(sip::parseRequest(compact, request));
+    EXPECT_EQ(request.callId, "1@10.0.0.1");
+    ASSERT_EQ(request.fromUser, "+79990000001");
+}
+
+TEST(sipParser, missingCallIdInvalid){
+    std::string noCallId =
+        "INVITE sip:operator@call-center SIP/2.0\r\n"
+        "Via: SIP/2.0/UDP 10.0.0.1:5060;branch=z9hG4bK1\r\n"
+        "From: <sip:1@10.0.0.1>\r\n"
+        "To: <sip:operator@call-center>\r\n"
+        "CSeq: 1 INVITE\r\n"
+        "\r\n";
+    sip::Request request;
+    EXPECT_FALSE(sip::parseRequest(noCallId, request));
+    ASSERT_FALSE(sip::parseRequest("HTTP/1.1 200 OK\r\n\r\n", request));
+}
+
+TEST(sipParser, parseUser){
+    EXPECT_EQ(sip::parseUser("<sip:100@host>;tag=1"), "100");
+    EXPECT_EQ(sip::parseUser("\"sip:fake@x\" <sips:200@host;user=phone>"),
+              "200");
+    EXPECT_EQ(sip::parseUser("sip:300@host;tag=1"), "300");
+    ASSERT_EQ(sip::parseUser("<mailto:400@host>"), "");
+}
+
+TEST(sipParser, writeResponse){
+    sip::Request request;
+    ASSERT_TRUE(sip::parseRequest(invite, request));
+    std::string buffer(invite.size() + sip::maxResponseOverhead, '\0');
+    auto end = sip::writeResponse(buffer.data(), request, 180, "Ringing",
+                                  0xabc);
+    ASSERT_EQ(std::string(buffer.data(), end),
+              "SIP/2.0 180 Ringing\r\n"
+              "Via: SIP/2.0/UDP 10.0.0.1:5060;branch=z9hG4bK1\r\n"
+              "Via: SIP/2.0/UDP 10.0.0.2:5060;branch=z9hG4bK2\r\n"
+              "From: \"Ivan\" <sip:79990000001@10.0.0.1>;tag=abc\r\n"
+              "To: <sip:operator@call-center>;tag=abc\r\n"
+              "Call-ID: 12345@10.0.0.1\r\n"
+              "CSeq: 1 INVITE\r\n"
+              "Content-Length: 0\r\n"
+              "\r\n");
+}
+
+TEST(sipParser, writeRetryAfter){
+    sip::Request request;
+    ASSERT_TRUE(sip::parseRequest(invite, request));
+    std::string buffer(invite.size() + sip::maxResponseOverhead, '\0');
+    auto end = sip::writeResponse(buffer.data(), request, 503,
+                                  "Service Unavailable", 1, 5);
+    std::string response(buffer.data(), end);
+    EXPECT_EQ(response.find("SIP/2.0 503 Service Unavailable\r\n"), 0);
+    ASSERT_NE(response.find("\r\nRetry-After: 5\r\n"), std::string::npos);
+}
@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "../include/sip-transactions.h"
+
+namespace{
+
+std::string invite(const std::string & callId, const int cseq){
+    return "INVITE sip:operator@call-center SIP/2.0\r\n"
+        "Via: SIP/2.0/UDP 10.0.0.1:5060;branch=z9hG4bK1\r\n"
+        "From: <sip:79990000001@10.0.0.1>;tag=abc\r\n"
+        "To: <sip:operator@call-center>\r\n"
+        "Call-ID: " + callId + "\r\n"
+        "CSeq: " + std::to_string(cseq) + " INVITE\r\n"
+        "\r\n";
+}
+
+uint64_t key(const std::string & datagram){
+    sip::Request request;
+    EXPECT_TRUE(sip::parseRequest(datagram, request));
+    return sip::Transactions::key(request);
+}
+
+};
+
+TEST(sipTransactions, key){
+    // Retransmission is a copy of the datagram
+    ASSERT_EQ(key(invite("1@host", 1)), key(invite("1@host", 1)));
+    ASSERT_NE(key(invite("1@host", 1)), key(invite("2@host", 1)));
+    // New transaction of the same call
+    ASSERT_NE(key(invite("1@host", 1)), key(invite("1@host", 2)));
+}
+
+TEST(sipTransactions, retransmissionGetsAnswer){
+    sip::Transactions transactions(16);
+    const auto k = key(invite("1@host", 1));
+    ASSERT_EQ(transactions.find(k, 100), nullptr);
+    transactions.add(k, {180, 42, 0}, 100);
+    auto answer = transactions.find(k, 101);
+    ASSERT_NE(answer, nullptr);
+    EXPECT_EQ(answer->code, 180);
+    EXPECT_EQ(answer->tag, 42);
+
+    // The first answer is kept
+    transactions.add(k, {486, 43, 0}, 102);
+    EXPECT_EQ(transactions.find(k, 102)->code, 180);
+    EXPECT_EQ(sip::reason(180), "Ringing");
+    EXPECT_EQ(sip::reason(486), "Busy Here");
+    EXPECT_EQ(sip::reason(503), "Service Unavailable");
+}
+
+TEST(sipTransactions, expire){
+    sip::Transactions transactions(16);
+    transactions.add(1, {180, 1, 0}, 100);
+    transactions.add(2, {503, 0, 5}, 110);
+    ASSERT_NE(transactions.find(1, 100 + sip::Transactions::lifetime - 1),
+              nullptr);
+    ASSERT_EQ(transactions.find(1, 100 + sip::Transactions::lifetime),
+              nullptr);
+    ASSERT_EQ(transactions.size(), 1);
+    ASSERT_EQ(transactions.find(2, 120)->retryAfter, 5);
+}
+
+TEST(sipTransactions, oldestDroppedAboveMaxSize){
+    sip::Transactions transactions(2);
+    transactions.add(1, {180, 1, 0}, 100);
+    transactions.add(2, {180, 2, 0}, 100);
+    transactions.add(3, {180, 3, 0}, 100);
+    ASSERT_EQ(transactions.size(), 2);
+    ASSERT_EQ(transactions.find(1, 100), nullptr);
+    ASSERT_NE(transactions.find(2, 100), nullptr);
+    ASSERT_NE(transactions.find(3, 100), nullptr);
+}
@@ -1,5 +1,9 @@
 #include <gtest/gtest.h>
 
+#include "easylogging++.h"
+
+INITIALIZE_EASYLOGGINGPP
+
 int main(int argc, char** argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
@@ -122,10 +122,140 @@ TEST_F(UniqueQueueTest, eraseNotExistedElement){
     ASSERT_EQ(queue.getSize(), 2);
 }
 
+TEST_F(UniqueQueueTest, eraseReturnsElement){
+    entity1.data = 7;
+    queue.push(entity1);
+    Type erased;
+
+    ASSERT_TRUE(queue.erase(entity1.id, &erased));
+    EXPECT_EQ(erased.data, 7);
+    ASSERT_TRUE(queue.isEmpty());
+}
+
+TEST_F(UniqueQueueTest, eraseIfPredicateFalse){
+    entity1.data = 7;
+    queue.push(entity1);
+
+    ASSERT_FALSE(queue.eraseIf(entity1.id,
+                               [](const Type & t){ return t.data == 8; }));
+    ASSERT_TRUE(queue.isInQueue(entity1.id));
+    ASSERT_TRUE(queue.eraseIf(entity1.id,
+                              [](const Type & t){ return t.data == 7; }));
+    ASSERT_FALSE(queue.isInQueue(entity1.id));
+}
+
+TEST_F(UniqueQueueTest, positionAfterPushAndErase){
+    queue.setMaxSize(10);
+    size_t position;
+    queue.push(entity1);
+    queue.push(entity2);
+    queue.push(entity3, nullptr, &position);
+    EXPECT_EQ(position, 3);
+
+    queue.erase(entity2.id);
+    ASSERT_TRUE(queue.getPosition(entity3.id, position));
+    EXPECT_EQ(position, 2);
+    queue.pop();
+    ASSERT_TRUE(queue.getPosition(entity3.id, position));
+    EXPECT_EQ(position, 1);
+    ASSERT_FALSE(queue.getPosition(entity1.id, position));
+}
+
+TEST_F(UniqueQueueTest, positionAfterReindex){
+    queue.setMaxSize(3);
+    queue.push(entity1);
+    // Pushes and erases run out of indexes many times
+    for (int i = 0; i < 1000; ++i){
+        entity2.data = i;
+        queue.push(entity2);
+        queue.push(entity3);
+        queue.erase(entity2.id);
+        queue.erase(entity3.id);
+    }
+    queue.push(entity2);
+    queue.push(entity3);
+    size_t position;
+
+    ASSERT_TRUE(queue.getPosition(entity1.id, position));
+    EXPECT_EQ(position, 1);
+    ASSERT_TRUE(queue.getPositionIf(entity3.id,
+                                    [](const Type &){ return true; },
+                                    position));
+    ASSERT_EQ(position, 3);
+}
+
+TEST_F(UniqueQueueTest, pushBulk){
+    std::vector<UniqueQueue<Type>::EC> ecs;
+    queue.push({entity1, entity1, entity2, entity3}, ecs);
+
+    ASSERT_EQ(ecs.size(), 4);
+    EXPECT_EQ(ecs[0], UniqueQueue<Type>::EC::inserted);
+    EXPECT_EQ(ecs[1], UniqueQueue<Type>::EC::alreadyInQueue);
+    EXPECT_EQ(ecs[2], UniqueQueue<Type>::EC::inserted);
+    EXPECT_EQ(ecs[3], UniqueQueue<Type>::EC::overload);
+    ASSERT_EQ(queue.getSize(), 2);
+}
+
+TEST_F(UniqueQueueTest, pushBulkReassigned){
+    queue.setRejectRepeated(false);
+    queue.setMaxSize(3);
+    entity1.data = 7;
+    queue.push(entity1);
+    entity1.data = 8;
+    std::vector<UniqueQueue<Type>::EC> ecs;
+    std::vector<Type> replaced;
+    queue.push({entity2, entity1}, ecs, &replaced);
+
+    EXPECT_EQ(ecs[1], UniqueQueue<Type>::EC::reassigned);
+    EXPECT_EQ(replaced[1].data, 7);
+    ASSERT_EQ(queue.top().id, entity2.id);
+}
+
+TEST_F(UniqueQueueTest, pushReassignedReturnsReplaced){
+    queue.setRejectRepeated(false);
+    entity1.data = 7;
+    queue.push(entity1);
+    entity1.data = 8;
+    Type replaced;
+
+    EXPECT_EQ(queue.push(entity1, &replaced), UniqueQueue<Type>::EC::reassigned);
+    ASSERT_EQ(replaced.data, 7);
+}
+
 
 TEST(cdr, cdrIdEqToPhoneNumber){
     Cdr cdr;
     cdr.phoneNumber = "12345";
 
     ASSERT_EQ(cdr.phoneNumber, cdr.getId());
-}
\ No newline at end of file
+}
+TEST(cdr, phoneNumberTooLongRejected){
+    Cdr cdr;
+    cdr.phoneNumber = "12345";
+
+    ASSERT_FALSE(cdr.phoneNumber.assign(
+        std::string(PhoneNumber::capacity + 1, '1')));
+    ASSERT_EQ(cdr.phoneNumber.view(), "12345");
+}
+
+TEST(cdr, phoneNumberTooLongAssignment){
+    Cdr cdr;
+    cdr.phoneNumber = "12345";
+
+    EXPECT_DEBUG_DEATH(
+        cdr.phoneNumber = std::string(PhoneNumber::capacity + 1, '1'), "");
+    ASSERT_EQ(cdr.phoneNumber.view(), "12345");
+}
+
+TEST(cdr, phoneNumberAsQueueId){
+    UniqueQueue<Cdr> queue;
+    queue.setMaxSize(2);
+    Cdr cdr;
+    cdr.phoneNumber = "12345";
+    queue.push(cdr);
+
+    cdr.phoneNumber = "123";
+    ASSERT_FALSE(queue.isInQueue(cdr.getId()));
+    cdr.phoneNumber = "12345";
+    ASSERT_TRUE(queue.isInQueue(cdr.getId()));
+}
@@ -0,0 +1,91 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+
+#include "event-log.h"
+
+// Prints binary call event log as text or JSON lines.
+// Usage: event-log-decode [--json] [--call-id id] [--operator id]
+//                         [--type type] file
+// file "-" - standard input. Filters are combined.
+
+namespace{
+
+struct Filter{
+    bool byCallId = false;
+    uint64_t callId = 0;
+    bool byOperator = false;
+    uint32_t operatorId = 0;
+    bool byType = false;
+    uint8_t type = 0;
+
+    // Lost records are kept by call id filter, events of the call
+    // may be in the gap
+    bool matches(const EventLog::Record & record) const{
+        return (!byCallId || record.callId == callId ||
+                record.type == EventLog::lostType) &&
+            (!byOperator || record.operatorId == operatorId) &&
+            (!byType || record.type == type);
+    }
+};
+
+void usage(const char * name){
+    fprintf(stderr, "Usage: %s [--json] [--call-id id] [--operator id] "
+                    "[--type type] file\n", name);
+}
+
+};
+
+int main(int argc, char * argv[]){
+    bool json = false;
+    Filter filter;
+    std::string path;
+    for (int i = 1; i < argc; ++i){
+        const bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--json") == 0)
+            json = true;
+        else if (strcmp(argv[i], "--call-id") == 0 && hasValue){
+            filter.byCallId = true;
+            filter.callId = strtoull(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--operator") == 0 && hasValue){
+            filter.byOperator = true;
+            filter.operatorId = strtoul(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--type") == 0 && hasValue){
+            filter.byType = true;
+            if (!EventLog::parseType(argv[++i], filter.type)){
+                fprintf(stderr, "Unknown type: %s\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (path.empty() && (argv[i][0] != '-' || argv[i][1] == '\0'))
+            path = argv[i];
+        else{
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (path.empty()){
+        usage(argv[0]);
+        return 1;
+    }
+
+    EventLog::Reader reader;
+    if (!reader.open(path)){
+        fprintf(stderr, "Can't read event log: %s\n", path.c_str());
+        return 2;
+    }
+    EventLog::Record record;
+    while (reader.next(record)){
+        if (!filter.matches(record))
+            continue;
+        const auto line = json ? EventLog::toJson(record) :
+                                 EventLog::toText(record);
+        fwrite(line.data(), 1, line.size(), stdout);
+        fputc('\n', stdout);
+    }
+    return 0;
+}